@@ -306,7 +306,7 @@ void MainWindow::processReceivedFrames()
         const QString flags = frameFlags(frame);
 
         const QString id = QString::number(frame.frameId(), 16);
-        const QString dlc = QString::number(frame.payload().size());
+        const QString dlc = QString::number(frame.payloadView().size());
 
         m_model->appendFrame(QStringList({QString::number(m_numberFramesReceived), time, flags, id, dlc, data}));
     }
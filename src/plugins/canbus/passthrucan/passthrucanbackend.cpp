@@ -110,7 +110,10 @@ PassThruCanBackend::PassThruCanBackend(const QString &name, QObject *parent)
     connect(m_canIO, &PassThruCanIO::messagesReceived,
             this, &PassThruCanBackend::enqueueReceivedFrames);
     connect(m_canIO, &PassThruCanIO::messagesSent,
-            this, &QCanBusDevice::framesWritten);
+            this, [this](qint64 count, qint64 payloadBytes) {
+        recordWrittenFrames(count, payloadBytes);
+        emit framesWritten(count);
+    });
 }
 
 PassThruCanBackend::~PassThruCanBackend()
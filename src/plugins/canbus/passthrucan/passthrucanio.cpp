@@ -223,7 +223,7 @@ bool PassThruCanIO::writeMessages()
             const QCanBusFrame &frame = m_writeQueue.at(i);
             J2534::Message &msg = m_ioBuffer[i];
 
-            const QByteArray payload = frame.payload();
+            const QByteArrayView payload = frame.payloadView();
             const ulong payloadSize = qMin<ulong>(payload.size(),
                                                   J2534::Message::maxSize - 4);
             msg.setRxStatus({});
@@ -257,13 +257,16 @@ bool PassThruCanIO::writeMessages()
         return false;
 
     bool morePending;
+    qint64 payloadBytes = 0;
     {
         const QMutexLocker lock (&m_writeGuard);
+        for (ulong i = 0; i < numMsgs; ++i)
+            payloadBytes += m_writeQueue.at(i).payloadView().size();
         // De-queue successfully written frames.
         m_writeQueue.erase(m_writeQueue.begin(), m_writeQueue.begin() + numMsgs);
         morePending = !m_writeQueue.isEmpty();
     }
-    emit messagesSent(numMsgs);
+    emit messagesSent(numMsgs, payloadBytes);
 
     return morePending;
 }
@@ -300,9 +303,9 @@ void PassThruCanIO::readMessages(bool writePending)
             continue;
         }
         const QCanBusFrame::FrameId msgId = qFromBigEndian<QCanBusFrame::FrameId>(msg.data());
-        const QByteArray payload (msg.data() + 4, msg.size() - 4);
-
-        QCanBusFrame frame (msgId, payload);
+        QCanBusFrame frame;
+        frame.setFrameId(msgId);
+        frame.setPayload(msg.data() + 4, msg.size() - 4);
         frame.setExtendedFrameFormat((msg.rxStatus() & J2534::Message::InCAN29BitID) != 0);
         frame.setLocalEcho((msg.rxStatus() & J2534::Message::InTxMsgType) != 0);
         frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(msg.timestamp()));
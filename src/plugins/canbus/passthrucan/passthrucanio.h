@@ -72,7 +72,7 @@ public:
 Q_SIGNALS:
     void errorOccurred(const QString &description, QCanBusDevice::CanBusError error);
     void messagesReceived(QList<QCanBusFrame> frames);
-    void messagesSent(qint64 count);
+    void messagesSent(qint64 count, qint64 payloadBytes);
     void openFinished(bool success);
     void closeFinished();
 
@@ -428,7 +428,7 @@ bool PeakCanBackendPrivate::open()
     const int nominalBitrate = q->configurationParameter(QCanBusDevice::BitRateKey).toInt();
     TPCANStatus st = PCAN_ERROR_OK;
 
-    if (isFlexibleDatarateEnabled) {
+    if (isFlexibleDatarateEnabled.loadRelaxed()) {
         const int dataBitrate = q->configurationParameter(QCanBusDevice::DataBitRateKey).toInt();
         const QByteArray bitrateStr = bitrateStringFromBitrate(nominalBitrate, dataBitrate);
         st = ::CAN_InitializeFD(channelIndex, const_cast<char *>(bitrateStr.data()));
@@ -477,8 +477,12 @@ bool PeakCanBackendPrivate::open()
     writeNotifier = new PeakCanWriteNotifier(this, q);
     writeNotifier->setInterval(0);
 
-    readNotifier = new PeakCanReadNotifier(this, q);
+    QThread *ioThread = q->startIoThread();
+    readNotifier = new PeakCanReadNotifier(this, ioThread ? nullptr : q);
     readNotifier->setEnabled(true);
+    // Moving an enabled notifier re-enables it in the I/O thread.
+    if (ioThread)
+        readNotifier->moveToThread(ioThread);
 
     isOpen = true;
     return true;
@@ -488,7 +492,13 @@ void PeakCanBackendPrivate::close()
 {
     Q_Q(PeakCanBackend);
 
-    delete readNotifier;
+    if (readNotifier && readNotifier->thread() != q->thread()) {
+        // Deleted by the I/O thread when it finishes.
+        readNotifier->deleteLater();
+        q->stopIoThread();
+    } else {
+        delete readNotifier;
+    }
     readNotifier = nullptr;
 
     delete writeNotifier;
@@ -530,10 +540,12 @@ bool PeakCanBackendPrivate::setConfigurationParameter(QCanBusDevice::Configurati
     Q_Q(PeakCanBackend);
 
     switch (key) {
+    case QCanBusDevice::RawFilterKey:
+        return true;
     case QCanBusDevice::BitRateKey:
         return verifyBitRate(value.toInt());
     case QCanBusDevice::CanFdKey:
-        isFlexibleDatarateEnabled = value.toBool();
+        isFlexibleDatarateEnabled.storeRelaxed(value.toBool());
         return true;
     case QCanBusDevice::DataBitRateKey: {
         const int dataBitrate = value.toInt();
@@ -652,21 +664,12 @@ static int dlcToSize(CanFrameDlc dlc)
     return 0;
 }
 
-void PeakCanBackendPrivate::startWrite()
+TPCANStatus PeakCanBackendPrivate::writeMessage(const QCanBusFrame &frame)
 {
-    Q_Q(PeakCanBackend);
-
-    if (!q->hasOutgoingFrames()) {
-        writeNotifier->stop();
-        return;
-    }
-
-    const QCanBusFrame frame = q->dequeueOutgoingFrame();
-    const QByteArray payload = frame.payload();
+    const QByteArrayView payload = frame.payloadView();
     const qsizetype payloadSize = payload.size();
-    TPCANStatus st = PCAN_ERROR_OK;
 
-    if (isFlexibleDatarateEnabled) {
+    if (isFlexibleDatarateEnabled.loadRelaxed()) {
         TPCANMsgFD message = {};
         message.ID = frame.frameId();
         message.DLC = sizeToDlc(payloadSize);
@@ -682,46 +685,83 @@ void PeakCanBackendPrivate::startWrite()
             message.MSGTYPE |= PCAN_MESSAGE_RTR; // we do not care about the payload
         else
             ::memcpy(message.DATA, payload.constData(), payloadSize);
-        st = ::CAN_WriteFD(channelIndex, &message);
-    } else if (frame.hasFlexibleDataRateFormat()) {
-        const char errorString[] = "Cannot send CAN FD frame format as CAN FD is not enabled.";
-        qCWarning(QT_CANBUS_PLUGINS_PEAKCAN(), errorString);
-        q->setError(PeakCanBackend::tr(errorString), QCanBusDevice::WriteError);
-    } else {
-        TPCANMsg message = {};
-        message.ID = frame.frameId();
-        message.LEN = static_cast<quint8>(payloadSize);
-        message.MSGTYPE = frame.hasExtendedFrameFormat() ? PCAN_MESSAGE_EXTENDED
-                                                         : PCAN_MESSAGE_STANDARD;
+        return ::CAN_WriteFD(channelIndex, &message);
+    }
 
-        if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
-            message.MSGTYPE |= PCAN_MESSAGE_RTR; // we do not care about the payload
-        else
-            ::memcpy(message.DATA, payload.constData(), payloadSize);
-        st = ::CAN_Write(channelIndex, &message);
+    TPCANMsg message = {};
+    message.ID = frame.frameId();
+    message.LEN = static_cast<quint8>(payloadSize);
+    message.MSGTYPE = frame.hasExtendedFrameFormat() ? PCAN_MESSAGE_EXTENDED
+                                                     : PCAN_MESSAGE_STANDARD;
+
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
+        message.MSGTYPE |= PCAN_MESSAGE_RTR; // we do not care about the payload
+    else
+        ::memcpy(message.DATA, payload.constData(), payloadSize);
+    return ::CAN_Write(channelIndex, &message);
+}
+
+void PeakCanBackendPrivate::startWrite()
+{
+    Q_Q(PeakCanBackend);
+
+    if (!q->hasOutgoingFrames()) {
+        writeNotifier->stop();
+        return;
     }
 
-    if (Q_UNLIKELY(st != PCAN_ERROR_OK)) {
-        const QString errorString = systemErrorString(st);
-        qCWarning(QT_CANBUS_PLUGINS_PEAKCAN, "Cannot write frame: %ls",
-                  qUtf16Printable(errorString));
-        q->setError(errorString, QCanBusDevice::WriteError);
-    } else {
-        emit q->framesWritten(qint64(1));
+    // Write queued frames until the driver's transmit queue is full. PCAN-Basic
+    // has no call for several messages, but one timer event now drains the queue.
+    QCanBusFrame frame;
+    qint64 framesWritten = 0;
+    qint64 payloadBytes = 0;
+    bool transmitQueueFull = false;
+
+    while (q->peekOutgoingFrames(&frame, 1) == 1) {
+        if (!isFlexibleDatarateEnabled.loadRelaxed() && frame.hasFlexibleDataRateFormat()) {
+            q->discardOutgoingFrames(1);
+            const char errorString[] = "Cannot send CAN FD frame format as CAN FD is not enabled.";
+            qCWarning(QT_CANBUS_PLUGINS_PEAKCAN(), errorString);
+            q->setError(PeakCanBackend::tr(errorString), QCanBusDevice::WriteError);
+            continue;
+        }
+
+        const TPCANStatus st = writeMessage(frame);
+        if (st == PCAN_ERROR_QXMTFULL) {
+            transmitQueueFull = true;
+            break;
+        }
+
+        q->discardOutgoingFrames(1);
+        if (Q_UNLIKELY(st != PCAN_ERROR_OK)) {
+            const QString errorString = systemErrorString(st);
+            qCWarning(QT_CANBUS_PLUGINS_PEAKCAN, "Cannot write frame: %ls",
+                      qUtf16Printable(errorString));
+            q->setError(errorString, QCanBusDevice::WriteError);
+            break;
+        }
+        ++framesWritten;
+        payloadBytes += frame.payloadView().size();
+    }
+
+    if (framesWritten > 0) {
+        q->recordWrittenFrames(framesWritten, payloadBytes);
+        emit q->framesWritten(framesWritten);
     }
 
-    if (q->hasOutgoingFrames() && !writeNotifier->isActive())
-        writeNotifier->start();
+    // Poll less eagerly while waiting for the driver to make room in its queue
+    if (q->hasOutgoingFrames())
+        writeNotifier->start(transmitQueueFull ? 1 : 0);
 }
 
 void PeakCanBackendPrivate::startRead()
 {
     Q_Q(PeakCanBackend);
 
-    QList<QCanBusFrame> newFrames;
+    QList<QCanBusFrame> &newFrames = receivedFrames;
 
     for (;;) {
-        if (isFlexibleDatarateEnabled) {
+        if (isFlexibleDatarateEnabled.loadRelaxed()) {
             TPCANMsgFD message = {};
             TPCANTimestampFD timestamp = {};
 
@@ -738,8 +778,9 @@ void PeakCanBackendPrivate::startRead()
                 continue;
 
             const int size = dlcToSize(static_cast<CanFrameDlc>(message.DLC));
-            QCanBusFrame frame(TPCANLongToFrameID(message.ID),
-                               QByteArray(reinterpret_cast<const char *>(message.DATA), size));
+            QCanBusFrame frame;
+            frame.setFrameId(TPCANLongToFrameID(message.ID));
+            frame.setPayload(reinterpret_cast<const char *>(message.DATA), size);
             frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(static_cast<qint64>(timestamp)));
             frame.setExtendedFrameFormat(message.MSGTYPE & PCAN_MESSAGE_EXTENDED);
             frame.setFrameType((message.MSGTYPE & PCAN_MESSAGE_RTR)
@@ -766,8 +807,9 @@ void PeakCanBackendPrivate::startRead()
                 continue;
 
             const int size = static_cast<int>(message.LEN);
-            QCanBusFrame frame(TPCANLongToFrameID(message.ID),
-                               QByteArray(reinterpret_cast<const char *>(message.DATA), size));
+            QCanBusFrame frame;
+            frame.setFrameId(TPCANLongToFrameID(message.ID));
+            frame.setPayload(reinterpret_cast<const char *>(message.DATA), size);
             const quint64 millis = timestamp.millis + Q_UINT64_C(0xFFFFFFFF) * timestamp.millis_overflow;
             const quint64 micros = Q_UINT64_C(1000) * millis + timestamp.micros;
             frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(static_cast<qint64>(micros)));
@@ -780,6 +822,7 @@ void PeakCanBackendPrivate::startRead()
     }
 
     q->enqueueReceivedFrames(newFrames);
+    newFrames.clear(); // keeps the capacity for the next call
 }
 
 bool PeakCanBackendPrivate::verifyBitRate(int bitrate)
@@ -816,6 +859,8 @@ PeakCanBackend::PeakCanBackend(const QString &name, QObject *parent)
 
     d->setupChannel(name.toLatin1());
     d->setupDefaultConfigurations();
+    // The driver cannot filter, so RawFilterKey is matched in enqueueReceivedFrames()
+    setSoftwareFilterEnabled(true);
 }
 
 PeakCanBackend::~PeakCanBackend()
@@ -894,7 +939,7 @@ bool PeakCanBackend::writeFrame(const QCanBusFrame &newData)
     enqueueOutgoingFrame(newData);
 
     if (!d->writeNotifier->isActive())
-        d->writeNotifier->start();
+        d->writeNotifier->start(0);
 
     return true;
 }
@@ -41,6 +41,8 @@
 #include "peakcanbackend.h"
 #include "peakcan_symbols_p.h"
 
+#include <QtCore/qatomic.h>
+
 #if defined(Q_OS_WIN32)
 #  include <qt_windows.h>
 #else
@@ -76,16 +78,20 @@ public:
     void setupChannel(const QByteArray &interfaceName);
     void setupDefaultConfigurations();
     QString systemErrorString(TPCANStatus errorCode);
+    TPCANStatus writeMessage(const QCanBusFrame &frame);
     void startWrite();
     void startRead();
     bool verifyBitRate(int bitrate);
 
     PeakCanBackend * const q_ptr;
 
-    bool isFlexibleDatarateEnabled = false;
+    // Read by startRead() in the I/O thread
+    QAtomicInteger<bool> isFlexibleDatarateEnabled = false;
     bool isOpen = false;
     TPCANHandle channelIndex = PCAN_NONEBUS;
     QTimer *writeNotifier = nullptr;
+    // Reused by startRead(), PCAN-Basic has no API to read several messages at once
+    QList<QCanBusFrame> receivedFrames;
 
 #if defined(Q_OS_WIN32)
     QWinEventNotifier *readNotifier = nullptr;
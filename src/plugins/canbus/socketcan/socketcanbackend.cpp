@@ -43,18 +43,22 @@
 #include <QtCore/qdatastream.h>
 #include <QtCore/qdebug.h>
 #include <QtCore/qdiriterator.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qfile.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qsocketnotifier.h>
 
 #include <linux/can/error.h>
 #include <linux/can/raw.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
 #include <linux/sockios.h>
 #include <errno.h>
 #include <unistd.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
+#include <time.h>
 
 #ifndef CANFD_BRS
 #   define CANFD_BRS 0x01 /* bit rate switch (second bitrate for payload data) */
@@ -78,9 +82,115 @@ const char virtualC[]     = "virtual";
 enum {
     CanFlexibleDataRateMtu = 72,
     TypeSocketCan = 280,
-    DeviceIsActive = 1
+    DeviceIsActive = 1,
+    MaximumBatchSize = 1024, // UIO_MAXIOV, the kernel limit for recvmmsg() and sendmmsg()
+    DefaultWriteBatchSize = 64, // frames per sendmmsg() in writeFrames() without batch size
+    MaximumPayloadFilterSize = CANFD_MAX_DLEN
 };
 
+/*
+    Compiles a PayloadFilterKey list into a classic BPF program for SO_ATTACH_FILTER.
+
+    The program sees the can_frame or canfd_frame as read from the socket. Each
+    filter becomes one block, which returns "accept" if all its terms match and
+    otherwise continues with the next block. The last instruction rejects the frame.
+
+    Word loads from the packet are converted from network byte order, while
+    can_id is stored in host byte order. Therefore the identifier mask and
+    value are compared in their big endian representation.
+*/
+static std::vector<sock_filter> payloadFilterProgram(
+        const QList<QCanBusDevice::PayloadFilter> &filters)
+{
+    constexpr quint32 Accept = 0xffff;
+    constexpr quint32 Reject = 0;
+
+    std::vector<sock_filter> program;
+    std::vector<sock_filter> block;
+
+    for (const QCanBusDevice::PayloadFilter &payloadFilter : filters) {
+        const QCanBusDevice::Filter &f = payloadFilter.filter;
+        quint32 idMask = f.frameIdMask & CAN_EFF_MASK;
+        quint32 idValue = f.frameId & idMask;
+
+        switch (f.type) {
+        case QCanBusFrame::DataFrame:
+            idMask |= CAN_RTR_FLAG | CAN_ERR_FLAG;
+            break;
+        case QCanBusFrame::ErrorFrame:
+            idMask |= CAN_ERR_FLAG;
+            idValue |= CAN_ERR_FLAG;
+            break;
+        case QCanBusFrame::RemoteRequestFrame:
+            idMask |= CAN_RTR_FLAG | CAN_ERR_FLAG;
+            idValue |= CAN_RTR_FLAG;
+            break;
+        default:
+            break;
+        }
+
+        if ((f.format & QCanBusDevice::Filter::MatchBaseAndExtendedFormat)
+                == QCanBusDevice::Filter::MatchBaseAndExtendedFormat) {
+            // nothing
+        } else if (f.format & QCanBusDevice::Filter::MatchBaseFormat) {
+            idMask |= CAN_EFF_FLAG;
+        } else if (f.format & QCanBusDevice::Filter::MatchExtendedFormat) {
+            idMask |= CAN_EFF_FLAG;
+            idValue |= CAN_EFF_FLAG;
+        }
+
+        // The instruction indexes are relative to the block, jumps to
+        // block.size() continue with the next filter
+        block.clear();
+        auto matchOrNext = [&block](quint32 value) {
+            block.push_back(BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, value, 0, 0));
+        };
+
+        block.push_back(BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(canfd_frame, can_id)));
+        if (idMask != 0xffffffff)
+            block.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, qToBigEndian(idMask)));
+        matchOrNext(qToBigEndian(idValue));
+
+        const QByteArray &payload = payloadFilter.payload;
+        const QByteArray &payloadMask = payloadFilter.payloadMask;
+        auto byteMask = [&payloadMask](qsizetype i) {
+            return i < payloadMask.size() ? quint8(payloadMask.at(i)) : quint8(0xff);
+        };
+
+        qsizetype compared = payload.size();
+        while (compared > 0 && byteMask(compared - 1) == 0)
+            --compared;
+
+        if (compared > 0) {
+            // the payload must contain the last compared byte
+            block.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS, offsetof(canfd_frame, len)));
+            block.push_back(BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, quint32(compared), 0, 0));
+
+            for (qsizetype i = 0; i < compared; ++i) {
+                const quint8 mask = byteMask(i);
+                if (mask == 0)
+                    continue;
+                block.push_back(BPF_STMT(BPF_LD | BPF_B | BPF_ABS,
+                                         quint32(offsetof(canfd_frame, data) + i)));
+                if (mask != 0xff)
+                    block.push_back(BPF_STMT(BPF_ALU | BPF_AND | BPF_K, mask));
+                matchOrNext(quint8(payload.at(i)) & mask);
+            }
+        }
+        block.push_back(BPF_STMT(BPF_RET | BPF_K, Accept));
+
+        // A block has at most 3 + 2 + 3 * 64 + 1 instructions, so all jumps fit into jf
+        for (size_t i = 0; i < block.size(); ++i) {
+            if (BPF_CLASS(block[i].code) == BPF_JMP)
+                block[i].jf = quint8(block.size() - i - 1);
+        }
+        program.insert(program.end(), block.cbegin(), block.cend());
+    }
+
+    program.push_back(BPF_STMT(BPF_RET | BPF_K, Reject));
+    return program;
+}
+
 static QByteArray fileContent(const QString &fileName)
 {
     QFile file(fileName);
@@ -127,6 +237,68 @@ static int deviceChannel(const QString &canDevice)
     return content.toInt(nullptr, 0);
 }
 
+static qint64 toNanoSeconds(const timespec &time)
+{
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+static QCanBusFrame toQCanBusFrame(const canfd_frame &frame, int bytesReceived,
+                                   int messageFlags, qint64 timeStamp)
+{
+    QCanBusFrame bufferedFrame;
+    bufferedFrame.setTimeStampNanoSeconds(timeStamp);
+    bufferedFrame.setFlexibleDataRateFormat(bytesReceived == CANFD_MTU);
+
+    bufferedFrame.setExtendedFrameFormat(frame.can_id & CAN_EFF_FLAG);
+    Q_ASSERT(frame.len <= CANFD_MAX_DLEN);
+
+    if (frame.can_id & CAN_RTR_FLAG)
+        bufferedFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+    if (frame.can_id & CAN_ERR_FLAG)
+        bufferedFrame.setFrameType(QCanBusFrame::ErrorFrame);
+    // the flags are only valid for CAN FD frames, classic frames have a padding byte here
+    if (bytesReceived == CANFD_MTU && (frame.flags & CANFD_BRS))
+        bufferedFrame.setBitrateSwitch(true);
+    if (bytesReceived == CANFD_MTU && (frame.flags & CANFD_ESI))
+        bufferedFrame.setErrorStateIndicator(true);
+    if (messageFlags & MSG_CONFIRM)
+        bufferedFrame.setLocalEcho(true);
+
+    bufferedFrame.setFrameId(frame.can_id & CAN_EFF_MASK);
+
+    bufferedFrame.setPayload(reinterpret_cast<const char *>(frame.data), frame.len);
+
+    return bufferedFrame;
+}
+
+// Returns the number of bytes that have to be written to the socket
+static size_t toSocketFrame(const QCanBusFrame &frame, canfd_frame *socketFrame)
+{
+    canid_t canId = frame.frameId();
+    if (frame.hasExtendedFrameFormat())
+        canId |= CAN_EFF_FLAG;
+
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame) {
+        canId |= CAN_RTR_FLAG;
+    } else if (frame.frameType() == QCanBusFrame::ErrorFrame) {
+        canId = static_cast<canid_t>((frame.error() & QCanBusFrame::AnyError));
+        canId |= CAN_ERR_FLAG;
+    }
+
+    // struct can_frame is layout compatible to the first CAN_MTU bytes of struct canfd_frame
+    const QByteArrayView payload = frame.payloadView();
+    *socketFrame = {};
+    socketFrame->can_id = canId;
+    socketFrame->len = payload.size();
+    if (frame.hasFlexibleDataRateFormat()) {
+        socketFrame->flags = frame.hasBitrateSwitch() ? CANFD_BRS : 0;
+        socketFrame->flags |= frame.hasErrorStateIndicator() ? CANFD_ESI : 0;
+    }
+    ::memcpy(socketFrame->data, payload.constData(), socketFrame->len);
+
+    return frame.hasFlexibleDataRateFormat() ? CANFD_MTU : CAN_MTU;
+}
+
 QCanBusDeviceInfo SocketCanBackend::socketCanDeviceInfo(const QString &deviceName)
 {
     const QString serial; // exists for code readability purposes only
@@ -183,6 +355,10 @@ SocketCanBackend::SocketCanBackend(const QString &name) :
     }
 
     resetConfigurations();
+
+    setWriteFramesFunction([this](const QCanBusFrame *frames, qsizetype count) {
+        return writeBatch(frames, count);
+    });
 }
 
 SocketCanBackend::~SocketCanBackend()
@@ -220,9 +396,20 @@ bool SocketCanBackend::open()
 
 void SocketCanBackend::close()
 {
+    if (notifier && notifier->thread() != thread()) {
+        // Deleted by the I/O thread when it finishes, before the socket is closed.
+        notifier->deleteLater();
+        notifier = nullptr;
+        stopIoThread();
+    }
+
     ::close(canSocket);
     canSocket = -1;
 
+    delete writeNotifier;
+    writeNotifier = nullptr;
+    m_txCount = m_txSent = 0;
+
     setState(QCanBusDevice::UnconnectedState);
 }
 
@@ -336,6 +523,39 @@ bool SocketCanBackend::applyConfigurationParameter(ConfigurationKey key, const Q
         success = true;
         break;
     }
+    case QCanBusDevice::PayloadFilterKey:
+    {
+        const auto filterList = value.value<QList<QCanBusDevice::PayloadFilter>>();
+        if (!value.isValid() || filterList.isEmpty()) {
+            // permit every frame, the kernel reports ENOENT if no program is attached
+            int dummy = 0;
+            if (Q_UNLIKELY(setsockopt(canSocket, SOL_SOCKET, SO_DETACH_FILTER,
+                                      &dummy, sizeof(dummy)) < 0 && errno != ENOENT)) {
+                qCWarning(QT_CANBUS_PLUGINS_SOCKETCAN, "Cannot unset socket filter program.");
+                setError(qt_error_string(errno),
+                         QCanBusDevice::CanBusError::ConfigurationError);
+                break;
+            }
+            success = true;
+            break;
+        }
+
+        std::vector<sock_filter> program = payloadFilterProgram(filterList);
+        if (Q_UNLIKELY(program.size() > BPF_MAXINSNS)) {
+            setError(tr("Too many payload filters: %1").arg(filterList.size()),
+                     QCanBusDevice::CanBusError::ConfigurationError);
+            break;
+        }
+        const sock_fprog fprog = { static_cast<unsigned short>(program.size()), program.data() };
+        if (Q_UNLIKELY(setsockopt(canSocket, SOL_SOCKET, SO_ATTACH_FILTER,
+                                  &fprog, sizeof(fprog)) < 0)) {
+            setError(qt_error_string(errno),
+                     QCanBusDevice::CanBusError::ConfigurationError);
+            break;
+        }
+        success = true;
+        break;
+    }
     case QCanBusDevice::CanFdKey:
     {
         const int fd_frames = value.toBool() ? 1 : 0;
@@ -354,6 +574,19 @@ bool SocketCanBackend::applyConfigurationParameter(ConfigurationKey key, const Q
         success = libSocketCan->setBitrate(canSocketName, bitRate);
         break;
     }
+    case QCanBusDevice::FrameBatchSizeKey:
+    {
+        success = setupBatchBuffers(qMax(value.toInt(), 1));
+        break;
+    }
+    case QCanBusDevice::TimeStampSourceKey:
+    {
+        const auto source = value.isValid()
+                ? static_cast<QCanBusDevice::TimeStampSource>(value.toInt())
+                : QCanBusDevice::TimeStampSource::Kernel;
+        success = applyTimeStampSource(source);
+        break;
+    }
     default:
         setError(tr("Unsupported configuration key: %1").arg(key),
                  QCanBusDevice::CanBusError::ConfigurationError);
@@ -363,6 +596,98 @@ bool SocketCanBackend::applyConfigurationParameter(ConfigurationKey key, const Q
     return success;
 }
 
+bool SocketCanBackend::setupBatchBuffers(int newBatchSize)
+{
+    const size_t rxSize = newBatchSize > 1 ? size_t(newBatchSize) : 0;
+    QMutexLocker locker(&m_rxMutex);
+    m_rxHeaders.assign(rxSize, mmsghdr{});
+    m_rxIov.assign(rxSize, iovec{});
+    m_rxFrames.assign(rxSize, canfd_frame{});
+    m_rxAddresses.assign(rxSize, sockaddr_can{});
+    m_rxControl.assign(rxSize, ControlMessage{});
+    for (size_t i = 0; i < rxSize; ++i) {
+        m_rxIov[i].iov_base = &m_rxFrames[i];
+        msghdr &message = m_rxHeaders[i].msg_hdr;
+        message.msg_name = &m_rxAddresses[i];
+        message.msg_iov = &m_rxIov[i];
+        message.msg_iovlen = 1;
+        message.msg_control = m_rxControl[i].data;
+    }
+    batchSize = newBatchSize;
+    locker.unlock();
+
+    // keep a partially sent batch, the remaining frames are sent with the new buffers
+    const size_t txSize = qMax(newBatchSize > 1 ? rxSize : size_t(DefaultWriteBatchSize),
+                               size_t(m_txCount));
+    m_txHeaders.assign(txSize, mmsghdr{});
+    m_txIov.resize(txSize);
+    m_txFrames.resize(txSize);
+    for (size_t i = 0; i < txSize; ++i) {
+        m_txIov[i].iov_base = &m_txFrames[i];
+        msghdr &message = m_txHeaders[i].msg_hdr;
+        message.msg_iov = &m_txIov[i];
+        message.msg_iovlen = 1;
+    }
+
+    return true;
+}
+
+bool SocketCanBackend::applyTimeStampSource(QCanBusDevice::TimeStampSource source)
+{
+    // The timestamps are delivered as control messages together with each frame,
+    // so no additional SIOCGSTAMP ioctl() is needed per received frame.
+    const int kernelTimeStamps = source == QCanBusDevice::TimeStampSource::Kernel ? 1 : 0;
+    int timeStampingFlags = 0;
+    if (source == QCanBusDevice::TimeStampSource::Hardware) {
+        // also request software timestamps as fallback for devices without hardware support
+        timeStampingFlags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+                | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    }
+
+    const QMutexLocker locker(&m_rxMutex);
+
+    if (Q_UNLIKELY(setsockopt(canSocket, SOL_SOCKET, SO_TIMESTAMPNS,
+                              &kernelTimeStamps, sizeof(kernelTimeStamps)) < 0)
+            || Q_UNLIKELY(setsockopt(canSocket, SOL_SOCKET, SO_TIMESTAMPING,
+                                     &timeStampingFlags, sizeof(timeStampingFlags)) < 0)) {
+        setError(qt_error_string(errno),
+                 QCanBusDevice::CanBusError::ConfigurationError);
+        return false;
+    }
+
+    timeStampSource = source;
+    return true;
+}
+
+qint64 SocketCanBackend::timeStampFromControlMessage(msghdr *message) const
+{
+    if (timeStampSource != QCanBusDevice::TimeStampSource::Software) {
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(message); cmsg; cmsg = CMSG_NXTHDR(message, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET)
+                continue;
+
+            if (cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+                timespec time;
+                ::memcpy(&time, CMSG_DATA(cmsg), sizeof(time));
+                return toNanoSeconds(time);
+            } else if (cmsg->cmsg_type == SCM_TIMESTAMPING) {
+                // ts[0] is the software timestamp, ts[2] the raw hardware timestamp
+                scm_timestamping timeStamps;
+                ::memcpy(&timeStamps, CMSG_DATA(cmsg), sizeof(timeStamps));
+                const timespec &hardware = timeStamps.ts[2];
+                if (hardware.tv_sec != 0 || hardware.tv_nsec != 0)
+                    return toNanoSeconds(hardware);
+                return toNanoSeconds(timeStamps.ts[0]);
+            }
+        }
+    }
+
+    // software timestamps or no timestamp delivered by the kernel
+    timespec now = {};
+    ::clock_gettime(CLOCK_REALTIME, &now);
+    return toNanoSeconds(now);
+}
+
 bool SocketCanBackend::connectSocket()
 {
     struct ifreq interface;
@@ -395,11 +720,8 @@ bool SocketCanBackend::connectSocket()
     m_msg.msg_iovlen = 1;
     m_msg.msg_control = &m_ctrlmsg;
 
-    delete notifier;
-
-    notifier = new QSocketNotifier(canSocket, QSocketNotifier::Read, this);
-    connect(notifier, &QSocketNotifier::activated,
-            this, &SocketCanBackend::readSocket);
+    if (Q_UNLIKELY(!applyTimeStampSource(timeStampSource)))
+        return false;
 
     //apply all stored configurations
     const auto keys = configurationKeys();
@@ -412,6 +734,16 @@ bool SocketCanBackend::connectSocket()
         }
     }
 
+    delete notifier;
+
+    // The notifier is the context of the connection, so that readSocket()
+    // runs in the I/O thread once the notifier is moved there.
+    QThread *ioThread = startIoThread();
+    notifier = new QSocketNotifier(canSocket, QSocketNotifier::Read, ioThread ? nullptr : this);
+    connect(notifier, &QSocketNotifier::activated, notifier, [this]() { readSocket(); });
+    if (ioThread)
+        notifier->moveToThread(ioThread);
+
     return true;
 }
 
@@ -442,6 +774,25 @@ void SocketCanBackend::setConfigurationParameter(ConfigurationKey key, const QVa
                 return;
             }
         }
+    } else if (key == QCanBusDevice::PayloadFilterKey) {
+        const auto filters = value.value<QList<QCanBusDevice::PayloadFilter>>();
+        for (const QCanBusDevice::PayloadFilter &f : filters) {
+            if (f.filter.type == QCanBusFrame::UnknownFrame) {
+                setError(tr("Cannot set filter for frame type: %1").arg(f.filter.type),
+                         QCanBusDevice::CanBusError::ConfigurationError);
+                return;
+            }
+            if (f.filter.frameId > 0x1FFFFFFFU) {
+                setError(tr("FrameId %1 larger than 29 bit.").arg(f.filter.frameId),
+                         QCanBusDevice::CanBusError::ConfigurationError);
+                return;
+            }
+            if (f.payload.size() > MaximumPayloadFilterSize) {
+                setError(tr("Payload filter larger than %1 bytes.").arg(MaximumPayloadFilterSize),
+                         QCanBusDevice::CanBusError::ConfigurationError);
+                return;
+            }
+        }
     } else if (key == QCanBusDevice::ProtocolKey) {
         bool ok = false;
         const int newProtocol = value.toInt(&ok);
@@ -452,83 +803,175 @@ void SocketCanBackend::setConfigurationParameter(ConfigurationKey key, const QVa
             return;
         }
         protocol = newProtocol;
+    } else if (key == QCanBusDevice::FrameBatchSizeKey) {
+        bool ok = true;
+        const int newBatchSize = value.isValid() ? value.toInt(&ok) : 1;
+        if (Q_UNLIKELY(!ok || newBatchSize < 0 || newBatchSize > MaximumBatchSize)) {
+            const QString errorString = tr("Cannot set frame batch size to value %1.")
+                    .arg(value.toString());
+            setError(errorString, QCanBusDevice::ConfigurationError);
+            qCWarning(QT_CANBUS_PLUGINS_SOCKETCAN, "%ls", qUtf16Printable(errorString));
+            return;
+        }
+        // the batch buffers are set up when the socket is connected
+        if (canSocket == -1)
+            batchSize = qMax(newBatchSize, 1);
+    } else if (key == QCanBusDevice::TimeStampSourceKey) {
+        bool ok = true;
+        const int newSource = value.isValid()
+                ? value.toInt(&ok) : int(QCanBusDevice::TimeStampSource::Kernel);
+        if (Q_UNLIKELY(!ok || newSource < int(QCanBusDevice::TimeStampSource::Software)
+                       || newSource > int(QCanBusDevice::TimeStampSource::Hardware))) {
+            const QString errorString = tr("Cannot set timestamp source to value %1.")
+                    .arg(value.toString());
+            setError(errorString, QCanBusDevice::ConfigurationError);
+            qCWarning(QT_CANBUS_PLUGINS_SOCKETCAN, "%ls", qUtf16Printable(errorString));
+            return;
+        }
+        // the socket options are set when the socket is connected
+        if (canSocket == -1)
+            timeStampSource = static_cast<QCanBusDevice::TimeStampSource>(newSource);
     }
     // connected & params not applyable/invalid
     if (canSocket != -1 && !applyConfigurationParameter(key, value))
         return;
 
     QCanBusDevice::setConfigurationParameter(key, value);
-
-    // we need to check CAN FD option a lot -> cache it and avoid QList lookup
-    if (key == QCanBusDevice::CanFdKey)
-        canFdOptionEnabled = value.toBool();
 }
 
-bool SocketCanBackend::writeFrame(const QCanBusFrame &newData)
+bool SocketCanBackend::canWriteFrame(const QCanBusFrame &newData)
 {
-    if (state() != ConnectedState)
-        return false;
-
     if (Q_UNLIKELY(!newData.isValid())) {
         setError(tr("Cannot write invalid QCanBusFrame"), QCanBusDevice::WriteError);
         return false;
     }
 
-    canid_t canId = newData.frameId();
-    if (newData.hasExtendedFrameFormat())
-        canId |= CAN_EFF_FLAG;
-
-    if (newData.frameType() == QCanBusFrame::RemoteRequestFrame) {
-        canId |= CAN_RTR_FLAG;
-    } else if (newData.frameType() == QCanBusFrame::ErrorFrame) {
-        canId = static_cast<canid_t>((newData.error() & QCanBusFrame::AnyError));
-        canId |= CAN_ERR_FLAG;
-    }
-
-    if (Q_UNLIKELY(!canFdOptionEnabled && newData.hasFlexibleDataRateFormat())) {
+    if (Q_UNLIKELY(newData.hasFlexibleDataRateFormat()
+                   && !configurationFlag(QCanBusDevice::CanFdKey))) {
         const QString error = tr("Cannot write CAN FD frame because CAN FD option is not enabled.");
         qCWarning(QT_CANBUS_PLUGINS_SOCKETCAN, "%ls", qUtf16Printable(error));
         setError(error, QCanBusDevice::WriteError);
         return false;
     }
 
-    qint64 bytesWritten = 0;
-    if (newData.hasFlexibleDataRateFormat()) {
-        canfd_frame frame = {};
-        frame.len = newData.payload().size();
-        frame.can_id = canId;
-        frame.flags = newData.hasBitrateSwitch() ? CANFD_BRS : 0;
-        frame.flags |= newData.hasErrorStateIndicator() ? CANFD_ESI : 0;
-        ::memcpy(frame.data, newData.payload().constData(), frame.len);
+    return true;
+}
 
-        bytesWritten = ::write(canSocket, &frame, sizeof(frame));
-    } else {
-        can_frame frame = {};
-        frame.can_dlc = newData.payload().size();
-        frame.can_id = canId;
-        ::memcpy(frame.data, newData.payload().constData(), frame.can_dlc);
+bool SocketCanBackend::writeFrame(const QCanBusFrame &newData)
+{
+    if (state() != ConnectedState)
+        return false;
 
-        bytesWritten = ::write(canSocket, &frame, sizeof(frame));
+    if (Q_UNLIKELY(!canWriteFrame(newData)))
+        return false;
+
+    // frames from writeFrames() may still be pending, keep the order
+    if (batchSize > 1 || hasOutgoingFrames() || m_txSent != m_txCount) {
+        // collect all frames written in this event loop iteration and send them at once
+        enqueueOutgoingFrame(newData);
+        if (!writeFlushPending) {
+            writeFlushPending = true;
+            QMetaObject::invokeMethod(this, &SocketCanBackend::writeBatchedFrames,
+                                      Qt::QueuedConnection);
+        }
+        return true;
     }
 
+    canfd_frame frame;
+    const size_t frameSize = toSocketFrame(newData, &frame);
+    const qint64 bytesWritten = ::write(canSocket, &frame, frameSize);
+
     if (Q_UNLIKELY(bytesWritten < 0)) {
         setError(qt_error_string(errno),
                  QCanBusDevice::CanBusError::WriteError);
         return false;
     }
 
+    recordWrittenFrames(1, frame.len);
     emit framesWritten(1);
 
     return true;
 }
 
+// Called by writeFrames()
+qsizetype SocketCanBackend::writeBatch(const QCanBusFrame *frames, qsizetype count)
+{
+    if (state() != ConnectedState)
+        return 0;
+
+    if (m_txHeaders.empty())
+        setupBatchBuffers(batchSize);
+
+    qsizetype accepted = 0;
+    for (; accepted < count; ++accepted) {
+        if (Q_UNLIKELY(!canWriteFrame(frames[accepted])))
+            break;
+        enqueueOutgoingFrame(frames[accepted]);
+    }
+
+    // send right away, a full socket buffer defers the remaining frames
+    if (accepted > 0)
+        writeBatchedFrames();
+
+    return accepted;
+}
+
+void SocketCanBackend::writeBatchedFrames()
+{
+    writeFlushPending = false;
+    if (writeNotifier)
+        writeNotifier->setEnabled(false);
+
+    while (canSocket != -1) {
+        if (m_txSent == m_txCount) {
+            // the previous batch is completely sent, fill the next one
+            m_txSent = m_txCount = 0;
+            while (m_txCount < int(m_txHeaders.size()) && hasOutgoingFrames()) {
+                m_txIov[m_txCount].iov_len = toSocketFrame(dequeueOutgoingFrame(),
+                                                           &m_txFrames[m_txCount]);
+                ++m_txCount;
+            }
+            if (m_txCount == 0)
+                return;
+        }
+
+        const int framesSent = ::sendmmsg(canSocket, &m_txHeaders[m_txSent],
+                                          m_txCount - m_txSent, MSG_DONTWAIT);
+        if (Q_UNLIKELY(framesSent < 0)) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // the socket buffer is full, continue as soon as it is writable again
+                if (!writeNotifier) {
+                    writeNotifier = new QSocketNotifier(canSocket, QSocketNotifier::Write, this);
+                    connect(writeNotifier, &QSocketNotifier::activated,
+                            this, &SocketCanBackend::writeBatchedFrames);
+                }
+                writeNotifier->setEnabled(true);
+                return;
+            }
+
+            // like in the unbatched case, the frames that could not be written are lost
+            setError(qt_error_string(errno),
+                     QCanBusDevice::CanBusError::WriteError);
+            m_txSent = m_txCount = 0;
+            continue;
+        }
+
+        qint64 payloadBytes = 0;
+        for (int i = m_txSent; i < m_txSent + framesSent; ++i)
+            payloadBytes += m_txFrames[i].len;
+        m_txSent += framesSent;
+        recordWrittenFrames(framesSent, payloadBytes);
+        emit framesWritten(framesSent);
+    }
+}
+
 QString SocketCanBackend::interpretErrorFrame(const QCanBusFrame &errorFrame)
 {
     if (errorFrame.frameType() != QCanBusFrame::ErrorFrame)
         return QString();
 
     // the payload may contain the error details
-    const QByteArray data = errorFrame.payload();
+    const QByteArrayView data = errorFrame.payloadView();
     QString errorMsg;
 
     if (errorFrame.error() & QCanBusFrame::TransmissionTimeoutError)
@@ -687,6 +1130,14 @@ QString SocketCanBackend::interpretErrorFrame(const QCanBusFrame &errorFrame)
 
 void SocketCanBackend::readSocket()
 {
+    // The lock is released before the frames are queued, so that a full queue with
+    // the Block overflow policy does not stall a configuration change.
+    QMutexLocker locker(&m_rxMutex);
+    if (batchSize > 1) {
+        readSocketBatched(locker);
+        return;
+    }
+
     QList<QCanBusFrame> newFrames;
 
     for (;;) {
@@ -710,41 +1161,65 @@ void SocketCanBackend::readSocket()
             continue;
         }
 
-        struct timeval timeStamp = {};
-        if (Q_UNLIKELY(ioctl(canSocket, SIOCGSTAMP, &timeStamp) < 0)) {
-            setError(qt_error_string(errno),
-                     QCanBusDevice::CanBusError::ReadError);
-            timeStamp = {};
-        }
+        newFrames.append(toQCanBusFrame(m_frame, bytesReceived, m_msg.msg_flags,
+                                        timeStampFromControlMessage(&m_msg)));
+    }
 
-        const QCanBusFrame::TimeStamp stamp(timeStamp.tv_sec, timeStamp.tv_usec);
-        QCanBusFrame bufferedFrame;
-        bufferedFrame.setTimeStamp(stamp);
-        bufferedFrame.setFlexibleDataRateFormat(bytesReceived == CANFD_MTU);
+    locker.unlock();
+    enqueueReceivedFrames(newFrames);
+}
 
-        bufferedFrame.setExtendedFrameFormat(m_frame.can_id & CAN_EFF_FLAG);
-        Q_ASSERT(m_frame.len <= CANFD_MAX_DLEN);
+void SocketCanBackend::readSocketBatched(QMutexLocker<QMutex> &locker)
+{
+    for (;;) {
+        // the batch size may have changed while the lock was released
+        const int count = batchSize;
+        if (count <= 1)
+            break;
 
-        if (m_frame.can_id & CAN_RTR_FLAG)
-            bufferedFrame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-        if (m_frame.can_id & CAN_ERR_FLAG)
-            bufferedFrame.setFrameType(QCanBusFrame::ErrorFrame);
-        if (m_frame.flags & CANFD_BRS)
-            bufferedFrame.setBitrateSwitch(true);
-        if (m_frame.flags & CANFD_ESI)
-            bufferedFrame.setErrorStateIndicator(true);
-        if (m_msg.msg_flags & MSG_CONFIRM)
-            bufferedFrame.setLocalEcho(true);
+        for (int i = 0; i < count; ++i) {
+            m_rxIov[i].iov_len = sizeof(canfd_frame);
+            msghdr &message = m_rxHeaders[i].msg_hdr;
+            message.msg_namelen = sizeof(sockaddr_can);
+            message.msg_controllen = sizeof(ControlMessage);
+            message.msg_flags = 0;
+        }
 
-        bufferedFrame.setFrameId(m_frame.can_id & CAN_EFF_MASK);
+        const int framesReceived = ::recvmmsg(canSocket, m_rxHeaders.data(), count,
+                                              MSG_DONTWAIT, nullptr);
+        if (framesReceived <= 0)
+            break;
 
-        const QByteArray load(reinterpret_cast<char *>(m_frame.data), m_frame.len);
-        bufferedFrame.setPayload(load);
+        m_rxBatch.clear();
+        for (int i = 0; i < framesReceived; ++i) {
+            const int bytesReceived = int(m_rxHeaders[i].msg_len);
+            const canfd_frame &frame = m_rxFrames[i];
+
+            if (Q_UNLIKELY(bytesReceived != CANFD_MTU && bytesReceived != CAN_MTU)) {
+                setError(tr("ERROR SocketCanBackend: incomplete CAN frame"),
+                         QCanBusDevice::CanBusError::ReadError);
+                continue;
+            } else if (Q_UNLIKELY(frame.len > bytesReceived - offsetof(canfd_frame, data))) {
+                setError(tr("ERROR SocketCanBackend: invalid CAN frame length"),
+                         QCanBusDevice::CanBusError::ReadError);
+                continue;
+            }
 
-        newFrames.append(std::move(bufferedFrame));
+            msghdr &message = m_rxHeaders[i].msg_hdr;
+            m_rxBatch.append(toQCanBusFrame(frame, bytesReceived, message.msg_flags,
+                                            timeStampFromControlMessage(&message)));
+        }
+
+        locker.unlock();
+        enqueueReceivedFrames(m_rxBatch);
+        locker.relock();
+
+        // a partially filled batch means the socket is drained
+        if (framesReceived < count)
+            break;
     }
 
-    enqueueReceivedFrames(newFrames);
+    m_rxBatch.clear();
 }
 
 void SocketCanBackend::resetController()
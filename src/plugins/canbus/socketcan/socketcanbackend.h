@@ -41,6 +41,7 @@
 #include <QtSerialBus/qcanbusdevice.h>
 #include <QtSerialBus/qcanbusdeviceinfo.h>
 
+#include <QtCore/qmutex.h>
 #include <QtCore/qsocketnotifier.h>
 #include <QtCore/qstring.h>
 #include <QtCore/qvariant.h>
@@ -50,9 +51,11 @@
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <linux/can.h>
+#include <linux/errqueue.h>
 #include <sys/time.h>
 
 #include <memory>
+#include <vector>
 
 #ifndef CANFD_MTU
 // CAN FD support was added by Linux kernel 3.6
@@ -113,6 +116,23 @@ private:
     void resetConfigurations();
     bool connectSocket();
     bool applyConfigurationParameter(ConfigurationKey key, const QVariant &value);
+    bool setupBatchBuffers(int batchSize);
+    bool canWriteFrame(const QCanBusFrame &newData);
+    qsizetype writeBatch(const QCanBusFrame *frames, qsizetype count);
+    bool applyTimeStampSource(QCanBusDevice::TimeStampSource source);
+    qint64 timeStampFromControlMessage(msghdr *message) const; // nanoseconds
+    void readSocketBatched(QMutexLocker<QMutex> &locker);
+    void writeBatchedFrames();
+
+    // Room for the SO_TIMESTAMPNS or SO_TIMESTAMPING timestamps and SO_RXQ_OVFL
+    struct ControlMessage {
+        alignas(cmsghdr) char data[CMSG_SPACE(sizeof(scm_timestamping))
+                                   + CMSG_SPACE(sizeof(__u32))];
+    };
+
+    // Guards the receive buffers, batchSize and timeStampSource, which the
+    // I/O thread uses while the configuration is changed in the device's thread.
+    QMutex m_rxMutex;
 
     int protocol = CAN_RAW;
     canfd_frame m_frame;
@@ -120,13 +140,29 @@ private:
     msghdr m_msg;
     iovec m_iov;
     sockaddr_can m_addr;
-    char m_ctrlmsg[CMSG_SPACE(sizeof(timeval)) + CMSG_SPACE(sizeof(__u32))];
+    ControlMessage m_ctrlmsg;
+
+    // Buffers for batched I/O with recvmmsg() and sendmmsg()
+    std::vector<mmsghdr> m_rxHeaders;
+    std::vector<iovec> m_rxIov;
+    std::vector<canfd_frame> m_rxFrames;
+    std::vector<sockaddr_can> m_rxAddresses;
+    std::vector<ControlMessage> m_rxControl;
+    std::vector<mmsghdr> m_txHeaders;
+    std::vector<iovec> m_txIov;
+    std::vector<canfd_frame> m_txFrames;
+    QList<QCanBusFrame> m_rxBatch;
+    int m_txCount = 0;
+    int m_txSent = 0;
 
     qint64 canSocket = -1;
     QSocketNotifier *notifier = nullptr;
+    QSocketNotifier *writeNotifier = nullptr;
     std::unique_ptr<LibSocketCan> libSocketCan;
     QString canSocketName;
-    bool canFdOptionEnabled = false;
+    int batchSize = 1;
+    QCanBusDevice::TimeStampSource timeStampSource = QCanBusDevice::TimeStampSource::Kernel;
+    bool writeFlushPending = false;
 };
 
 QT_END_NAMESPACE
@@ -259,6 +259,8 @@ bool SystecCanBackendPrivate::setConfigurationParameter(QCanBusDevice::Configura
     Q_Q(SystecCanBackend);
 
     switch (key) {
+    case QCanBusDevice::RawFilterKey:
+        return true;
     case QCanBusDevice::BitRateKey:
         return verifyBitRate(value.toInt());
     case QCanBusDevice::ReceiveOwnKey:
@@ -373,7 +375,7 @@ void SystecCanBackendPrivate::startWrite()
     }
 
     const QCanBusFrame frame = q->dequeueOutgoingFrame();
-    const QByteArray payload = frame.payload();
+    const QByteArrayView payload = frame.payloadView();
     const qsizetype payloadSize = payload.size();
 
     tCanMsgStruct message = {};
@@ -389,10 +391,12 @@ void SystecCanBackendPrivate::startWrite()
         ::memcpy(message.m_bData, payload.constData(), payloadSize);
 
     const UCANRET result = ::UcanWriteCanMsgEx(handle, channel, &message, nullptr);
-    if (Q_UNLIKELY(result != USBCAN_SUCCESSFUL))
+    if (Q_UNLIKELY(result != USBCAN_SUCCESSFUL)) {
         q->setError(systemErrorString(result), QCanBusDevice::WriteError);
-    else
+    } else {
+        q->recordWrittenFrames(1, payloadSize);
         emit q->framesWritten(qint64(1));
+    }
 
     if (q->hasOutgoingFrames())
         enableWriteNotification(true);
@@ -418,9 +422,9 @@ void SystecCanBackendPrivate::readAllReceivedMessages()
             break;
         }
 
-        QCanBusFrame frame(message.m_dwID,
-                           QByteArray(reinterpret_cast<const char *>(message.m_bData),
-                                      int(message.m_bDLC)));
+        QCanBusFrame frame;
+        frame.setFrameId(message.m_dwID);
+        frame.setPayload(reinterpret_cast<const char *>(message.m_bData), int(message.m_bDLC));
 
         // TODO: Timestamp can also be set to 100 us resolution with kUcanModeHighResTimer
         frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(message.m_dwTime * 1000));
@@ -496,6 +500,8 @@ SystecCanBackend::SystecCanBackend(const QString &name, QObject *parent) :
 
     d->setupChannel(name);
     d->setupDefaultConfigurations();
+    // The driver cannot filter, so RawFilterKey is matched in enqueueReceivedFrames()
+    setSoftwareFilterEnabled(true);
 }
 
 SystecCanBackend::~SystecCanBackend()
@@ -239,6 +239,8 @@ bool TinyCanBackendPrivate::setConfigurationParameter(QCanBusDevice::Configurati
     Q_Q(TinyCanBackend);
 
     switch (key) {
+    case QCanBusDevice::RawFilterKey:
+        return true;
     case QCanBusDevice::BitRateKey:
         return setBitRate(value.toInt());
     default:
@@ -342,6 +344,21 @@ void TinyCanBackendPrivate::setupDefaultConfigurations()
     q->setConfigurationParameter(QCanBusDevice::BitRateKey, 500000);
 }
 
+static void toTinyCanMessage(const QCanBusFrame &frame, TCanMsg *message)
+{
+    const QByteArrayView payload = frame.payloadView();
+    const qsizetype payloadSize = payload.size();
+
+    *message = {};
+    message->Id = frame.frameId();
+    message->Flags.Flag.Len = payloadSize;
+    message->Flags.Flag.Error = (frame.frameType() == QCanBusFrame::ErrorFrame);
+    message->Flags.Flag.RTR = (frame.frameType() == QCanBusFrame::RemoteRequestFrame);
+    message->Flags.Flag.TxD = 1;
+    message->Flags.Flag.EFF = frame.hasExtendedFrameFormat();
+    ::memcpy(message->Data.Bytes, payload.constData(), payloadSize);
+}
+
 void TinyCanBackendPrivate::startWrite()
 {
     Q_Q(TinyCanBackend);
@@ -351,28 +368,70 @@ void TinyCanBackendPrivate::startWrite()
         return;
     }
 
-    const QCanBusFrame frame = q->dequeueOutgoingFrame();
-    const QByteArray payload = frame.payload();
-    const qsizetype payloadSize = payload.size();
+    if (transmitMessages.empty()) {
+        transmitFrames.resize(TransmitBatchSize);
+        transmitMessages.resize(TransmitBatchSize);
+    }
 
-    TCanMsg message = {};
-    message.Id = frame.frameId();
-    message.Flags.Flag.Len = payloadSize;
-    message.Flags.Flag.Error = (frame.frameType() == QCanBusFrame::ErrorFrame);
-    message.Flags.Flag.RTR = (frame.frameType() == QCanBusFrame::RemoteRequestFrame);
-    message.Flags.Flag.TxD = 1;
-    message.Flags.Flag.EFF = frame.hasExtendedFrameFormat();
-
-    const qint32 messagesToWrite = 1;
-    ::memcpy(message.Data.Bytes, payload.constData(), payloadSize);
-    const int ret = ::CanTransmit(channelIndex, &message, messagesToWrite);
-    if (Q_UNLIKELY(ret < 0))
-        q->setError(systemErrorString(ret), QCanBusDevice::CanBusError::WriteError);
+    // Hand over as many queued frames as fit into the TX FIFO. Frames the
+    // driver does not accept stay queued for the next timer event.
+    const quint32 fifoLevel = ::CanTransmitGetCount(channelIndex);
+    qint64 fifoSpace = qMax<qint64>(0, qint64(TransmitFifoSize) - fifoLevel);
+    qint64 framesWritten = 0;
+    qint64 payloadBytes = 0;
+
+    while (fifoSpace > 0 && q->hasOutgoingFrames()) {
+        const qsizetype maxFrames = qsizetype(qMin<qint64>(fifoSpace, TransmitBatchSize));
+        const qsizetype count = q->peekOutgoingFrames(transmitFrames.data(), maxFrames);
+        for (qsizetype i = 0; i < count; ++i)
+            toTinyCanMessage(transmitFrames[i], &transmitMessages[i]);
+
+        const int ret = ::CanTransmit(channelIndex, transmitMessages.data(), qint32(count));
+        if (Q_UNLIKELY(ret < 0)) {
+            // The driver rejected the whole batch, drop it and report the error
+            q->discardOutgoingFrames(count);
+            q->setError(systemErrorString(ret), QCanBusDevice::CanBusError::WriteError);
+            break;
+        }
+
+        for (int i = 0; i < ret; ++i)
+            payloadBytes += transmitFrames[i].payloadView().size();
+        q->discardOutgoingFrames(ret);
+        framesWritten += ret;
+        fifoSpace -= ret;
+        if (ret < count) {
+            fifoSpace = 0;
+            break;
+        }
+    }
+
+    if (framesWritten > 0) {
+        q->recordWrittenFrames(framesWritten, payloadBytes);
+        emit q->framesWritten(framesWritten);
+    }
+
+    // Poll less eagerly while waiting for the driver to make room in its FIFO
+    if (q->hasOutgoingFrames())
+        writeNotifier->start(fifoSpace == 0 ? 1 : 0);
+}
+
+static QCanBusFrame fromTinyCanMessage(const TCanMsg &message)
+{
+    QCanBusFrame frame;
+    frame.setFrameId(message.Id);
+    frame.setPayload(reinterpret_cast<const char *>(message.Data.Bytes),
+                     int(message.Flags.Flag.Len));
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(message.Time.Sec, message.Time.USec));
+    frame.setExtendedFrameFormat(message.Flags.Flag.EFF);
+
+    if (message.Flags.Flag.Error)
+        frame.setFrameType(QCanBusFrame::ErrorFrame);
+    else if (message.Flags.Flag.RTR)
+        frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
     else
-        emit q->framesWritten(messagesToWrite);
+        frame.setFrameType(QCanBusFrame::DataFrame);
 
-    if (q->hasOutgoingFrames() && !writeNotifier->isActive())
-        writeNotifier->start();
+    return frame;
 }
 
 // this method is called from the different thread!
@@ -380,16 +439,18 @@ void TinyCanBackendPrivate::startRead()
 {
     Q_Q(TinyCanBackend);
 
-    QList<QCanBusFrame> newFrames;
+    if (receiveMessages.empty())
+        receiveMessages.resize(ReceiveBatchSize);
 
     for (;;) {
-        if (!::CanReceiveGetCount(channelIndex))
+        const quint32 pendingMessages = ::CanReceiveGetCount(channelIndex);
+        if (!pendingMessages)
             break;
 
-        TCanMsg message = {};
-
-        const int messagesToRead = 1;
-        const int ret = ::CanReceive(channelIndex, &message, messagesToRead);
+        // CanReceive() copies up to messagesToRead messages out of the driver FIFO
+        const qint32 messagesToRead = qint32(qMin<quint32>(pendingMessages,
+                                                           quint32(receiveMessages.size())));
+        const int ret = ::CanReceive(channelIndex, receiveMessages.data(), messagesToRead);
         if (Q_UNLIKELY(ret < 0)) {
             q->setError(systemErrorString(ret), QCanBusDevice::CanBusError::ReadError);
 
@@ -407,22 +468,15 @@ void TinyCanBackendPrivate::startRead()
             continue;
         }
 
-        QCanBusFrame frame(message.Id, QByteArray(reinterpret_cast<char *>(message.Data.Bytes),
-                                                  int(message.Flags.Flag.Len)));
-        frame.setTimeStamp(QCanBusFrame::TimeStamp(message.Time.Sec, message.Time.USec));
-        frame.setExtendedFrameFormat(message.Flags.Flag.EFF);
-
-        if (message.Flags.Flag.Error)
-            frame.setFrameType(QCanBusFrame::ErrorFrame);
-        else if (message.Flags.Flag.RTR)
-            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-        else
-            frame.setFrameType(QCanBusFrame::DataFrame);
+        if (ret == 0)
+            break;
 
-        newFrames.append(std::move(frame));
+        for (int i = 0; i < ret; ++i)
+            receivedFrames.append(fromTinyCanMessage(receiveMessages[i]));
     }
 
-    q->enqueueReceivedFrames(newFrames);
+    q->enqueueReceivedFrames(receivedFrames);
+    receivedFrames.clear(); // keeps the capacity for the next call
 }
 
 void TinyCanBackendPrivate::startupDriver()
@@ -504,6 +558,8 @@ TinyCanBackend::TinyCanBackend(const QString &name, QObject *parent)
 
     d->setupChannel(name);
     d->setupDefaultConfigurations();
+    // The driver cannot filter, so RawFilterKey is matched in enqueueReceivedFrames()
+    setSoftwareFilterEnabled(true);
 }
 
 TinyCanBackend::~TinyCanBackend()
@@ -584,7 +640,7 @@ bool TinyCanBackend::writeFrame(const QCanBusFrame &newData)
     enqueueOutgoingFrame(newData);
 
     if (!d->writeNotifier->isActive())
-        d->writeNotifier->start();
+        d->writeNotifier->start(0);
 
     return true;
 }
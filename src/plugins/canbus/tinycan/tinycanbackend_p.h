@@ -41,6 +41,8 @@
 #include "tinycanbackend.h"
 #include "tinycan_symbols_p.h"
 
+#include <vector>
+
 //
 //  W A R N I N G
 //  -------------
@@ -84,6 +86,16 @@ public:
     bool isOpen = false;
     int channelIndex = INDEX_INVALID;
     QTimer *writeNotifier = nullptr;
+
+    // Buffers reused by startRead(), which the driver calls serialized by gTinyCan->mutex
+    enum { ReceiveBatchSize = 64 };
+    std::vector<TCanMsg> receiveMessages;
+    QList<QCanBusFrame> receivedFrames;
+
+    // Buffers reused by startWrite(); TransmitFifoSize is the driver's default TX FIFO size
+    enum { TransmitBatchSize = 64, TransmitFifoSize = 255 };
+    std::vector<QCanBusFrame> transmitFrames;
+    std::vector<TCanMsg> transmitMessages;
 };
 
 QT_END_NAMESPACE
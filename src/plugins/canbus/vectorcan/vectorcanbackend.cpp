@@ -260,6 +260,8 @@ bool VectorCanBackendPrivate::setConfigurationParameter(QCanBusDevice::Configura
     Q_Q(VectorCanBackend);
 
     switch (key) {
+    case QCanBusDevice::RawFilterKey:
+        return true;
     case QCanBusDevice::BitRateKey:
         return setBitRate(value.toUInt());
     case QCanBusDevice::ReceiveOwnKey:
@@ -337,7 +339,7 @@ void VectorCanBackendPrivate::startWrite()
     }
 
     const QCanBusFrame frame = q->dequeueOutgoingFrame();
-    const QByteArray payload = frame.payload();
+    const QByteArrayView payload = frame.payloadView();
     const qsizetype payloadSize = payload.size();
 
     quint32 eventCount = 1;
@@ -385,6 +387,7 @@ void VectorCanBackendPrivate::startWrite()
         q->setError(systemErrorString(status),
                     QCanBusDevice::WriteError);
     } else {
+        q->recordWrittenFrames(qint64(eventCount), payloadSize);
         emit q->framesWritten(qint64(eventCount));
     }
 
@@ -415,8 +418,9 @@ void VectorCanBackendPrivate::startRead()
 
             const XL_CAN_EV_RX_MSG &msg = event.tagData.canRxOkMsg;
 
-            QCanBusFrame frame(msg.id & ~XL_CAN_EXT_MSG_ID,
-                QByteArray(reinterpret_cast<const char *>(msg.data), int(msg.dlc)));
+            QCanBusFrame frame;
+            frame.setFrameId(msg.id & ~XL_CAN_EXT_MSG_ID);
+            frame.setPayload(reinterpret_cast<const char *>(msg.data), int(msg.dlc));
             frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(event.timeStamp / 1000));
             frame.setExtendedFrameFormat(msg.id & XL_CAN_RXMSG_FLAG_EDL);
             frame.setFrameType((msg.flags & XL_CAN_RXMSG_FLAG_RTR)
@@ -445,8 +449,9 @@ void VectorCanBackendPrivate::startRead()
             if ((msg.flags & XL_CAN_MSG_FLAG_TX_COMPLETED) && !transmitEcho)
                 continue;
 
-            QCanBusFrame frame(msg.id & ~XL_CAN_EXT_MSG_ID,
-                QByteArray(reinterpret_cast<const char *>(msg.data), int(msg.dlc)));
+            QCanBusFrame frame;
+            frame.setFrameId(msg.id & ~XL_CAN_EXT_MSG_ID);
+            frame.setPayload(reinterpret_cast<const char *>(msg.data), int(msg.dlc));
             frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(event.timeStamp / 1000));
             frame.setExtendedFrameFormat(msg.id & XL_CAN_EXT_MSG_ID);
             frame.setLocalEcho(msg.flags & XL_CAN_MSG_FLAG_TX_COMPLETED);
@@ -549,6 +554,8 @@ VectorCanBackend::VectorCanBackend(const QString &name, QObject *parent)
 
     d->setupChannel(name);
     d->setupDefaultConfigurations();
+    // The driver cannot filter, so RawFilterKey is matched in enqueueReceivedFrames()
+    setSoftwareFilterEnabled(true);
 }
 
 VectorCanBackend::~VectorCanBackend()
@@ -37,12 +37,17 @@
 #include "virtualcanbackend.h"
 
 #include <QtCore/qdatetime.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qregularexpression.h>
 
 #include <QtNetwork/qtcpserver.h>
 #include <QtNetwork/qtcpsocket.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
 QT_BEGIN_NAMESPACE
 
 Q_DECLARE_LOGGING_CATEGORY(QT_CANBUS_PLUGINS_VIRTUALCAN)
@@ -59,6 +64,228 @@ static const char BitRateSwitchFlag    = 'B';
 static const char ErrorStateFlag       = 'E';
 static const char LocalEchoFlag        = 'L';
 
+// Flags of the binary protocol records
+enum BinaryFlag : quint8 {
+    BinaryRemoteRequest    = 0x01,
+    BinaryExtendedFormat   = 0x02,
+    BinaryFlexibleDataRate = 0x04,
+    BinaryBitRateSwitch    = 0x08,
+    BinaryErrorState       = 0x10,
+    BinaryLocalEcho        = 0x20,
+    BinaryDisconnect       = 0x80 // control record without frame
+};
+
+enum : qsizetype {
+    BinaryRecordHeaderSize = 16, // size, channel, flags, frame id, timestamp
+    MaximumPayloadSize = 64
+};
+
+// Control messages of the text protocol, also used to negotiate the binary protocol
+static const char ProtocolBinaryRequest[] = "protocol:binary";
+static const char ProtocolBinaryStart[]   = "protocol:start";
+
+static int fromHexDigit(char digit)
+{
+    if (digit >= '0' && digit <= '9')
+        return digit - '0';
+    if (digit >= 'a' && digit <= 'f')
+        return digit - 'a' + 10;
+    if (digit >= 'A' && digit <= 'F')
+        return digit - 'A' + 10;
+    return -1;
+}
+
+static qint64 monotonicNanoSeconds()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool channelFromInterface(QByteArrayView interface, uint *channel)
+{
+    if (!interface.startsWith("can"))
+        return false;
+
+    bool ok = false;
+    *channel = interface.mid(3).toByteArray().toUInt(&ok);
+    return ok;
+}
+
+/*
+    Text protocol: "<CAN-ID>#<Flags>#<Data-Bytes>", see VirtualCanBackend::writeFrame().
+    Returns false for malformed lines.
+*/
+static bool decodeTextFrame(const QByteArray &line, QCanBusFrame *frame)
+{
+    const qsizetype flagsStart = line.indexOf('#');
+    const qsizetype dataStart = flagsStart < 0 ? -1 : line.indexOf('#', flagsStart + 1);
+    if (Q_UNLIKELY(dataStart < 0))
+        return false;
+
+    char *idEnd = nullptr;
+    const QCanBusFrame::FrameId id = std::strtoul(line.constData(), &idEnd, 10);
+    if (Q_UNLIKELY(idEnd != line.constData() + flagsStart))
+        return false;
+
+    // decode the hex payload without a temporary QByteArray
+    const qsizetype hexSize = line.size() - dataStart - 1;
+    if (Q_UNLIKELY(hexSize % 2 || hexSize / 2 > MaximumPayloadSize))
+        return false;
+    char data[MaximumPayloadSize];
+    const char *hex = line.constData() + dataStart + 1;
+    for (qsizetype i = 0; i < hexSize / 2; ++i) {
+        const int high = fromHexDigit(hex[2 * i]);
+        const int low = fromHexDigit(hex[2 * i + 1]);
+        if (Q_UNLIKELY(high < 0 || low < 0))
+            return false;
+        data[i] = char((high << 4) | low);
+    }
+
+    const QByteArrayView flags(line.constData() + flagsStart + 1, dataStart - flagsStart - 1);
+    const auto hasFlag = [flags](char flag) {
+        return std::find(flags.begin(), flags.end(), flag) != flags.end();
+    };
+
+    *frame = QCanBusFrame();
+    frame->setFrameId(id);
+    frame->setPayload(data, hexSize / 2);
+    if (hasFlag(RemoteRequestFlag))
+        frame->setFrameType(QCanBusFrame::RemoteRequestFrame);
+    frame->setExtendedFrameFormat(hasFlag(ExtendedFormatFlag));
+    frame->setFlexibleDataRateFormat(hasFlag(FlexibleDataRateFlag));
+    frame->setBitrateSwitch(hasFlag(BitRateSwitchFlag));
+    frame->setErrorStateIndicator(hasFlag(ErrorStateFlag));
+    frame->setLocalEcho(hasFlag(LocalEchoFlag));
+    return true;
+}
+
+static void encodeTextFrame(const QCanBusFrame &frame, QByteArray *out)
+{
+    out->append(QByteArray::number(frame.frameId()));
+    out->append('#');
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
+        out->append(RemoteRequestFlag);
+    if (frame.hasExtendedFrameFormat())
+        out->append(ExtendedFormatFlag);
+    if (frame.hasFlexibleDataRateFormat())
+        out->append(FlexibleDataRateFlag);
+    if (frame.hasBitrateSwitch())
+        out->append(BitRateSwitchFlag);
+    if (frame.hasErrorStateIndicator())
+        out->append(ErrorStateFlag);
+    if (frame.hasLocalEcho())
+        out->append(LocalEchoFlag);
+    out->append('#');
+    static const char hexDigits[] = "0123456789abcdef";
+    for (const char byte : frame.payloadView()) {
+        out->append(hexDigits[uchar(byte) >> 4]);
+        out->append(hexDigits[uchar(byte) & 0xf]);
+    }
+    out->append('\n');
+}
+
+/*
+    Binary protocol: Each record is prefixed with its size, all values are
+    in little endian byte order:
+
+    quint16  size of the record following this field
+    quint8   CAN channel
+    quint8   flags, see BinaryFlag
+    quint32  CAN-ID
+    qint64   sender timestamp in nanoseconds from a monotonic clock
+    quint8[] data bytes (size - 14 bytes)
+*/
+static void encodeBinaryRecord(uint channel, quint8 flags, const QCanBusFrame &frame,
+                               qint64 timeStamp, QByteArray *out)
+{
+    const QByteArrayView payload = frame.payloadView();
+    const qsizetype offset = out->size();
+    out->resize(offset + BinaryRecordHeaderSize + payload.size());
+
+    uchar *record = reinterpret_cast<uchar *>(out->data()) + offset;
+    qToLittleEndian<quint16>(quint16(BinaryRecordHeaderSize - 2 + payload.size()), record);
+    record[2] = uchar(channel);
+    record[3] = flags;
+    qToLittleEndian<quint32>(frame.frameId(), record + 4);
+    qToLittleEndian<qint64>(timeStamp, record + 8);
+    if (!payload.isEmpty())
+        ::memcpy(record + BinaryRecordHeaderSize, payload.data(), payload.size());
+}
+
+static quint8 binaryFlags(const QCanBusFrame &frame)
+{
+    quint8 flags = 0;
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
+        flags |= BinaryRemoteRequest;
+    if (frame.hasExtendedFrameFormat())
+        flags |= BinaryExtendedFormat;
+    if (frame.hasFlexibleDataRateFormat())
+        flags |= BinaryFlexibleDataRate;
+    if (frame.hasBitrateSwitch())
+        flags |= BinaryBitRateSwitch;
+    if (frame.hasErrorStateIndicator())
+        flags |= BinaryErrorState;
+    if (frame.hasLocalEcho())
+        flags |= BinaryLocalEcho;
+    return flags;
+}
+
+struct BinaryRecord
+{
+    uint channel = 0;
+    quint8 flags = 0;
+    QCanBusFrame frame;
+};
+
+/*
+    Decodes the record at the start of \a data and returns its total size,
+    0 if the record is not complete yet, or -1 if the record is malformed.
+*/
+static qsizetype decodeBinaryRecord(QByteArrayView data, BinaryRecord *record)
+{
+    if (data.size() < 2)
+        return 0;
+
+    const uchar *raw = reinterpret_cast<const uchar *>(data.data());
+    const qsizetype recordSize = 2 + qFromLittleEndian<quint16>(raw);
+    const qsizetype payloadSize = recordSize - BinaryRecordHeaderSize;
+    if (Q_UNLIKELY(payloadSize < 0 || payloadSize > MaximumPayloadSize))
+        return -1;
+    if (data.size() < recordSize)
+        return 0;
+
+    record->channel = raw[2];
+    record->flags = raw[3];
+
+    QCanBusFrame &frame = record->frame;
+    frame = QCanBusFrame();
+    frame.setFrameId(qFromLittleEndian<quint32>(raw + 4));
+    frame.setTimeStampNanoSeconds(qFromLittleEndian<qint64>(raw + 8));
+    frame.setPayload(data.data() + BinaryRecordHeaderSize, payloadSize);
+    if (record->flags & BinaryRemoteRequest)
+        frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
+    frame.setExtendedFrameFormat(record->flags & BinaryExtendedFormat);
+    frame.setFlexibleDataRateFormat(record->flags & BinaryFlexibleDataRate);
+    frame.setBitrateSwitch(record->flags & BinaryBitRateSwitch);
+    frame.setErrorStateIndicator(record->flags & BinaryErrorState);
+    frame.setLocalEcho(record->flags & BinaryLocalEcho);
+
+    return recordSize;
+}
+
+// Appends all available bytes of \a socket to \a buffer without temporary QByteArrays
+static void readAvailable(QTcpSocket *socket, QByteArray *buffer)
+{
+    const qint64 available = socket->bytesAvailable();
+    if (available <= 0)
+        return;
+
+    const qsizetype offset = buffer->size();
+    buffer->resize(offset + available);
+    const qint64 bytesRead = socket->read(buffer->data() + offset, available);
+    buffer->resize(offset + qMax<qint64>(bytesRead, 0));
+}
+
 VirtualCanServer::VirtualCanServer(QObject *parent)
     : QObject(parent)
 {
@@ -101,9 +328,13 @@ void VirtualCanServer::connected()
     while (m_server->hasPendingConnections()) {
         qCInfo(QT_CANBUS_PLUGINS_VIRTUALCAN, "Server [%p] client connected.", this);
         QTcpSocket *next = m_server->nextPendingConnection();
-        m_serverSockets.append(next);
+        Client client;
+        client.socket = next;
+        m_clients.append(client);
         connect(next, &QIODevice::readyRead, this, &VirtualCanServer::readyRead);
-        connect(next, &QTcpSocket::disconnected, this, &VirtualCanServer::disconnected);
+        // queued, as the client list must not change while readyRead() processes it
+        connect(next, &QTcpSocket::disconnected, this, &VirtualCanServer::disconnected,
+                Qt::QueuedConnection);
     }
 }
 
@@ -114,52 +345,159 @@ void VirtualCanServer::disconnected()
     auto socket = qobject_cast<QTcpSocket *>(sender());
     Q_ASSERT(socket);
 
-    m_serverSockets.removeOne(socket);
+    m_clients.removeIf([socket](const Client &client) { return client.socket == socket; });
     socket->deleteLater();
 }
 
+/*
+    Queues a frame for all clients registered to \a channel except the sender.
+    The frame is converted to the protocol each client uses; the text or binary
+    encoding of the sender is passed in \a text or \a binary and reused as is.
+*/
+void VirtualCanServer::forward(qsizetype senderIndex, uint channel, const QCanBusFrame &frame,
+                               QByteArrayView text, QByteArrayView binary)
+{
+    QByteArray encodedText;
+    QByteArray encodedBinary;
+
+    for (qsizetype i = 0; i < m_clients.size(); ++i) {
+        // Don't send the frame back to its origin
+        if (i == senderIndex)
+            continue;
+
+        Client &client = m_clients[i];
+        if (!client.channels.contains(channel))
+            continue;
+
+        if (client.binaryOutput) {
+            if (binary.isEmpty()) {
+                if (encodedBinary.isEmpty())
+                    encodeBinaryRecord(channel, binaryFlags(frame), frame,
+                                       monotonicNanoSeconds(), &encodedBinary);
+                binary = encodedBinary;
+            }
+            client.writeBuffer.append(binary.data(), binary.size());
+        } else {
+            if (text.isEmpty()) {
+                if (encodedText.isEmpty())
+                    encodeTextFrame(frame, &encodedText);
+                text = encodedText;
+            }
+            client.writeBuffer.append(text.data(), text.size());
+        }
+    }
+}
+
+bool VirtualCanServer::readTextCommand(qsizetype index)
+{
+    Client &client = m_clients[index];
+    QTcpSocket *readSocket = client.socket;
+
+    const QByteArray command = readSocket->readLine().trimmed();
+    qCDebug(QT_CANBUS_PLUGINS_VIRTUALCAN,
+            "Server [%p] received: '%s'.", this, command.constData());
+
+    uint channel = 0;
+    if (command.startsWith("connect:")) {
+        if (channelFromInterface(QByteArrayView(command).mid(int(strlen("connect:"))), &channel))
+            client.channels.append(channel);
+
+    } else if (command.startsWith("disconnect:")) {
+        if (channelFromInterface(QByteArrayView(command).mid(int(strlen("disconnect:"))), &channel))
+            client.channels.removeAll(channel);
+        readSocket->disconnectFromHost();
+
+    } else if (command == ProtocolBinaryRequest) {
+        // acknowledge, all following data to the client is sent in binary records
+        client.writeBuffer.append(ProtocolBinaryRequest).append('\n');
+        client.binaryOutput = true;
+
+    } else if (command == ProtocolBinaryStart) {
+        // all following data from the client is sent in binary records
+        client.binaryInput = true;
+        return false;
+
+    } else {
+        const qsizetype separator = command.indexOf(':');
+        if (Q_UNLIKELY(separator < 0
+                       || !channelFromInterface(QByteArrayView(command).first(separator),
+                                                &channel))) {
+            qCWarning(QT_CANBUS_PLUGINS_VIRTUALCAN,
+                      "Server [%p] received invalid command '%s'.", this, command.constData());
+            return true;
+        }
+
+        // the text encoding is forwarded as is, without the channel prefix
+        const QByteArray text = command.mid(separator + 1) + '\n';
+        QCanBusFrame frame;
+        if (Q_UNLIKELY(!decodeTextFrame(command.mid(separator + 1), &frame))) {
+            qCWarning(QT_CANBUS_PLUGINS_VIRTUALCAN,
+                      "Server [%p] received invalid frame '%s'.", this, command.constData());
+            return true;
+        }
+        forward(index, channel, frame, text, {});
+    }
+    return true;
+}
+
+void VirtualCanServer::readBinaryRecords(qsizetype index)
+{
+    Client &client = m_clients[index];
+    readAvailable(client.socket, &client.readBuffer);
+
+    qsizetype offset = 0;
+    BinaryRecord record;
+    for (;;) {
+        const QByteArrayView data = QByteArrayView(client.readBuffer).sliced(offset);
+        const qsizetype recordSize = decodeBinaryRecord(data, &record);
+        if (recordSize == 0)
+            break;
+        if (Q_UNLIKELY(recordSize < 0)) {
+            qCWarning(QT_CANBUS_PLUGINS_VIRTUALCAN,
+                      "Server [%p] received invalid binary record, closing connection.", this);
+            client.readBuffer.clear();
+            client.socket->disconnectFromHost();
+            return;
+        }
+
+        if (record.flags & BinaryDisconnect) {
+            client.channels.removeAll(record.channel);
+            client.socket->disconnectFromHost();
+        } else {
+            forward(index, record.channel, record.frame, {}, data.first(recordSize));
+        }
+        offset += recordSize;
+    }
+
+    client.readBuffer.remove(0, offset);
+}
+
 void VirtualCanServer::readyRead()
 {
     auto readSocket = qobject_cast<QTcpSocket *>(sender());
     Q_ASSERT(readSocket);
 
-    while (readSocket->canReadLine()) {
-        const QByteArray command = readSocket->readLine().trimmed();
-        qCDebug(QT_CANBUS_PLUGINS_VIRTUALCAN,
-                "Server [%p] received: '%s'.", this, command.constData());
+    const qsizetype index = std::find_if(m_clients.cbegin(), m_clients.cend(),
+                                         [readSocket](const Client &client) {
+        return client.socket == readSocket;
+    }) - m_clients.cbegin();
+    if (Q_UNLIKELY(index == m_clients.size()))
+        return;
 
-        if (command.startsWith("connect:")) {
-            const QVariant interfaces = readSocket->property("interfaces");
-            QStringList list = interfaces.toStringList();
-            list.append(command.mid(int(strlen("connect:"))));
-            readSocket->setProperty("interfaces", list);
+    while (!m_clients.at(index).binaryInput && readSocket->canReadLine()) {
+        if (!readTextCommand(index))
+            break;
+    }
 
-        } else if (command.startsWith("disconnect:")) {
-            const QVariant interfaces = readSocket->property("interfaces");
-            QStringList list = interfaces.toStringList();
-            list.removeAll(command.mid(int(strlen("disconnect:"))));
-            readSocket->setProperty("interfaces", list);
-            readSocket->disconnectFromHost();
+    if (m_clients.at(index).binaryInput)
+        readBinaryRecords(index);
 
-        } else {
-            const QByteArrayList commandList = command.split(':');
-            Q_ASSERT(commandList.size() == 2);
-
-            for (QTcpSocket *writeSocket : qAsConst(m_serverSockets)) {
-                // Don't send the frame back to its origin
-                if (writeSocket == readSocket)
-                    continue;
-
-                // Send frame to all clients registered to the same interface as sender
-                const QVariant property = writeSocket->property("interfaces");
-                if (!property.isValid())
-                    continue;
-
-                const QStringList propertyList = property.toStringList();
-                if (propertyList.contains(commandList.first()))
-                    writeSocket->write(commandList.last() + '\n');
-            }
-        }
+    // send everything received in this call with one write per client
+    for (Client &client : m_clients) {
+        if (client.writeBuffer.isEmpty())
+            continue;
+        client.socket->write(client.writeBuffer);
+        client.writeBuffer.clear();
     }
 }
 
@@ -168,6 +506,8 @@ Q_GLOBAL_STATIC(VirtualCanServer, g_server)
 VirtualCanBackend::VirtualCanBackend(const QString &interface, QObject *parent)
     : QCanBusDevice(parent)
 {
+    setSoftwareFilterEnabled(true);
+
     m_url = QUrl(interface);
     const QString canDevice = m_url.fileName();
 
@@ -208,6 +548,13 @@ bool VirtualCanBackend::open()
     if (address.isLoopback())
         g_server->start(port);
 
+    m_binaryInput = false;
+    m_binaryOutput = false;
+    m_readBuffer.clear();
+    m_writeBuffer.clear();
+    m_framesToFlush = 0;
+    m_bytesToFlush = 0;
+
     m_clientSocket = new QTcpSocket(this);
     m_clientSocket->connectToHost(address, port, QIODevice::ReadWrite);
     connect(m_clientSocket, &QAbstractSocket::connected, this, &VirtualCanBackend::clientConnected);
@@ -221,24 +568,33 @@ void VirtualCanBackend::close()
 {
     qCDebug(QT_CANBUS_PLUGINS_VIRTUALCAN, "Client [%p] sends disconnect to server.", this);
 
-    m_clientSocket->write("disconnect:can" + QByteArray::number(m_channel) + '\n');
+    if (m_binaryOutput) {
+        encodeBinaryRecord(m_channel, BinaryDisconnect, QCanBusFrame(), monotonicNanoSeconds(),
+                           &m_writeBuffer);
+    } else {
+        m_writeBuffer.append("disconnect:can" + QByteArray::number(m_channel) + '\n');
+    }
+    flushWriteBuffer();
 }
 
 void VirtualCanBackend::setConfigurationParameter(ConfigurationKey key, const QVariant &value)
 {
-    if (key == QCanBusDevice::ReceiveOwnKey || key == QCanBusDevice::CanFdKey)
+    if (key == QCanBusDevice::ReceiveOwnKey || key == QCanBusDevice::CanFdKey
+            || key == QCanBusDevice::RawFilterKey) {
         QCanBusDevice::setConfigurationParameter(key, value);
+    }
 }
 
 /*
-    Protocol format: All data is in ASCII, one CAN message per line,
+    Text protocol format: All data is in ASCII, one CAN message per line,
     each line ends with line feed '\n'.
 
-    Format:  "<CAN-Channel>:<Flags>#<CAN-ID>#<Data-Bytes>\n"
-    Example: "can0:XF#123#123456\n"
+    Format:  "<CAN-Channel>:<CAN-ID>#<Flags>#<Data-Bytes>\n"
+    Example: "can0:123#XF#123456\n"
 
     The first part is the destination CAN channel, "can0" or "can1",
-    followed by the flags list:
+    followed by the CAN-ID, the flags list and the data, separated by '#'.
+    The server forwards the message without the CAN channel. Flags are:
 
     * R - Remote Request
     * X - Extended Frame Format
@@ -247,7 +603,12 @@ void VirtualCanBackend::setConfigurationParameter(ConfigurationKey key, const QV
     * E - Error State Indicator
     * L - Local Echo
 
-    Afterwards the CAN-ID and the data follows, both separated by '#'.
+    The text protocol is used until the binary protocol is negotiated:
+    After connecting, the client sends "protocol:binary\n". A server that
+    supports the binary protocol answers with "protocol:binary\n" and sends
+    binary records from then on. When the client receives this answer, it
+    sends "protocol:start\n" and also continues with binary records.
+    Older servers ignore the request, so the text protocol is kept.
 */
 
 bool VirtualCanBackend::writeFrame(const QCanBusFrame &frame)
@@ -257,43 +618,62 @@ bool VirtualCanBackend::writeFrame(const QCanBusFrame &frame)
         return false;
     }
 
-    bool canFdEnabled = configurationParameter(QCanBusDevice::CanFdKey).toBool();
-    if (Q_UNLIKELY(frame.hasFlexibleDataRateFormat() && !canFdEnabled)) {
+    if (Q_UNLIKELY(frame.hasFlexibleDataRateFormat()
+                   && !configurationFlag(QCanBusDevice::CanFdKey))) {
         qCWarning(QT_CANBUS_PLUGINS_VIRTUALCAN,
                 "Error: Cannot write CAN FD frame as CAN FD is not enabled!");
         return false;
     }
 
-    QByteArray flags;
-    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame)
-        flags.append(RemoteRequestFlag);
-    if (frame.hasExtendedFrameFormat())
-        flags.append(ExtendedFormatFlag);
-    if (frame.hasFlexibleDataRateFormat())
-        flags.append(FlexibleDataRateFlag);
-    if (frame.hasBitrateSwitch())
-        flags.append(BitRateSwitchFlag);
-    if (frame.hasErrorStateIndicator())
-        flags.append(ErrorStateFlag);
-    if (frame.hasLocalEcho())
-        flags.append(LocalEchoFlag);
-    const QByteArray frameId = QByteArray::number(frame.frameId());
-    const QByteArray command = "can" + QByteArray::number(m_channel)
-            + ':' + frameId + '#' + flags + '#' + frame.payload().toHex() + '\n';
-    m_clientSocket->write(command);
-
-    if (configurationParameter(QCanBusDevice::ReceiveOwnKey).toBool()) {
-        const qint64 timeStamp = QDateTime::currentDateTime().toMSecsSinceEpoch();
+    const qint64 timeStamp = monotonicNanoSeconds();
+    if (m_binaryOutput) {
+        encodeBinaryRecord(m_channel, binaryFlags(frame), frame, timeStamp, &m_writeBuffer);
+    } else {
+        m_writeBuffer.append("can" + QByteArray::number(m_channel) + ':');
+        encodeTextFrame(frame, &m_writeBuffer);
+    }
+
+    if (configurationFlag(QCanBusDevice::ReceiveOwnKey)) {
         QCanBusFrame echoFrame = frame;
         echoFrame.setLocalEcho(true);
-        echoFrame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(timeStamp * 1000));
+        if (m_binaryInput) {
+            echoFrame.setTimeStampNanoSeconds(timeStamp);
+        } else {
+            echoFrame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(
+                                       QDateTime::currentMSecsSinceEpoch() * 1000));
+        }
         enqueueReceivedFrames({echoFrame});
     }
 
-    emit framesWritten(qint64(1));
+    // all frames written in one event loop iteration are sent at once
+    ++m_framesToFlush;
+    m_bytesToFlush += frame.payloadView().size();
+    if (!m_writeFlushPending) {
+        m_writeFlushPending = true;
+        QMetaObject::invokeMethod(this, &VirtualCanBackend::flushWriteBuffer,
+                                  Qt::QueuedConnection);
+    }
     return true;
 }
 
+void VirtualCanBackend::flushWriteBuffer()
+{
+    m_writeFlushPending = false;
+    if (!m_clientSocket || m_writeBuffer.isEmpty())
+        return;
+
+    m_clientSocket->write(m_writeBuffer);
+    m_writeBuffer.clear();
+
+    if (m_framesToFlush > 0) {
+        const qint64 framesWrittenCount = m_framesToFlush;
+        m_framesToFlush = 0;
+        recordWrittenFrames(framesWrittenCount, m_bytesToFlush);
+        m_bytesToFlush = 0;
+        emit framesWritten(framesWrittenCount);
+    }
+}
+
 QString VirtualCanBackend::interpretErrorFrame(const QCanBusFrame &errorFrame)
 {
     Q_UNUSED(errorFrame);
@@ -327,7 +707,9 @@ QCanBusDeviceInfo VirtualCanBackend::deviceInfo() const
 void VirtualCanBackend::clientConnected()
 {
     qCInfo(QT_CANBUS_PLUGINS_VIRTUALCAN, "Client [%p] socket connected.", this);
-    m_clientSocket->write("connect:can" + QByteArray::number(m_channel) + '\n');
+    m_writeBuffer.append("connect:can" + QByteArray::number(m_channel) + '\n');
+    m_writeBuffer.append(ProtocolBinaryRequest).append('\n');
+    flushWriteBuffer();
 
     setState(QCanBusDevice::ConnectedState);
 }
@@ -341,7 +723,9 @@ void VirtualCanBackend::clientDisconnected()
 
 void VirtualCanBackend::clientReadyRead()
 {
-    while (m_clientSocket->canReadLine()) {
+    m_receivedFrames.clear();
+
+    while (!m_binaryInput && m_clientSocket->canReadLine()) {
         const QByteArray answer = m_clientSocket->readLine().trimmed();
         qCDebug(QT_CANBUS_PLUGINS_VIRTUALCAN, "Client [%p] received: '%s'.",
                 this, answer.constData());
@@ -351,24 +735,59 @@ void VirtualCanBackend::clientReadyRead()
             continue;
         }
 
-        const QByteArrayList list = answer.split('#');
-        Q_ASSERT(list.size() == 3);
+        if (answer == ProtocolBinaryRequest) {
+            // the server supports the binary protocol, use it in both directions
+            m_binaryInput = true;
+            m_writeBuffer.append(ProtocolBinaryStart).append('\n');
+            m_binaryOutput = true;
+            qCDebug(QT_CANBUS_PLUGINS_VIRTUALCAN, "Client [%p] uses binary protocol.", this);
+            break;
+        }
 
-        const QCanBusFrame::FrameId id = list.at(0).toUInt();
-        const QByteArray flags = list.at(1);
-        const QByteArray data = QByteArray::fromHex(list.at(2));
-        const qint64 timeStamp = QDateTime::currentDateTime().toMSecsSinceEpoch();
-        QCanBusFrame frame(id, data);
+        QCanBusFrame frame;
+        if (Q_UNLIKELY(!decodeTextFrame(answer, &frame))) {
+            qCWarning(QT_CANBUS_PLUGINS_VIRTUALCAN, "Client [%p] received invalid frame '%s'.",
+                      this, answer.constData());
+            continue;
+        }
+        const qint64 timeStamp = QDateTime::currentMSecsSinceEpoch();
         frame.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(timeStamp * 1000));
-        if (flags.contains(RemoteRequestFlag))
-            frame.setFrameType(QCanBusFrame::RemoteRequestFrame);
-        frame.setExtendedFrameFormat(flags.contains(ExtendedFormatFlag));
-        frame.setFlexibleDataRateFormat(flags.contains(FlexibleDataRateFlag));
-        frame.setBitrateSwitch(flags.contains(BitRateSwitchFlag));
-        frame.setErrorStateIndicator(flags.contains(ErrorStateFlag));
-        frame.setLocalEcho(flags.contains(LocalEchoFlag));
-        enqueueReceivedFrames({frame});
+        m_receivedFrames.append(frame);
     }
+
+    if (m_binaryInput) {
+        readAvailable(m_clientSocket, &m_readBuffer);
+
+        qsizetype offset = 0;
+        BinaryRecord record;
+        for (;;) {
+            const QByteArrayView data = QByteArrayView(m_readBuffer).sliced(offset);
+            const qsizetype recordSize = decodeBinaryRecord(data, &record);
+            if (recordSize == 0)
+                break;
+            if (Q_UNLIKELY(recordSize < 0)) {
+                setError(tr("Received invalid data from the virtual CAN server."),
+                         QCanBusDevice::ReadError);
+                m_readBuffer.clear();
+                m_clientSocket->disconnectFromHost();
+                return;
+            }
+            offset += recordSize;
+
+            if (record.flags & BinaryDisconnect) {
+                m_clientSocket->disconnectFromHost();
+                continue;
+            }
+            m_receivedFrames.append(record.frame);
+        }
+        m_readBuffer.remove(0, offset);
+    }
+
+    // the protocol switch is sent right away, it must precede all binary records
+    if (!m_writeBuffer.isEmpty() && !m_writeFlushPending)
+        flushWriteBuffer();
+
+    enqueueReceivedFrames(m_receivedFrames);
 }
 
 QT_END_NAMESPACE
@@ -41,6 +41,8 @@
 #include <QtSerialBus/qcanbusdeviceinfo.h>
 #include <QtSerialBus/qcanbusframe.h>
 
+#include <QtCore/qbytearray.h>
+#include <QtCore/qbytearrayview.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qurl.h>
 #include <QtCore/qvariant.h>
@@ -62,12 +64,26 @@ public:
     void start(quint16 port);
 
 private:
+    struct Client
+    {
+        QTcpSocket *socket = nullptr;
+        QList<uint> channels;
+        bool binaryInput = false;   // the client sends binary records
+        bool binaryOutput = false;  // the client receives binary records
+        QByteArray readBuffer;
+        QByteArray writeBuffer;
+    };
+
     void connected();
     void disconnected();
     void readyRead();
+    bool readTextCommand(qsizetype index);
+    void readBinaryRecords(qsizetype index);
+    void forward(qsizetype senderIndex, uint channel, const QCanBusFrame &frame,
+                 QByteArrayView text, QByteArrayView binary);
 
     QTcpServer *m_server = nullptr;
-    QList<QTcpSocket *> m_serverSockets;
+    QList<Client> m_clients;
 };
 
 class VirtualCanBackend : public QCanBusDevice
@@ -98,10 +114,20 @@ private:
     void clientConnected();
     void clientDisconnected();
     void clientReadyRead();
+    void flushWriteBuffer();
 
     QUrl m_url;
     uint m_channel = 0;
     QTcpSocket *m_clientSocket = nullptr;
+
+    bool m_binaryInput = false;
+    bool m_binaryOutput = false;
+    bool m_writeFlushPending = false;
+    qint64 m_framesToFlush = 0;
+    qint64 m_bytesToFlush = 0;
+    QByteArray m_readBuffer;
+    QByteArray m_writeBuffer;
+    QList<QCanBusFrame> m_receivedFrames;
 };
 
 QT_END_NAMESPACE
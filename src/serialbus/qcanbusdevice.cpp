@@ -45,8 +45,18 @@
 #include <QtCore/qeventloop.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qscopedvaluerollback.h>
+#include <QtCore/qscopeguard.h>
 #include <QtCore/qtimer.h>
 
+#include <algorithm>
+#include <chrono>
+
+#if defined(Q_OS_LINUX)
+#  include <sched.h>
+#elif defined(Q_OS_WIN)
+#  include <QtCore/qt_windows.h>
+#endif
+
 QT_BEGIN_NAMESPACE
 
 Q_LOGGING_CATEGORY(QT_CANBUS, "qt.canbus")
@@ -126,6 +136,24 @@ Q_LOGGING_CATEGORY(QT_CANBUS, "qt.canbus")
     \value ProtocolKey      This key allows to specify another protocol. For now, this
                             parameter can only be set and used in the SocketCAN plugin.
                             This enum value was introduced in Qt 5.14.
+    \value FrameBatchSizeKey This key defines the maximum number of CAN frames that are
+                            exchanged with the CAN driver in a single system call. A value
+                            greater than 1 enables batched reading and writing. The expected
+                            value for this key is \c int. For now, this parameter can only be
+                            set and used in the SocketCAN plugin.
+                            This enum value was introduced in Qt 6.3.
+    \value TimeStampSourceKey This key defines where the timestamps of received CAN
+                            frames are taken from. The expected value for this key is
+                            QCanBusDevice::TimeStampSource. For now, this parameter can
+                            only be set and used in the SocketCAN plugin.
+                            This enum value was introduced in Qt 6.3.
+    \value PayloadFilterKey This key determines the CAN bus frames that the current device
+                            accepts, based on their identifier and payload. The expected value
+                            is \c QList<QCanBusDevice::PayloadFilter>. Passing an empty list
+                            clears the filters. For more details see
+                            \l QCanBusDevice::PayloadFilter. For now, this parameter can only
+                            be set and used in the SocketCAN plugin.
+                            This enum value was introduced in Qt 6.3.
     \value UserKey          This key defines the range where custom keys start. Its most
                             common purpose is to permit platform-specific configuration
                             options.
@@ -231,6 +259,86 @@ Q_LOGGING_CATEGORY(QT_CANBUS, "qt.canbus")
     By default this field is set to \l QCanBusDevice::Filter::MatchBaseAndExtendedFormat.
 */
 
+/*!
+    \class QCanBusDevice::PayloadFilter
+    \inmodule QtSerialBus
+    \since 6.3
+
+    \brief The QCanBusDevice::PayloadFilter struct defines a filter for CAN bus
+    frames that also matches payload bytes.
+
+    A list of QCanBusDevice::PayloadFilter instances is passed to
+    \l QCanBusDevice::setConfigurationParameter() with the
+    \l {QCanBusDevice::}{PayloadFilterKey}. If a received CAN frame matches at
+    least one of the filters in the list, the QCanBusDevice will accept it.
+
+    A frame matches a filter if it matches \l filter, and if for every byte
+    \c i of \l payload:
+
+    \code
+        (receivedPayload[i] & payloadMask[i]) == (payload[i] & payloadMask[i])
+    \endcode
+
+    Bytes with a zero mask are not compared, so a filter can match a byte at
+    any position. A frame whose payload is too short for the last compared byte
+    does not match.
+
+    The following filter accepts J1939 TP.CM frames from any source address
+    that announce a transfer of the parameter group 0xFECA:
+
+    \code
+        QCanBusDevice::PayloadFilter dm1;
+        dm1.filter.frameId = 0x00ec0000;
+        dm1.filter.frameIdMask = 0x00ff0000;
+        dm1.filter.format = QCanBusDevice::Filter::MatchExtendedFormat;
+        dm1.payload = QByteArray::fromHex("0000000000cafe00");
+        dm1.payloadMask = QByteArray::fromHex("0000000000ffffff");
+    \endcode
+
+    The SocketCAN plugin compiles the list into a socket filter program, so
+    that the kernel drops frames that match none of the filters.
+*/
+
+/*!
+    \fn bool QCanBusDevice::PayloadFilter::operator==(const QCanBusDevice::PayloadFilter &a, const QCanBusDevice::PayloadFilter &b)
+
+    Returns \c true, if the filter \a a is equal to the filter \a b,
+    otherwise returns \c false.
+*/
+
+/*!
+    \fn bool QCanBusDevice::PayloadFilter::operator!=(const QCanBusDevice::PayloadFilter &a, const QCanBusDevice::PayloadFilter &b)
+
+    Returns \c true, if the filter \a a is not equal to the filter \a b,
+    otherwise returns \c false.
+*/
+
+/*!
+    \variable QCanBusDevice::PayloadFilter::filter
+
+    \brief The identifier, frame type and frame format the frame must match.
+
+    \sa QCanBusDevice::Filter
+*/
+
+/*!
+    \variable QCanBusDevice::PayloadFilter::payload
+
+    \brief The payload bytes the frame must match, starting with its first byte.
+
+    By default this field is empty, and the payload is not compared.
+*/
+
+/*!
+    \variable QCanBusDevice::PayloadFilter::payloadMask
+
+    \brief The bit masks that are applied to the bytes of \l payload and the
+    received payload.
+
+    If the mask is shorter than \l payload, the remaining bytes are compared
+    with the mask \c 0xff.
+*/
+
 /*!
     \fn void QCanBusDevice::errorOccurred(CanBusError)
 
@@ -251,7 +359,8 @@ QCanBusDevice::QCanBusDevice(QObject *parent) :
     \a errorText. \a errorId categorizes the type of error.
 
     CAN bus implementations must use this function to update the device's
-    error state.
+    error state. If it is called from the I/O thread, the error is reported
+    asynchronously in the thread the device lives in.
 
     \sa error(), errorOccurred(), clearError()
 */
@@ -259,8 +368,16 @@ void QCanBusDevice::setError(const QString &errorText, CanBusError errorId)
 {
     Q_D(QCanBusDevice);
 
+    if (Q_UNLIKELY(QThread::currentThread() != thread())) {
+        QMetaObject::invokeMethod(this, [this, errorText, errorId]() {
+            setError(errorText, errorId);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
     d->errorText = errorText;
     d->lastError = errorId;
+    d->statistics.errors.fetchAndAddRelaxed(1);
 
     emit errorOccurred(errorId);
 }
@@ -288,8 +405,17 @@ void QCanBusDevice::clearError()
     accessed using \l readFrame() and emits the \l framesReceived()
     signal.
 
+    If the receive queue is full, frames are handled according to
+    receiveQueueOverflowPolicy(). The first time frames are discarded after
+    the device was connected, a \l ReadError is reported. If a frame handler is set, the frames
+    are passed to it instead, see setFrameHandler(). If the software filter
+    is enabled, frames that do not match the \l RawFilterKey are dropped
+    first, see setSoftwareFilterEnabled().
+
     Subclasses must call this function when they receive frames.
+    This function must not be called from more than one thread at a time.
 
+    \sa receiveQueueCapacity()
 */
 void QCanBusDevice::enqueueReceivedFrames(const QList<QCanBusFrame> &newFrames)
 {
@@ -298,10 +424,115 @@ void QCanBusDevice::enqueueReceivedFrames(const QList<QCanBusFrame> &newFrames)
     if (Q_UNLIKELY(newFrames.isEmpty()))
         return;
 
-    d->incomingFramesGuard.lock();
-    d->incomingFrames.append(newFrames);
-    d->incomingFramesGuard.unlock();
-    emit framesReceived();
+    QCanBusStatisticsCounters &statistics = d->statistics;
+    const auto start = std::chrono::steady_clock::now();
+    const auto recordDuration = qScopeGuard([&statistics, start]() {
+        const auto duration = std::chrono::steady_clock::now() - start;
+        statistics.enqueueDuration.record(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    });
+
+    qint64 receivedBytes = 0;
+    for (const QCanBusFrame &frame : newFrames)
+        receivedBytes += frame.payloadView().size();
+    statistics.receivedFrames.fetchAndAddRelaxed(newFrames.size());
+    statistics.receivedBytes.fetchAndAddRelaxed(receivedBytes);
+
+    const QList<QCanBusFrame> *frames = &newFrames;
+    if (d->softwareFilterEnabled.loadRelaxed()) {
+        QMutexLocker locker(&d->frameFilterMutex);
+        if (!d->frameFilter.acceptsAll()) {
+            // filteredFrames keeps its capacity, only the receiving thread uses it
+            d->filteredFrames.clear();
+            for (const QCanBusFrame &frame : newFrames) {
+                if (d->frameFilter.matches(frame))
+                    d->filteredFrames.append(frame);
+            }
+            frames = &d->filteredFrames;
+            statistics.filteredFrames.fetchAndAddRelaxed(newFrames.size() - frames->size());
+        }
+    }
+    if (frames->isEmpty())
+        return;
+
+    if (d->frameHandler) {
+        // the frames are not queued, so they count as read when handed over
+        d->recordReceiveLatency(frames->constData(), frames->size());
+        d->frameHandler(frames->constData(), frames->size());
+        return;
+    }
+
+    const auto policy = ReceiveQueueOverflowPolicy(d->overflowPolicy.loadRelaxed());
+    const quint64 droppedBefore = d->incomingFrames.droppedFrames();
+    bool enqueued = false;
+    for (const QCanBusFrame &frame : *frames)
+        enqueued |= d->incomingFrames.enqueue(frame, policy);
+
+    if (Q_UNLIKELY(d->incomingFrames.droppedFrames() != droppedBefore)
+            && !d->overflowReported.loadRelaxed()) {
+        d->overflowReported.storeRelaxed(true);
+        const QString error = tr("The receive queue is full, received frames are discarded.");
+        qCWarning(QT_CANBUS, "%ls", qUtf16Printable(error));
+        setError(error, CanBusError::ReadError);
+    }
+
+    // only this thread raises the peak, resetStatistics() may lower it
+    const qint64 queued = d->incomingFrames.size();
+    if (queued > statistics.peakFramesAvailable.loadRelaxed())
+        statistics.peakFramesAvailable.storeRelaxed(queued);
+
+    if (enqueued)
+        emit framesReceived();
+}
+
+/*!
+    \since 6.3
+
+    Adds \a frameCount frames with a total of \a payloadBytes payload bytes to
+    the transmit counters of statistics().
+
+    Subclasses call this function when they hand over frames to the CAN
+    driver, usually next to emitting framesWritten().
+
+    \sa statistics()
+*/
+void QCanBusDevice::recordWrittenFrames(qint64 frameCount, qint64 payloadBytes)
+{
+    Q_D(QCanBusDevice);
+
+    d->statistics.transmittedFrames.fetchAndAddRelaxed(frameCount);
+    d->statistics.transmittedBytes.fetchAndAddRelaxed(payloadBytes);
+}
+
+/*!
+    \since 6.3
+
+    Enables matching received frames against the \l RawFilterKey in software
+    if \a enabled is \c true.
+
+    Subclasses whose hardware or driver cannot filter frames call this function
+    in their constructor, and accept the \l RawFilterKey in
+    setConfigurationParameter(). The filter list is then compiled into lookup
+    tables, and enqueueReceivedFrames() drops frames that match none of the
+    filters before they are queued. Error frames are not matched against the
+    filters, as with SocketCAN they are selected by the \l ErrorFilterKey.
+
+    \sa enqueueReceivedFrames(), QCanBusDevice::Filter
+*/
+void QCanBusDevice::setSoftwareFilterEnabled(bool enabled)
+{
+    Q_D(QCanBusDevice);
+
+    QCanBusFrameFilter filter;
+    if (enabled) {
+        const QVariant filters = configurationParameter(RawFilterKey);
+        if (filters.isValid())
+            filter = QCanBusFrameFilter(qvariant_cast<QList<Filter>>(filters));
+    }
+
+    QMutexLocker locker(&d->frameFilterMutex);
+    d->frameFilter = std::move(filter);
+    d->softwareFilterEnabled.storeRelaxed(enabled);
 }
 
 /*!
@@ -315,6 +546,8 @@ void QCanBusDevice::enqueueOutgoingFrame(const QCanBusFrame &newFrame)
     Q_D(QCanBusDevice);
 
     d->outgoingFrames.append(newFrame);
+    if (d->outgoingFrames.size() > d->outgoingHighWaterMark.loadRelaxed())
+        d->outgoingHighWaterMark.storeRelaxed(d->outgoingFrames.size());
 }
 
 /*!
@@ -342,6 +575,43 @@ bool QCanBusDevice::hasOutgoingFrames() const
     return !d->outgoingFrames.isEmpty();
 }
 
+/*!
+    \since 6.3
+
+    Copies up to \a maxFrames frames from the front of the internal list of
+    outgoing frames to \a frames, without removing them. Returns the number
+    of frames copied.
+
+    Subclasses whose driver accepts several frames at once can use this
+    together with discardOutgoingFrames() to hand over the whole queue and
+    keep the frames the driver did not accept.
+
+    \sa discardOutgoingFrames(), dequeueOutgoingFrame()
+*/
+qsizetype QCanBusDevice::peekOutgoingFrames(QCanBusFrame *frames, qsizetype maxFrames) const
+{
+    Q_D(const QCanBusDevice);
+
+    const qsizetype count = qBound(qsizetype(0), maxFrames, d->outgoingFrames.size());
+    std::copy_n(d->outgoingFrames.cbegin(), count, frames);
+    return count;
+}
+
+/*!
+    \since 6.3
+
+    Removes the first \a count frames from the internal list of outgoing frames.
+
+    \sa peekOutgoingFrames()
+*/
+void QCanBusDevice::discardOutgoingFrames(qsizetype count)
+{
+    Q_D(QCanBusDevice);
+
+    count = qBound(qsizetype(0), count, d->outgoingFrames.size());
+    d->outgoingFrames.remove(0, count);
+}
+
 /*!
     Sets the configuration parameter \a key for the CAN bus connection
     to \a value. The potential keys are represented by \l ConfigurationKey.
@@ -353,30 +623,25 @@ bool QCanBusDevice::hasOutgoingFrames() const
     \note In most cases, configuration changes only take effect
     after a reconnect.
 
+    If the stored value changes, configurationParameterChanged() is emitted.
+
     \sa configurationParameter()
 */
 void QCanBusDevice::setConfigurationParameter(ConfigurationKey key, const QVariant &value)
 {
     Q_D(QCanBusDevice);
 
-    for (int i = 0; i < d->configOptions.size(); i++) {
-        if (d->configOptions.at(i).first == key) {
-            if (value.isValid()) {
-                ConfigEntry entry = d->configOptions.at(i);
-                entry.second = value;
-                d->configOptions.replace(i, entry);
-            } else {
-                d->configOptions.remove(i);
-            }
-            return;
-        }
-    }
+    if (key == RawFilterKey && d->softwareFilterEnabled.loadRelaxed()) {
+        QCanBusFrameFilter filter;
+        if (value.isValid())
+            filter = QCanBusFrameFilter(qvariant_cast<QList<Filter>>(value));
 
-    if (!value.isValid())
-        return;
+        QMutexLocker locker(&d->frameFilterMutex);
+        d->frameFilter = std::move(filter);
+    }
 
-    ConfigEntry newEntry(key, value);
-    d->configOptions.append(newEntry);
+    if (d->configuration.setValue(key, value))
+        emit configurationParameterChanged(key);
 }
 
 /*!
@@ -387,14 +652,7 @@ void QCanBusDevice::setConfigurationParameter(ConfigurationKey key, const QVaria
 */
 QVariant QCanBusDevice::configurationParameter(ConfigurationKey key) const
 {
-    Q_D(const QCanBusDevice);
-
-    for (const ConfigEntry &e : d->configOptions) {
-        if (e.first == key)
-            return e.second;
-    }
-
-    return QVariant();
+    return d_func()->configuration.value(key);
 }
 
 /*!
@@ -406,13 +664,42 @@ QVariant QCanBusDevice::configurationParameter(ConfigurationKey key) const
 */
 QList<QCanBusDevice::ConfigurationKey> QCanBusDevice::configurationKeys() const
 {
-    Q_D(const QCanBusDevice);
+    return d_func()->configuration.keys();
+}
+
+/*!
+    \since 6.3
 
-    QList<ConfigurationKey> result;
-    for (const ConfigEntry &e : d->configOptions)
-        result.append(e.first);
+    Returns the value of the configuration parameter \a key converted to
+    \c bool, or \c false if the parameter is not set.
 
-    return result;
+    Unlike configurationParameter(), the lookup of the keys defined in
+    \l ConfigurationKey takes constant time and does not copy a QVariant.
+    Plugins should use this function for parameters that are checked for
+    every frame, like \l CanFdKey or \l ReceiveOwnKey.
+
+    \sa configurationInteger(), configurationParameterChanged()
+*/
+bool QCanBusDevice::configurationFlag(ConfigurationKey key) const
+{
+    return d_func()->configuration.flag(key);
+}
+
+/*!
+    \since 6.3
+
+    Returns the value of the configuration parameter \a key converted to an
+    integer, or \a defaultValue if the parameter is not set or cannot be
+    converted.
+
+    Like configurationFlag(), the lookup takes constant time for the keys
+    defined in \l ConfigurationKey.
+
+    \sa configurationFlag()
+*/
+qint64 QCanBusDevice::configurationInteger(ConfigurationKey key, qint64 defaultValue) const
+{
+    return d_func()->configuration.integer(key, defaultValue);
 }
 
 /*!
@@ -452,6 +739,530 @@ qint64 QCanBusDevice::framesAvailable() const
     return d_func()->incomingFrames.size();
 }
 
+/*!
+    \since 6.3
+
+    Sets the maximum number of received frames that are kept until they are
+    read with readFrame() or readAllFrames() to \a capacity. The capacity is
+    rounded up to the next power of two. The default capacity is 4096 frames.
+
+    When frames are discarded because the queue is full for the first time
+    after the device was connected, errorOccurred() is emitted with
+    \l ReadError. droppedFramesCount() returns the number of all discarded
+    frames.
+
+    The capacity can only be changed while the device is not connected.
+
+    \sa receiveQueueCapacity(), setReceiveQueueOverflowPolicy()
+*/
+void QCanBusDevice::setReceiveQueueCapacity(qsizetype capacity)
+{
+    Q_D(QCanBusDevice);
+
+    if (Q_UNLIKELY(d->state != UnconnectedState)) {
+        const QString error = tr("Cannot change the receive queue capacity of a connected device.");
+        qCWarning(QT_CANBUS, "%ls", qUtf16Printable(error));
+        setError(error, CanBusError::OperationError);
+        return;
+    }
+
+    d->incomingFrames.setCapacity(capacity);
+}
+
+/*!
+    \since 6.3
+
+    Returns the maximum number of received frames that are kept until they are read.
+
+    \sa setReceiveQueueCapacity(), framesAvailable()
+*/
+qsizetype QCanBusDevice::receiveQueueCapacity() const
+{
+    return d_func()->incomingFrames.capacity();
+}
+
+/*!
+    \since 6.3
+    \enum QCanBusDevice::ReceiveQueueOverflowPolicy
+
+    This enum describes what happens to received frames if the receive queue is full.
+
+    \value DropOldest  The oldest frame in the queue is discarded.
+    \value DropNewest  The newly received frame is discarded. This is the default.
+    \value Block       The CAN plugin waits until frames are read from another thread.
+                       If no other thread reads frames, the newly received frame is
+                       discarded instead. The plugin waits for at most 100 milliseconds;
+                       if no frame was read by then, the frame is discarded, and
+                       further frames are discarded without waiting until frames are
+                       read again. The plugin does not wait while the device is
+                       closing.
+
+    \sa setReceiveQueueOverflowPolicy(), droppedFramesCount()
+*/
+
+/*!
+    \since 6.3
+
+    Sets the overflow policy of the receive queue to \a policy.
+
+    \sa receiveQueueOverflowPolicy(), setReceiveQueueCapacity()
+*/
+void QCanBusDevice::setReceiveQueueOverflowPolicy(ReceiveQueueOverflowPolicy policy)
+{
+    d_func()->overflowPolicy.storeRelaxed(int(policy));
+}
+
+/*!
+    \since 6.3
+
+    Returns the overflow policy of the receive queue.
+
+    \sa setReceiveQueueOverflowPolicy()
+*/
+QCanBusDevice::ReceiveQueueOverflowPolicy QCanBusDevice::receiveQueueOverflowPolicy() const
+{
+    return ReceiveQueueOverflowPolicy(d_func()->overflowPolicy.loadRelaxed());
+}
+
+/*!
+    \since 6.3
+
+    Returns the number of received frames that were discarded because the
+    receive queue was full.
+
+    \sa receiveQueueOverflowPolicy(), receiveQueueCapacity()
+*/
+quint64 QCanBusDevice::droppedFramesCount() const
+{
+    return d_func()->incomingFrames.droppedFrames();
+}
+
+/*!
+    \class QCanBusDevice::Statistics
+    \inmodule QtSerialBus
+    \since 6.3
+
+    \brief The QCanBusDevice::Statistics struct holds the counters of a CAN bus device.
+
+    A snapshot is returned by QCanBusDevice::statistics(). The counters are
+    updated without locking, so a snapshot taken while frames are received
+    is not necessarily consistent between the individual counters.
+
+    The histograms have \l HistogramBucketCount buckets of nanoseconds.
+    Bucket \c i counts the durations \c d with \c {2^(i - 1) <= d < 2^i},
+    bucket 0 the durations below one nanosecond and the last bucket all
+    durations that are longer.
+
+    \sa QCanBusDevice::statistics(), QCanBusDevice::resetStatistics()
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::receivedFrames
+
+    \brief The number of frames received by the plugin, including frames
+    that were filtered out or dropped afterwards.
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::receivedBytes
+
+    \brief The number of payload bytes of \l receivedFrames.
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::transmittedFrames
+
+    \brief The number of frames the plugin handed over to the CAN driver.
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::transmittedBytes
+
+    \brief The number of payload bytes of \l transmittedFrames.
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::errors
+
+    \brief The number of errors reported with errorOccurred().
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::droppedFrames
+
+    \brief The number of received frames that were discarded because the
+    receive queue was full.
+
+    \sa QCanBusDevice::droppedFramesCount()
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::filteredFrames
+
+    \brief The number of received frames that were discarded by the software
+    filter of the plugin.
+
+    \sa QCanBusDevice::RawFilterKey
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::peakFramesAvailable
+
+    \brief The largest number of frames that were waiting in the receive queue.
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::peakFramesToWrite
+
+    \brief The largest number of frames that were waiting to be written.
+
+    \sa QCanBusDevice::framesToWriteHighWaterMark()
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::receiveLatencyHistogram
+
+    \brief The delay from the timestamp of a received frame until it was read
+    with readFrame(), readFrames() or readAllFrames(), or until it was passed
+    to the frame handler, see setFrameHandler().
+
+    Only timestamps taken from the system clock, like the kernel timestamps
+    of the SocketCAN plugin, can be compared with the time of reading. Frames
+    whose timestamp is more than 60 seconds away are not counted.
+*/
+
+/*!
+    \variable QCanBusDevice::Statistics::enqueueDurationHistogram
+
+    \brief The time spent in each call of enqueueReceivedFrames(), including
+    a frame handler.
+*/
+
+/*!
+    \since 6.3
+
+    Returns a snapshot of the device's counters since it was created or since
+    the last call to resetStatistics().
+
+    This function may be called from any thread.
+
+    \sa resetStatistics()
+*/
+QCanBusDevice::Statistics QCanBusDevice::statistics() const
+{
+    Q_D(const QCanBusDevice);
+
+    const QCanBusStatisticsCounters &counters = d->statistics;
+
+    Statistics result;
+    result.receivedFrames = counters.receivedFrames.loadRelaxed();
+    result.receivedBytes = counters.receivedBytes.loadRelaxed();
+    result.transmittedFrames = counters.transmittedFrames.loadRelaxed();
+    result.transmittedBytes = counters.transmittedBytes.loadRelaxed();
+    result.errors = counters.errors.loadRelaxed();
+    result.droppedFrames = d->incomingFrames.droppedFrames()
+            - counters.droppedFramesOffset.loadRelaxed();
+    result.filteredFrames = counters.filteredFrames.loadRelaxed();
+    result.peakFramesAvailable = counters.peakFramesAvailable.loadRelaxed();
+    result.peakFramesToWrite = d->outgoingHighWaterMark.loadRelaxed();
+    result.receiveLatencyHistogram = counters.receiveLatency.snapshot();
+    result.enqueueDurationHistogram = counters.enqueueDuration.snapshot();
+    return result;
+}
+
+/*!
+    \since 6.3
+
+    Sets all counters returned by statistics() to zero. The peak queue sizes
+    are set to the current queue sizes.
+
+    \sa statistics(), resetFramesToWriteHighWaterMark()
+*/
+void QCanBusDevice::resetStatistics()
+{
+    Q_D(QCanBusDevice);
+
+    QCanBusStatisticsCounters &counters = d->statistics;
+    counters.receivedFrames.storeRelaxed(0);
+    counters.receivedBytes.storeRelaxed(0);
+    counters.transmittedFrames.storeRelaxed(0);
+    counters.transmittedBytes.storeRelaxed(0);
+    counters.errors.storeRelaxed(0);
+    counters.droppedFramesOffset.storeRelaxed(d->incomingFrames.droppedFrames());
+    counters.filteredFrames.storeRelaxed(0);
+    counters.peakFramesAvailable.storeRelaxed(d->incomingFrames.size());
+    counters.receiveLatency.reset();
+    counters.enqueueDuration.reset();
+    resetFramesToWriteHighWaterMark();
+}
+
+/*!
+    \since 6.3
+
+    Enables the dedicated I/O thread if \a enabled is \c true.
+
+    By default, CAN plugins receive frames in the thread the device lives in.
+    If that thread's event loop is busy, for example with a slow user interface,
+    the buffers of the CAN driver may overflow. With the I/O thread enabled,
+    plugins that support it receive frames on an internal thread instead. Frames
+    are passed to the application through the receive queue, and
+    framesReceived() is delivered as a queued signal. Frames are still written,
+    and all signals delivered, in the thread the device lives in.
+
+    The I/O thread can only be enabled or disabled while the device is not
+    connected.
+
+    \note Only some plugins support the I/O thread. Other plugins ignore this
+    setting. Please refer to the plugins help pages for more information.
+
+    \sa isIoThreadEnabled(), setIoThreadPriority(), setIoThreadAffinity()
+*/
+void QCanBusDevice::setIoThreadEnabled(bool enabled)
+{
+    Q_D(QCanBusDevice);
+
+    if (Q_UNLIKELY(d->state != UnconnectedState)) {
+        const QString error = tr("Cannot change the I/O thread of a connected device.");
+        qCWarning(QT_CANBUS, "%ls", qUtf16Printable(error));
+        setError(error, CanBusError::OperationError);
+        return;
+    }
+
+    d->ioThreadEnabled = enabled;
+}
+
+/*!
+    \since 6.3
+
+    Returns \c true if the dedicated I/O thread is enabled; otherwise \c false.
+    The default is \c false.
+
+    \sa setIoThreadEnabled()
+*/
+bool QCanBusDevice::isIoThreadEnabled() const
+{
+    return d_func()->ioThreadEnabled;
+}
+
+/*!
+    \since 6.3
+
+    Sets the scheduling priority of the I/O thread to \a priority. If the I/O
+    thread is already running, the new priority is applied immediately.
+    The default is QThread::InheritPriority.
+
+    \sa ioThreadPriority(), setIoThreadEnabled()
+*/
+void QCanBusDevice::setIoThreadPriority(QThread::Priority priority)
+{
+    Q_D(QCanBusDevice);
+
+    d->ioThreadPriority = priority;
+    if (d->ioThread && d->ioThread->isRunning() && priority != QThread::InheritPriority)
+        d->ioThread->setPriority(priority);
+}
+
+/*!
+    \since 6.3
+
+    Returns the scheduling priority of the I/O thread.
+
+    \sa setIoThreadPriority()
+*/
+QThread::Priority QCanBusDevice::ioThreadPriority() const
+{
+    return d_func()->ioThreadPriority;
+}
+
+/*!
+    \since 6.3
+
+    Restricts the I/O thread to run on the CPU cores with the indexes listed
+    in \a cpus. An empty list, the default, lets the operating system choose.
+
+    The affinity is applied when the I/O thread is started, it can only be
+    changed while the device is not connected.
+
+    \note CPU affinity is only supported on Linux and Windows.
+
+    \sa ioThreadAffinity(), setIoThreadEnabled()
+*/
+void QCanBusDevice::setIoThreadAffinity(const QList<int> &cpus)
+{
+    Q_D(QCanBusDevice);
+
+    if (Q_UNLIKELY(d->state != UnconnectedState)) {
+        const QString error = tr("Cannot change the I/O thread of a connected device.");
+        qCWarning(QT_CANBUS, "%ls", qUtf16Printable(error));
+        setError(error, CanBusError::OperationError);
+        return;
+    }
+
+    d->ioThreadAffinity = cpus;
+}
+
+/*!
+    \since 6.3
+
+    Returns the indexes of the CPU cores the I/O thread may run on.
+
+    \sa setIoThreadAffinity()
+*/
+QList<int> QCanBusDevice::ioThreadAffinity() const
+{
+    return d_func()->ioThreadAffinity;
+}
+
+/*!
+    \typedef QCanBusDevice::FrameHandler
+    \since 6.3
+
+    Synonym for \c{std::function<void(const QCanBusFrame *frames, qsizetype count)>}.
+    A frame handler is called with \a count received frames starting at \a frames.
+
+    \sa setFrameHandler()
+*/
+
+/*!
+    \since 6.3
+
+    Sets \a handler to be called for all received frames, instead of storing
+    them in the receive queue.
+
+    The handler is called synchronously by the CAN plugin as soon as frames are
+    received, without copying the frames and without signal-slot dispatch. The
+    frames are only valid for the duration of the call. While a handler is set,
+    framesReceived() is not emitted and readFrame(), readFrames() and
+    readAllFrames() return no frames. Pass an empty handler to return to the
+    receive queue.
+
+    The handler is called in the thread that receives the frames. This is the
+    I/O thread if it is enabled, otherwise the thread the device lives in.
+    The handler must return quickly and must not call back into the device.
+
+    The frame handler can only be changed while the device is not connected.
+
+    \sa frameHandler(), setIoThreadEnabled()
+*/
+void QCanBusDevice::setFrameHandler(const FrameHandler &handler)
+{
+    Q_D(QCanBusDevice);
+
+    if (Q_UNLIKELY(d->state != UnconnectedState)) {
+        const QString error = tr("Cannot change the frame handler of a connected device.");
+        qCWarning(QT_CANBUS, "%ls", qUtf16Printable(error));
+        setError(error, CanBusError::OperationError);
+        return;
+    }
+
+    d->frameHandler = handler;
+}
+
+/*!
+    \since 6.3
+
+    Returns the handler that is called for received frames, or an empty
+    function if received frames are stored in the receive queue.
+
+    \sa setFrameHandler()
+*/
+QCanBusDevice::FrameHandler QCanBusDevice::frameHandler() const
+{
+    return d_func()->frameHandler;
+}
+
+static bool setCurrentThreadAffinity(const QList<int> &cpus)
+{
+#if defined(Q_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(Q_OS_WIN)
+    DWORD_PTR mask = 0;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < int(sizeof(mask) * 8))
+            mask |= DWORD_PTR(1) << cpu;
+    }
+    return ::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0;
+#else
+    Q_UNUSED(cpus);
+    return false;
+#endif
+}
+
+/*!
+    \since 6.3
+
+    Starts the I/O thread and returns it, if the I/O thread is enabled.
+    Otherwise returns \c nullptr.
+
+    CAN plugins that support the I/O thread call this function from their
+    \l open() implementation and move the objects that receive frames, for
+    example a QSocketNotifier, to the returned thread. Those objects may call
+    enqueueReceivedFrames() and setError() from the I/O thread. The thread is
+    owned by the device.
+
+    \sa stopIoThread(), setIoThreadEnabled()
+*/
+QThread *QCanBusDevice::startIoThread()
+{
+    Q_D(QCanBusDevice);
+
+    if (!d->ioThreadEnabled)
+        return nullptr;
+
+    if (!d->ioThread) {
+        d->ioThread = new QThread;
+        d->ioThread->setObjectName(QStringLiteral("QCanBusDevice I/O"));
+        // QThread::started() is emitted from the new thread
+        connect(d->ioThread, &QThread::started, d->ioThread, [d]() {
+            if (d->ioThreadAffinity.isEmpty())
+                return;
+            if (Q_UNLIKELY(!setCurrentThreadAffinity(d->ioThreadAffinity)))
+                qCWarning(QT_CANBUS, "Cannot set the CPU affinity of the I/O thread.");
+        }, Qt::DirectConnection);
+    }
+
+    if (!d->ioThread->isRunning())
+        d->ioThread->start(d->ioThreadPriority);
+
+    return d->ioThread;
+}
+
+/*!
+    \since 6.3
+
+    Stops the I/O thread and waits until it has finished. Objects that were
+    moved to the I/O thread and scheduled for deletion with
+    QObject::deleteLater() are deleted before this function returns.
+
+    CAN plugins call this function from their \l close() implementation,
+    before releasing the resources used by the I/O thread.
+
+    \sa startIoThread()
+*/
+void QCanBusDevice::stopIoThread()
+{
+    Q_D(QCanBusDevice);
+
+    if (!d->ioThread || !d->ioThread->isRunning())
+        return;
+
+    if (Q_UNLIKELY(QThread::currentThread() == d->ioThread)) {
+        qCWarning(QT_CANBUS, "Cannot stop the I/O thread from within the I/O thread.");
+        return;
+    }
+
+    // a plugin that waits for room in the receive queue returns right away
+    d->incomingFrames.setStopped(true);
+    d->ioThread->quit();
+    d->ioThread->wait();
+}
+
 /*!
     For buffered devices, this function returns the number of frames waiting to be written.
     For unbuffered devices, this function always returns zero.
@@ -467,6 +1278,38 @@ qint64 QCanBusDevice::framesToWrite() const
     return d_func()->outgoingFrames.size();
 }
 
+/*!
+    \since 6.3
+
+    Returns the largest number of frames that were waiting to be written at
+    the same time since the device was created, or since the last call to
+    resetFramesToWriteHighWaterMark().
+
+    Together with framesToWrite(), this shows how close the outgoing queue
+    comes to building up under bursty traffic.
+
+    \sa framesToWrite(), resetFramesToWriteHighWaterMark()
+*/
+qint64 QCanBusDevice::framesToWriteHighWaterMark() const
+{
+    return d_func()->outgoingHighWaterMark.loadRelaxed();
+}
+
+/*!
+    \since 6.3
+
+    Resets the high-water mark of the outgoing queue to the number of frames
+    currently waiting to be written.
+
+    \sa framesToWriteHighWaterMark()
+*/
+void QCanBusDevice::resetFramesToWriteHighWaterMark()
+{
+    Q_D(QCanBusDevice);
+
+    d->outgoingHighWaterMark.storeRelaxed(d->outgoingFrames.size());
+}
+
 /*!
     \since 5.14
 
@@ -518,6 +1361,22 @@ bool QCanBusDevice::hasBusStatus() const
                     (disconnected from the CAN bus)
 */
 
+/*!
+    \since 6.3
+    \enum QCanBusDevice::TimeStampSource
+
+    This enum describes the possible sources of the timestamps of received
+    CAN frames, see QCanBusDevice::TimeStampSourceKey.
+
+    \value Software The timestamp is taken from the system clock when the frame
+                    is read by the CAN plugin.
+    \value Kernel   The timestamp is taken by the operating system kernel when
+                    the frame is received.
+    \value Hardware The timestamp is taken by the CAN hardware. If the hardware
+                    or its driver does not support timestamps, the kernel timestamp
+                    is used instead.
+*/
+
 /*!
     \since 5.14
 
@@ -572,10 +1431,8 @@ void QCanBusDevice::clear(QCanBusDevice::Directions direction)
 
     clearError();
 
-    if (direction & Direction::Input) {
-        QMutexLocker locker(&d->incomingFramesGuard);
+    if (direction & Direction::Input)
         d->incomingFrames.clear();
-    }
 
     if (direction & Direction::Output)
         d->outgoingFrames.clear();
@@ -772,12 +1629,42 @@ QCanBusFrame QCanBusDevice::readFrame()
 
     clearError();
 
-    QMutexLocker locker(&d->incomingFramesGuard);
+    QCanBusFrame frame(QCanBusFrame::InvalidFrame);
+    if (d->incomingFrames.dequeue(&frame))
+        d->recordReceiveLatency(&frame, 1);
+    return frame;
+}
 
-    if (Q_UNLIKELY(d->incomingFrames.isEmpty()))
-        return QCanBusFrame(QCanBusFrame::InvalidFrame);
+/*!
+    \since 6.3
+
+    Moves up to \a maxFrames \l{QCanBusFrame}s from the queue into the
+    caller-owned array \a frames and returns the number of frames read.
+    Returns 0 if no frames are available.
+
+    Unlike readAllFrames(), this function does not allocate memory, so the
+    same buffer can be reused for every call.
+
+    The queue operates according to the FIFO principle.
+
+    \sa readFrame(), readAllFrames(), framesAvailable()
+*/
+qsizetype QCanBusDevice::readFrames(QCanBusFrame *frames, qsizetype maxFrames)
+{
+    Q_D(QCanBusDevice);
+
+    if (Q_UNLIKELY(d->state != ConnectedState)) {
+        const QString error = tr("Cannot read frame as device is not connected.");
+        qCWarning(QT_CANBUS, "%ls", qUtf16Printable(error));
+        setError(error, CanBusError::OperationError);
+        return 0;
+    }
+
+    clearError();
 
-    return d->incomingFrames.takeFirst();
+    const qsizetype count = d->incomingFrames.dequeue(frames, maxFrames);
+    d->recordReceiveLatency(frames, count);
+    return count;
 }
 
 /*!
@@ -802,10 +1689,9 @@ QList<QCanBusFrame> QCanBusDevice::readAllFrames()
 
     clearError();
 
-    QMutexLocker locker(&d->incomingFramesGuard);
-
     QList<QCanBusFrame> result;
-    result.swap(d->incomingFrames);
+    d->incomingFrames.takeAll(&result);
+    d->recordReceiveLatency(result.constData(), result.size());
     return result;
 }
 
@@ -840,6 +1726,62 @@ QList<QCanBusFrame> QCanBusDevice::readAllFrames()
     \sa QCanBusFrame::setPayload()
 */
 
+/*!
+    \since 6.3
+
+    Writes the \a count frames from the array \a frames to the CAN bus and
+    returns the number of frames that were accepted. Frames are accepted in
+    order; if a frame cannot be written, the following frames are not written
+    either and errorOccurred() is emitted.
+
+    As with writeFrame(), the \l framesWritten() signal is the final confirmation
+    that the frames have been handed off to the transport layer.
+
+    Unless the CAN plugin passes several frames to the CAN driver at once,
+    see setWriteFramesFunction(), this function calls writeFrame() for each
+    frame.
+
+    \sa writeFrame()
+*/
+qsizetype QCanBusDevice::writeFrames(const QCanBusFrame *frames, qsizetype count)
+{
+    Q_D(QCanBusDevice);
+
+    if (d->m_writeFramesFunction)
+        return d->m_writeFramesFunction(frames, count);
+
+    qsizetype written = 0;
+    while (written < count && writeFrame(frames[written]))
+        ++written;
+    return written;
+}
+
+/*!
+    \typedef QCanBusDevice::WriteFramesFunction
+    \since 6.3
+
+    The type of the function that writeFrames() calls to write several frames
+    at once. It has the same arguments and return value as writeFrames().
+
+    \sa setWriteFramesFunction()
+*/
+
+/*!
+    \since 6.3
+
+    Sets \a writer as the function that writeFrames() calls to pass several
+    frames to the CAN driver at once. Without such a function, or if \a writer
+    is empty, writeFrames() calls writeFrame() for each frame.
+
+    CAN plugins call this function, usually in their constructor.
+
+    \sa writeFrames()
+*/
+void QCanBusDevice::setWriteFramesFunction(const WriteFramesFunction &writer)
+{
+    d_func()->m_writeFramesFunction = writer;
+}
+
 /*!
     \fn QString QCanBusDevice::interpretErrorFrame(const QCanBusFrame &frame)
 
@@ -909,6 +1851,20 @@ void QCanBusDevice::disconnectDevice()
     close();
 }
 
+/*!
+    \fn void QCanBusDevice::configurationParameterChanged(QCanBusDevice::ConfigurationKey key)
+    \since 6.3
+
+    This signal is emitted by setConfigurationParameter() after the stored value
+    of the configuration parameter \a key has changed, including when the
+    parameter was unset. It is not emitted if the same value is set again.
+
+    Plugins can connect to it to apply a new value or to update state derived
+    from it.
+
+    \sa setConfigurationParameter(), configurationFlag()
+*/
+
 /*!
     \fn void QCanBusDevice::stateChanged(QCanBusDevice::CanBusDeviceState state)
 
@@ -939,6 +1895,9 @@ void QCanBusDevice::setState(QCanBusDevice::CanBusDeviceState newState)
     if (newState == d->state)
         return;
 
+    d->incomingFrames.setStopped(newState == ClosingState || newState == UnconnectedState);
+    if (newState == ConnectingState)
+        d->overflowReported.storeRelaxed(false);
     d->state = newState;
     emit stateChanged(newState);
 }
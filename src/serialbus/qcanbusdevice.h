@@ -39,6 +39,7 @@
 #define QCANBUSDEVICE_H
 
 #include <QtCore/qobject.h>
+#include <QtCore/qthread.h>
 #include <QtSerialBus/qcanbusframe.h>
 #include <QtSerialBus/qcanbusdeviceinfo.h>
 
@@ -84,6 +85,20 @@ public:
     };
     Q_ENUM(CanBusStatus)
 
+    enum class TimeStampSource {
+        Software,
+        Kernel,
+        Hardware
+    };
+    Q_ENUM(TimeStampSource)
+
+    enum class ReceiveQueueOverflowPolicy {
+        DropOldest,
+        DropNewest,
+        Block
+    };
+    Q_ENUM(ReceiveQueueOverflowPolicy)
+
     enum ConfigurationKey {
         RawFilterKey = 0,
         ErrorFilterKey,
@@ -93,6 +108,9 @@ public:
         CanFdKey,
         DataBitRateKey,
         ProtocolKey,
+        FrameBatchSizeKey,
+        TimeStampSourceKey,
+        PayloadFilterKey,
         UserKey = 30
     };
     Q_ENUM(ConfigurationKey)
@@ -123,6 +141,45 @@ public:
         FormatFilter format = MatchBaseAndExtendedFormat;
     };
 
+    struct PayloadFilter
+    {
+        friend bool operator==(const PayloadFilter &a, const PayloadFilter &b) noexcept
+        {
+            return a.filter == b.filter && a.payload == b.payload
+                    && a.payloadMask == b.payloadMask;
+        }
+
+        friend bool operator!=(const PayloadFilter &a, const PayloadFilter &b) noexcept
+        {
+            return !operator==(a, b);
+        }
+
+        Filter filter;
+        QByteArray payload;
+        QByteArray payloadMask;
+    };
+
+    struct Statistics
+    {
+        enum { HistogramBucketCount = 40 };
+
+        quint64 receivedFrames = 0;
+        quint64 receivedBytes = 0;
+        quint64 transmittedFrames = 0;
+        quint64 transmittedBytes = 0;
+        quint64 errors = 0;
+        quint64 droppedFrames = 0;
+        quint64 filteredFrames = 0;
+        qint64 peakFramesAvailable = 0;
+        qint64 peakFramesToWrite = 0;
+        QList<quint64> receiveLatencyHistogram;
+        QList<quint64> enqueueDurationHistogram;
+    };
+
+    using FrameHandler = std::function<void(const QCanBusFrame *frames, qsizetype count)>;
+    using WriteFramesFunction = std::function<qsizetype(const QCanBusFrame *frames,
+                                                        qsizetype count)>;
+
     explicit QCanBusDevice(QObject *parent = nullptr);
 
     virtual void setConfigurationParameter(ConfigurationKey key, const QVariant &value);
@@ -130,10 +187,33 @@ public:
     QList<ConfigurationKey> configurationKeys() const;
 
     virtual bool writeFrame(const QCanBusFrame &frame) = 0;
+    qsizetype writeFrames(const QCanBusFrame *frames, qsizetype count);
     QCanBusFrame readFrame();
+    qsizetype readFrames(QCanBusFrame *frames, qsizetype maxFrames);
     QList<QCanBusFrame> readAllFrames();
     qint64 framesAvailable() const;
     qint64 framesToWrite() const;
+    qint64 framesToWriteHighWaterMark() const;
+    void resetFramesToWriteHighWaterMark();
+
+    void setReceiveQueueCapacity(qsizetype capacity);
+    qsizetype receiveQueueCapacity() const;
+    void setReceiveQueueOverflowPolicy(ReceiveQueueOverflowPolicy policy);
+    ReceiveQueueOverflowPolicy receiveQueueOverflowPolicy() const;
+    quint64 droppedFramesCount() const;
+
+    void setIoThreadEnabled(bool enabled);
+    bool isIoThreadEnabled() const;
+    void setIoThreadPriority(QThread::Priority priority);
+    QThread::Priority ioThreadPriority() const;
+    void setIoThreadAffinity(const QList<int> &cpus);
+    QList<int> ioThreadAffinity() const;
+
+    void setFrameHandler(const FrameHandler &handler);
+    FrameHandler frameHandler() const;
+
+    Statistics statistics() const;
+    void resetStatistics();
 
     virtual void resetController();
     virtual bool hasBusStatus() const;
@@ -166,6 +246,7 @@ Q_SIGNALS:
     void framesReceived();
     void framesWritten(qint64 framesCount);
     void stateChanged(QCanBusDevice::CanBusDeviceState state);
+    void configurationParameterChanged(QCanBusDevice::ConfigurationKey key);
 
 protected:
     void setState(QCanBusDevice::CanBusDeviceState newState);
@@ -173,10 +254,21 @@ protected:
     void clearError();
 
     void enqueueReceivedFrames(const QList<QCanBusFrame> &newFrames);
+    void setSoftwareFilterEnabled(bool enabled);
+    void recordWrittenFrames(qint64 frameCount, qint64 payloadBytes);
+    void setWriteFramesFunction(const WriteFramesFunction &writer);
+
+    bool configurationFlag(ConfigurationKey key) const;
+    qint64 configurationInteger(ConfigurationKey key, qint64 defaultValue = 0) const;
 
     void enqueueOutgoingFrame(const QCanBusFrame &newFrame);
     QCanBusFrame dequeueOutgoingFrame();
     bool hasOutgoingFrames() const;
+    qsizetype peekOutgoingFrames(QCanBusFrame *frames, qsizetype maxFrames) const;
+    void discardOutgoingFrames(qsizetype count);
+
+    QThread *startIoThread();
+    void stopIoThread();
 
     virtual bool open() = 0;
     virtual void close() = 0;
@@ -200,6 +292,8 @@ Q_DECLARE_TYPEINFO(QCanBusDevice::CanBusDeviceState, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::ConfigurationKey, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::Filter, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(QCanBusDevice::Filter::FormatFilter, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(QCanBusDevice::PayloadFilter, Q_RELOCATABLE_TYPE);
+Q_DECLARE_TYPEINFO(QCanBusDevice::Statistics, Q_RELOCATABLE_TYPE);
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(QCanBusDevice::Filter::FormatFilters)
 Q_DECLARE_OPERATORS_FOR_FLAGS(QCanBusDevice::Directions)
@@ -208,5 +302,6 @@ QT_END_NAMESPACE
 
 Q_DECLARE_METATYPE(QCanBusDevice::Filter::FormatFilter)
 Q_DECLARE_METATYPE(QList<QCanBusDevice::Filter>)
+Q_DECLARE_METATYPE(QList<QCanBusDevice::PayloadFilter>)
 
 #endif // QCANBUSDEVICE_H
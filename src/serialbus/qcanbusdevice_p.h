@@ -37,11 +37,20 @@
 #ifndef QCANBUSDEVICE_P_H
 #define QCANBUSDEVICE_P_H
 
-#include <QtCore/qmutex.h>
+#include "qcanbusframefilter_p.h"
+#include "qcanbusframequeue_p.h"
+
 #include <QtSerialBus/qcanbusdevice.h>
 
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qmutex.h>
+
 #include <private/qobject_p.h>
 
+#include <array>
+#include <chrono>
+
 //
 //  W A R N I N G
 //  -------------
@@ -57,26 +66,221 @@ QT_BEGIN_NAMESPACE
 
 typedef QPair<QCanBusDevice::ConfigurationKey, QVariant > ConfigEntry;
 
+// Storage of the configuration parameters. The keys below UserKey are indexed
+// directly and keep typed copies of their values, so that plugins can query
+// them for every frame without a lookup or unpacking a QVariant.
+class QCanBusConfiguration
+{
+public:
+    enum { IndexedKeyCount = QCanBusDevice::UserKey };
+
+    // Returns true if the stored value has changed.
+    bool setValue(QCanBusDevice::ConfigurationKey key, const QVariant &value)
+    {
+        if (!isIndexed(key))
+            return setUserValue(key, value);
+
+        QVariant &stored = m_values[key];
+        if (stored.isValid() == value.isValid() && (!value.isValid() || stored == value))
+            return false;
+
+        if (!stored.isValid())
+            m_keys.append(key);
+        else if (!value.isValid())
+            m_keys.removeOne(key);
+        stored = value;
+
+        const quint32 bit = 1u << key;
+        m_flags = value.toBool() ? (m_flags | bit) : (m_flags & ~bit);
+        bool isInteger = false;
+        m_integers[key] = value.toLongLong(&isInteger);
+        m_integerKeys = isInteger ? (m_integerKeys | bit) : (m_integerKeys & ~bit);
+        return true;
+    }
+
+    QVariant value(QCanBusDevice::ConfigurationKey key) const
+    {
+        if (isIndexed(key))
+            return m_values[key];
+        for (const ConfigEntry &entry : m_userValues) {
+            if (entry.first == key)
+                return entry.second;
+        }
+        return QVariant();
+    }
+
+    bool flag(QCanBusDevice::ConfigurationKey key) const noexcept
+    {
+        return isIndexed(key) ? (m_flags & (1u << key)) != 0 : value(key).toBool();
+    }
+
+    qint64 integer(QCanBusDevice::ConfigurationKey key, qint64 defaultValue) const
+    {
+        if (!isIndexed(key)) {
+            bool isInteger = false;
+            const qint64 result = value(key).toLongLong(&isInteger);
+            return isInteger ? result : defaultValue;
+        }
+        return (m_integerKeys & (1u << key)) ? m_integers[key] : defaultValue;
+    }
+
+    // In the order in which the keys were first set
+    QList<QCanBusDevice::ConfigurationKey> keys() const { return m_keys; }
+
+private:
+    static bool isIndexed(QCanBusDevice::ConfigurationKey key) noexcept
+    {
+        return key >= 0 && key < IndexedKeyCount;
+    }
+
+    bool setUserValue(QCanBusDevice::ConfigurationKey key, const QVariant &value)
+    {
+        for (qsizetype i = 0; i < m_userValues.size(); ++i) {
+            if (m_userValues.at(i).first != key)
+                continue;
+            if (!value.isValid()) {
+                m_userValues.remove(i);
+                m_keys.removeOne(key);
+                return true;
+            }
+            if (m_userValues.at(i).second == value)
+                return false;
+            m_userValues[i].second = value;
+            return true;
+        }
+
+        if (!value.isValid())
+            return false;
+        m_userValues.append(ConfigEntry(key, value));
+        m_keys.append(key);
+        return true;
+    }
+
+    std::array<QVariant, IndexedKeyCount> m_values;
+    std::array<qint64, IndexedKeyCount> m_integers = {};
+    quint32 m_flags = 0;
+    quint32 m_integerKeys = 0;
+    QList<ConfigEntry> m_userValues;
+    QList<QCanBusDevice::ConfigurationKey> m_keys;
+};
+
+// Histogram with power of two buckets: bucket i counts the values v with
+// 2^(i - 1) <= v < 2^i, bucket 0 the values below 1, and the last bucket
+// all values that do not fit into the others.
+class QCanBusHistogram
+{
+public:
+    enum { BucketCount = QCanBusDevice::Statistics::HistogramBucketCount };
+
+    void record(qint64 value) noexcept
+    {
+        const int bit = value > 0 ? 64 - qCountLeadingZeroBits(quint64(value)) : 0;
+        m_buckets[qMin(bit, int(BucketCount) - 1)].fetchAndAddRelaxed(1);
+    }
+
+    QList<quint64> snapshot() const
+    {
+        QList<quint64> result(BucketCount);
+        for (int i = 0; i < BucketCount; ++i)
+            result[i] = m_buckets[i].loadRelaxed();
+        return result;
+    }
+
+    void reset() noexcept
+    {
+        for (QAtomicInteger<quint64> &bucket : m_buckets)
+            bucket.storeRelaxed(0);
+    }
+
+private:
+    std::array<QAtomicInteger<quint64>, BucketCount> m_buckets;
+};
+
+// Counters behind QCanBusDevice::statistics(). They are only updated with
+// relaxed atomic operations, so that the receiving thread never has to wait
+// for a reader of the statistics.
+struct QCanBusStatisticsCounters
+{
+    QAtomicInteger<quint64> receivedFrames;
+    QAtomicInteger<quint64> receivedBytes;
+    QAtomicInteger<quint64> transmittedFrames;
+    QAtomicInteger<quint64> transmittedBytes;
+    QAtomicInteger<quint64> errors;
+    QAtomicInteger<quint64> filteredFrames;
+    QAtomicInteger<quint64> droppedFramesOffset; // droppedFrames() at the last reset
+    QAtomicInteger<qint64> peakFramesAvailable;
+    QCanBusHistogram receiveLatency; // nanoseconds
+    QCanBusHistogram enqueueDuration; // nanoseconds
+};
+
 class QCanBusDevicePrivate : public QObjectPrivate
 {
     Q_DECLARE_PUBLIC(QCanBusDevice)
 public:
     QCanBusDevicePrivate() {}
+    ~QCanBusDevicePrivate()
+    {
+        if (ioThread) {
+            ioThread->quit();
+            ioThread->wait();
+            delete ioThread;
+        }
+    }
 
     QCanBusDevice::CanBusError lastError = QCanBusDevice::CanBusError::NoError;
     QCanBusDevice::CanBusDeviceState state = QCanBusDevice::UnconnectedState;
     QString errorText;
 
-    QList<QCanBusFrame> incomingFrames;
-    QMutex incomingFramesGuard;
+    QCanBusFrameQueue incomingFrames;
+    // read by the receiving thread, set from the device's thread
+    QAtomicInteger<int> overflowPolicy =
+            int(QCanBusDevice::ReceiveQueueOverflowPolicy::DropNewest);
+    // the first overflow after connecting is reported by errorOccurred()
+    QAtomicInteger<bool> overflowReported = false;
     QList<QCanBusFrame> outgoingFrames;
-    QList<ConfigEntry> configOptions;
+    // The receiving thread matches against frameFilter while the
+    // RawFilterKey may be changed from the device's thread
+    QMutex frameFilterMutex;
+    QCanBusFrameFilter frameFilter;
+    QList<QCanBusFrame> filteredFrames;
+    QAtomicInteger<bool> softwareFilterEnabled = false;
+    // only raised by the device's thread, statistics() may read it from any thread
+    QAtomicInteger<qsizetype> outgoingHighWaterMark = 0;
+    QCanBusConfiguration configuration;
+
+    QThread *ioThread = nullptr;
+    bool ioThreadEnabled = false;
+    QThread::Priority ioThreadPriority = QThread::InheritPriority;
+    QList<int> ioThreadAffinity;
+
+    QCanBusDevice::FrameHandler frameHandler;
+    QCanBusStatisticsCounters statistics;
+
+    void recordReceiveLatency(const QCanBusFrame *frames, qsizetype count)
+    {
+        if (count == 0)
+            return;
+
+        // Only timestamps taken from the system clock, like SocketCAN's, can be
+        // compared with it. Other timestamps are far off and are skipped.
+        constexpr qint64 MaxClockSkew = 1000000000; // 1 s
+        constexpr qint64 MaxLatency = Q_INT64_C(60000000000); // 60 s
+        const qint64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+        for (qsizetype i = 0; i < count; ++i) {
+            const qint64 latency = now - frames[i].timeStampNanoSeconds();
+            if (latency >= -MaxClockSkew && latency <= MaxLatency)
+                statistics.receiveLatency.record(latency);
+        }
+    }
 
     bool waitForReceivedEntered = false;
     bool waitForWrittenEntered = false;
 
     std::function<void()> m_resetControllerFunction;
     std::function<QCanBusDevice::CanBusStatus()> m_busStatusGetter;
+    QCanBusDevice::WriteFramesFunction m_writeFramesFunction;
 };
 
 QT_END_NAMESPACE
@@ -40,6 +40,48 @@
 
 QT_BEGIN_NAMESPACE
 
+namespace {
+
+// maximum permitted payload size in CAN FD
+constexpr qsizetype MaximumPooledPayloadSize = 64;
+
+// Hands out payloads as slices of one larger QByteArray data block, so that
+// receiving a frame does not cost a heap allocation. Every slice holds a
+// reference to its block, the pool holds one more to the block it currently
+// fills.
+class PayloadPool
+{
+public:
+    QByteArray copy(const char *data, qsizetype size)
+    {
+        // QByteArray expects a terminating '\0' behind its data
+        const qsizetype required = size + 1;
+        if (!block.d_ptr() || block.constAllocatedCapacity() - used < required) {
+            block = QArrayDataPointer<char>(QTypedArrayData<char>::allocate(BlockSize));
+            used = 0;
+        }
+
+        char *slice = block.data() + used;
+        ::memcpy(slice, data, size);
+        slice[size] = '\0';
+        used += required;
+
+        block.d_ptr()->ref();
+        return QByteArray(QByteArray::DataPointer(block.d_ptr(), slice, size));
+    }
+
+private:
+    // one page including the block header and the allocator's overhead
+    enum : qsizetype { BlockSize = 4096 - 32 };
+
+    QArrayDataPointer<char> block;
+    qsizetype used = 0;
+};
+
+thread_local PayloadPool payloadPool;
+
+} // namespace
+
 /*!
     \class QCanBusFrame
     \inmodule QtSerialBus
@@ -115,13 +157,53 @@ QT_BEGIN_NAMESPACE
     \sa payload(), hasFlexibleDataRateFormat()
 */
 
+/*!
+    \since 6.3
+    \overload
+
+    Sets the first \a size bytes of \a data as the payload for the CAN frame.
+
+    Unlike constructing a temporary QByteArray, this function does not
+    allocate memory for every frame. Payloads of valid CAN and CAN FD frames
+    are copied into a block of memory shared by the frames created in the same
+    thread, which is freed when the last of these frames is destroyed.
+    The payload() of the frame refers to this block and is detached like any
+    other shared QByteArray when it is modified.
+
+    \sa payloadView()
+*/
+void QCanBusFrame::setPayload(const char *data, qsizetype size)
+{
+    if (size <= 0)
+        load.clear();
+    else if (size <= MaximumPooledPayloadSize)
+        load = payloadPool.copy(data, size);
+    else
+        load = QByteArray(data, size);
+
+    if (size > 8)
+        isFlexibleDataRate = 0x1;
+}
+
 /*!
     \fn QCanBusFrame::setTimeStamp(TimeStamp ts)
 
     Sets \a ts as the timestamp for the CAN frame. Usually, this function is not needed, because the
     timestamp is created during the read operation and not needed during the write operation.
 
-    \sa QCanBusFrame::TimeStamp
+    \sa QCanBusFrame::TimeStamp, setTimeStampNanoSeconds()
+*/
+
+/*!
+    \fn QCanBusFrame::setTimeStampNanoSeconds(qint64 nsec)
+    \since 6.3
+
+    Sets the timestamp of the CAN frame to \a nsec nanoseconds. Unlike
+    setTimeStamp(), this function keeps the part below one microsecond, which
+    is returned by timeStampNanoSeconds(). timeStamp() returns the normalized
+    timestamp with microsecond precision.
+
+    \sa timeStampNanoSeconds()
 */
 
 /*!
@@ -166,6 +248,8 @@ QT_BEGIN_NAMESPACE
 
     \value Qt_5_8               This frame is the initial version introduced in Qt 5.8
     \value Qt_5_9               This frame version was introduced in Qt 5.9
+    \value Qt_5_10              This frame version was introduced in Qt 5.10
+    \value Qt_6_3               This frame version was introduced in Qt 6.3
 */
 
 /*!
@@ -225,7 +309,17 @@ QT_BEGIN_NAMESPACE
 
     Returns the data payload of the frame.
 
-    \sa setPayload()
+    \sa setPayload(), payloadView()
+*/
+
+/*!
+    \fn QByteArrayView QCanBusFrame::payloadView() const
+    \since 6.3
+
+    Returns a view on the data payload of the frame. The view is valid as long
+    as the frame is neither modified nor destroyed.
+
+    \sa payload(), setPayload()
 */
 
 /*!
@@ -236,6 +330,17 @@ QT_BEGIN_NAMESPACE
     \sa QCanBusFrame::TimeStamp, QCanBusFrame::setTimeStamp()
 */
 
+/*!
+    \fn qint64 QCanBusFrame::timeStampNanoSeconds() const
+    \since 6.3
+
+    Returns the timestamp of the frame in nanoseconds. If the timestamp was set
+    with setTimeStampNanoSeconds(), the result includes the part below one
+    microsecond; otherwise, it is timeStamp() converted to nanoseconds.
+
+    \sa setTimeStampNanoSeconds(), timeStamp()
+*/
+
 /*!
     \fn FrameErrors QCanBusFrame::error() const
 
@@ -428,14 +533,16 @@ QString QCanBusFrame::toString() const
                                16, QLatin1Char('0')).toUpper());
 
     result.append(hasFlexibleDataRateFormat() ? u"  "_qs : u"   "_qs);
-    result.append(u"[%1]"_qs.arg(payload().size(),
+    result.append(u"[%1]"_qs.arg(payloadView().size(),
                                hasFlexibleDataRateFormat() ? 2 : 0,
                                10, QLatin1Char('0')));
 
     if (type == RemoteRequestFrame) {
         result.append(u"  Remote Request"_qs);
-    } else if (!payload().isEmpty()) {
-        const QByteArray data = payload().toHex(' ').toUpper();
+    } else if (!payloadView().isEmpty()) {
+        const QByteArrayView view = payloadView();
+        const QByteArray data = QByteArray::fromRawData(view.data(), view.size())
+                .toHex(' ').toUpper();
         result.append(u"  "_qs);
         result.append(QLatin1String(data));
     }
@@ -457,7 +564,12 @@ QDataStream &operator<<(QDataStream &out, const QCanBusFrame &frame)
     out << static_cast<quint8>(frame.version);
     out << frame.hasExtendedFrameFormat();
     out << frame.hasFlexibleDataRateFormat();
-    out << frame.payload();
+    // same format as QByteArray, without copying the payload out of the frame
+    const QByteArrayView payload = frame.payloadView();
+    if (payload.isEmpty())
+        out << QByteArray();
+    else
+        out.writeBytes(payload.data(), uint(payload.size()));
     const QCanBusFrame::TimeStamp stamp = frame.timeStamp();
     out << stamp.seconds();
     out << stamp.microSeconds();
@@ -465,6 +577,8 @@ QDataStream &operator<<(QDataStream &out, const QCanBusFrame &frame)
         out << frame.hasBitrateSwitch() << frame.hasErrorStateIndicator();
     if (frame.version >= QCanBusFrame::Version::Qt_5_10)
         out << frame.hasLocalEcho();
+    if (frame.version >= QCanBusFrame::Version::Qt_6_3)
+        out << frame.subMicroSecondStamp();
     return out;
 }
 
@@ -483,6 +597,7 @@ QDataStream &operator>>(QDataStream &in, QCanBusFrame &frame)
     bool bitrateSwitch = false;
     bool errorStateIndicator = false;
     bool localEcho = false;
+    quint16 subMicroSecondStamp = 0;
     QByteArray payload;
     qint64 seconds;
     qint64 microSeconds;
@@ -496,6 +611,9 @@ QDataStream &operator>>(QDataStream &in, QCanBusFrame &frame)
     if (version >= QCanBusFrame::Version::Qt_5_10)
         in >> localEcho;
 
+    if (version >= QCanBusFrame::Version::Qt_6_3)
+        in >> subMicroSecondStamp;
+
     frame.setFrameId(frameId);
     frame.version = version;
 
@@ -508,6 +626,7 @@ QDataStream &operator>>(QDataStream &in, QCanBusFrame &frame)
     frame.setPayload(payload);
 
     frame.setTimeStamp(QCanBusFrame::TimeStamp(seconds, microSeconds));
+    frame.setSubMicroSecondStamp(qMin<quint16>(subMicroSecondStamp, 999));
 
     return in;
 }
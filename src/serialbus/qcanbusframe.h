@@ -37,6 +37,7 @@
 #ifndef QCANBUSFRAME_H
 #define QCANBUSFRAME_H
 
+#include <QtCore/qbytearrayview.h>
 #include <QtCore/qmetatype.h>
 #include <QtCore/qobject.h>
 #include <QtSerialBus/qtserialbusglobal.h>
@@ -76,15 +77,18 @@ public:
 
     explicit QCanBusFrame(FrameType type = DataFrame) noexcept :
         isExtendedFrame(0x0),
-        version(Qt_5_10),
+        version(Qt_6_3),
         isFlexibleDataRate(0x0),
         isBitrateSwitch(0x0),
         isErrorStateIndicator(0x0),
         isLocalEcho(0x0),
-        reserved0(0x0)
+        reserved0(0x0),
+        stampNanoSecondsLow(0x0),
+        stampNanoSecondsHigh(0x0),
+        reserved1(0x0)
     {
         Q_UNUSED(reserved0);
-        ::memset(reserved, 0, sizeof(reserved));
+        Q_UNUSED(reserved1);
         setFrameId(0x0);
         setFrameType(type);
     }
@@ -110,15 +114,17 @@ public:
     explicit QCanBusFrame(QCanBusFrame::FrameId identifier, const QByteArray &data) :
         format(DataFrame),
         isExtendedFrame(0x0),
-        version(Qt_5_10),
+        version(Qt_6_3),
         isFlexibleDataRate(data.length() > 8 ? 0x1 : 0x0),
         isBitrateSwitch(0x0),
         isErrorStateIndicator(0x0),
         isLocalEcho(0x0),
         reserved0(0x0),
+        stampNanoSecondsLow(0x0),
+        stampNanoSecondsHigh(0x0),
+        reserved1(0x0),
         load(data)
     {
-        ::memset(reserved, 0, sizeof(reserved));
         setFrameId(identifier);
     }
 
@@ -206,10 +212,26 @@ public:
         if (data.length() > 8)
             isFlexibleDataRate = 0x1;
     }
-    constexpr void setTimeStamp(TimeStamp ts) noexcept { stamp = ts; }
+    void setPayload(const char *data, qsizetype size);
+    constexpr void setTimeStamp(TimeStamp ts) noexcept
+    {
+        stamp = ts;
+        setSubMicroSecondStamp(0);
+    }
+    constexpr void setTimeStampNanoSeconds(qint64 nsec) noexcept
+    {
+        stamp = TimeStamp(nsec / 1000000000, (nsec % 1000000000) / 1000);
+        setSubMicroSecondStamp(nsec > 0 ? quint16(nsec % 1000) : 0);
+    }
 
     QByteArray payload() const { return load; }
+    QByteArrayView payloadView() const noexcept { return load; }
     constexpr TimeStamp timeStamp() const noexcept { return stamp; }
+    constexpr qint64 timeStampNanoSeconds() const noexcept
+    {
+        return stamp.seconds() * 1000000000 + stamp.microSeconds() * 1000
+                + subMicroSecondStamp();
+    }
 
     constexpr FrameErrors error() const noexcept
     {
@@ -264,10 +286,21 @@ public:
 #endif
 
 private:
+    constexpr quint16 subMicroSecondStamp() const noexcept
+    {
+        return quint16(stampNanoSecondsLow | (stampNanoSecondsHigh << 8));
+    }
+    constexpr void setSubMicroSecondStamp(quint16 nsec) noexcept
+    {
+        stampNanoSecondsLow = quint8(nsec);
+        stampNanoSecondsHigh = quint8(nsec >> 8);
+    }
+
     enum Version {
         Qt_5_8 = 0x0,
         Qt_5_9 = 0x1,
-        Qt_5_10 = 0x2
+        Qt_5_10 = 0x2,
+        Qt_6_3 = 0x3
     };
 
     quint32 canId:29; // acts as container for error codes too
@@ -283,8 +316,11 @@ private:
     quint8 isLocalEcho:1;
     quint8 reserved0:5;
 
-    // reserved for future use
-    quint8 reserved[2];
+    // nanoseconds of the timestamp below one microsecond (0 to 999),
+    // stored in bytes that were reserved before Qt 6.3
+    quint8 stampNanoSecondsLow;
+    quint8 stampNanoSecondsHigh:2;
+    quint8 reserved1:6; // reserved for future use
 
     QByteArray load;
     TimeStamp stamp;
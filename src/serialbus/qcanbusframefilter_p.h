@@ -0,0 +1,186 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANBUSFRAMEFILTER_P_H
+#define QCANBUSFRAMEFILTER_P_H
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+
+#include <array>
+#include <vector>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+// Software implementation of QCanBusDevice::Filter lists for plugins whose
+// hardware cannot filter.
+//
+// The filter list is compiled once, so that matching a frame does not walk
+// the list:
+// - Base format frames are looked up in a bitmap with one bit per 11-bit
+//   identifier and frame type.
+// - Extended format frames are looked up in a hash of exact identifiers,
+//   then in one hash per distinct identifier mask.
+// Each hash maps an identifier to the set of accepted frame types.
+// Error frames always pass, as with SocketCAN they are selected by the
+// ErrorFilterKey instead.
+class QCanBusFrameFilter
+{
+public:
+    // Without filters every frame is accepted
+    QCanBusFrameFilter() = default;
+
+    // An empty filter list also accepts every frame, as with SocketCAN
+    explicit QCanBusFrameFilter(const QList<QCanBusDevice::Filter> &filters)
+        : m_acceptAll(filters.isEmpty())
+    {
+        for (const QCanBusDevice::Filter &filter : filters)
+            addFilter(filter);
+    }
+
+    bool acceptsAll() const noexcept { return m_acceptAll; }
+
+    bool matches(const QCanBusFrame &frame) const
+    {
+        if (m_acceptAll || frame.frameType() == QCanBusFrame::ErrorFrame)
+            return true;
+
+        const quint32 frameId = frame.frameId();
+        const TypeMask type = typeMask(frame.frameType());
+
+        if (!frame.hasExtendedFrameFormat()) {
+            // Base format frames never carry larger identifiers
+            if (Q_UNLIKELY(frameId > MaxBaseFrameId))
+                return false;
+            const quint32 bit = (quint32(frame.frameType()) << 11) | frameId;
+            return (m_baseBitmap[bit >> 6] >> (bit & 63)) & 1;
+        }
+
+        if (m_exactIds.value(frameId) & type)
+            return true;
+        for (const MaskBucket &bucket : m_maskBuckets) {
+            if (bucket.ids.value(frameId & bucket.mask) & type)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    using TypeMask = quint8;
+
+    enum : quint32 {
+        MaxBaseFrameId = 0x7ff,
+        MaxExtendedFrameId = 0x1fffffff,
+        FrameTypeCount = QCanBusFrame::InvalidFrame + 1
+    };
+
+    struct MaskBucket
+    {
+        quint32 mask;
+        QHash<quint32, TypeMask> ids;
+    };
+
+    static TypeMask typeMask(QCanBusFrame::FrameType type) noexcept
+    {
+        return TypeMask(1u << type);
+    }
+
+    void addFilter(const QCanBusDevice::Filter &filter)
+    {
+        if (filter.type == QCanBusFrame::UnknownFrame)
+            return; // invalid filter
+
+        const quint32 frameIdMask = filter.frameIdMask;
+        const quint32 pattern = filter.frameId & frameIdMask;
+        const TypeMask types = (filter.type == QCanBusFrame::InvalidFrame)
+                ? TypeMask((1u << FrameTypeCount) - 1) : typeMask(filter.type);
+
+        if (filter.format & QCanBusDevice::Filter::MatchBaseFormat) {
+            for (quint32 frameId = 0; frameId <= MaxBaseFrameId; ++frameId) {
+                if ((frameId & frameIdMask) != pattern)
+                    continue;
+                for (quint32 type = 0; type < FrameTypeCount; ++type) {
+                    if (types & (1u << type)) {
+                        const quint32 bit = (type << 11) | frameId;
+                        m_baseBitmap[bit >> 6] |= quint64(1) << (bit & 63);
+                    }
+                }
+            }
+        }
+
+        if (filter.format & QCanBusDevice::Filter::MatchExtendedFormat) {
+            if (pattern & ~MaxExtendedFrameId)
+                return; // cannot match any 29-bit identifier
+
+            if ((frameIdMask & MaxExtendedFrameId) == MaxExtendedFrameId) {
+                m_exactIds[pattern] |= types;
+                return;
+            }
+
+            for (MaskBucket &bucket : m_maskBuckets) {
+                if (bucket.mask == frameIdMask) {
+                    bucket.ids[pattern] |= types;
+                    return;
+                }
+            }
+            m_maskBuckets.push_back({frameIdMask, {}});
+            m_maskBuckets.back().ids.insert(pattern, types);
+        }
+    }
+
+    bool m_acceptAll = true;
+    std::array<quint64, (FrameTypeCount << 11) / 64> m_baseBitmap = {};
+    QHash<quint32, TypeMask> m_exactIds;
+    std::vector<MaskBucket> m_maskBuckets;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCANBUSFRAMEFILTER_P_H
@@ -0,0 +1,315 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QCANBUSFRAMEQUEUE_P_H
+#define QCANBUSFRAMEQUEUE_P_H
+
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthread.h>
+#include <QtCore/qwaitcondition.h>
+
+#include <atomic>
+#include <vector>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+// Bounded single-producer ring buffer for received CAN frames.
+//
+// The producer (the CAN plugin) only writes the head index, the consumer only
+// writes the tail index, so both sides can work without a lock. To discard the
+// oldest frame on overflow, the producer may also advance the tail index. The
+// consumer therefore claims the tail by setting the Busy bit while it moves
+// frames out of the ring; this also serializes concurrent readers.
+//
+// With the Block policy, the producer waits on a condition for at most
+// BlockTimeout. If the consumer does not make room in time, the frame is
+// dropped and further frames are dropped without waiting until the consumer
+// reads again. setStopped() wakes a waiting producer, so that the device can
+// be closed while the queue is full.
+class QCanBusFrameQueue
+{
+public:
+    using OverflowPolicy = QCanBusDevice::ReceiveQueueOverflowPolicy;
+
+    enum : qsizetype {
+        DefaultCapacity = 4096,
+        MaximumCapacity = 1 << 24
+    };
+
+    static constexpr int BlockTimeout = 100; // milliseconds
+
+    explicit QCanBusFrameQueue(qsizetype capacity = DefaultCapacity)
+    {
+        m_mask = roundedCapacity(capacity) - 1;
+    }
+
+    Q_DISABLE_COPY_MOVE(QCanBusFrameQueue)
+
+    qsizetype capacity() const noexcept { return qsizetype(m_mask + 1); }
+
+    // Must not be called while another thread accesses the queue.
+    void setCapacity(qsizetype capacity)
+    {
+        QList<QCanBusFrame> pending;
+        takeAll(&pending);
+
+        const quint64 newCapacity = roundedCapacity(capacity);
+        m_frames = std::vector<QCanBusFrame>();
+        m_mask = newCapacity - 1;
+        m_head.storeRelaxed(0);
+        m_tail.storeRelaxed(0);
+
+        // keep the newest frames that fit into the resized queue
+        const qsizetype first = qMax<qsizetype>(0, pending.size() - qsizetype(newCapacity));
+        for (qsizetype i = first; i < pending.size(); ++i)
+            enqueue(pending.at(i), OverflowPolicy::DropNewest);
+    }
+
+    qsizetype size() const noexcept
+    {
+        const quint64 tail = m_tail.loadAcquire() & ~Busy;
+        return qsizetype(m_head.loadAcquire() - tail);
+    }
+
+    quint64 droppedFrames() const noexcept { return m_dropped.loadRelaxed(); }
+
+    // While stopped, the Block policy drops frames instead of waiting.
+    void setStopped(bool stopped)
+    {
+        m_stopped.storeRelease(stopped);
+        if (!stopped) {
+            m_stalled.storeRelaxed(false);
+            return;
+        }
+
+        QMutexLocker locker(&m_waitMutex);
+        m_notFull.wakeAll();
+    }
+
+    // Producer side, returns false if the frame was discarded.
+    bool enqueue(const QCanBusFrame &frame, OverflowPolicy policy)
+    {
+        if (Q_UNLIKELY(m_frames.empty()))
+            m_frames.resize(m_mask + 1); // the consumer touches no slot while the queue is empty
+
+        const quint64 head = m_head.loadRelaxed();
+        for (;;) {
+            const quint64 tail = m_tail.loadAcquire();
+            if (head - (tail & ~Busy) <= m_mask)
+                break;
+
+            if (policy == OverflowPolicy::Block) {
+                // blocking would dead lock if no other thread drains the queue
+                const void *consumer = m_consumerThread.loadRelaxed();
+                if (!consumer || consumer == QThread::currentThreadId()
+                        || m_stopped.loadAcquire() || m_stalled.loadRelaxed()) {
+                    m_dropped.fetchAndAddRelaxed(1);
+                    return false;
+                }
+                if (!waitForSpace(head)) {
+                    m_stalled.storeRelaxed(true);
+                    m_dropped.fetchAndAddRelaxed(1);
+                    return false;
+                }
+                continue;
+            }
+
+            if (policy == OverflowPolicy::DropNewest) {
+                m_dropped.fetchAndAddRelaxed(1);
+                return false;
+            }
+
+            // with DropOldest, the oldest slot is reused below once the tail moved past it
+            if (!(tail & Busy) && m_tail.testAndSetAcquire(tail, tail + 1)) {
+                m_dropped.fetchAndAddRelaxed(1);
+                break;
+            }
+
+            QThread::yieldCurrentThread();
+        }
+
+        m_frames[head & m_mask] = frame;
+        m_head.storeRelease(head + 1);
+        return true;
+    }
+
+    // Consumer side
+    bool dequeue(QCanBusFrame *frame)
+    {
+        const quint64 tail = claim();
+        if (tail == m_head.loadAcquire()) {
+            m_tail.storeRelease(tail);
+            return false;
+        }
+
+        *frame = std::move(m_frames[tail & m_mask]);
+        release(tail + 1);
+        return true;
+    }
+
+    qsizetype dequeue(QCanBusFrame *frames, qsizetype maxFrames)
+    {
+        const quint64 tail = claim();
+        const quint64 head = qMin(m_head.loadAcquire(), tail + quint64(qMax<qsizetype>(0, maxFrames)));
+
+        for (quint64 i = tail; i != head; ++i)
+            *frames++ = std::move(m_frames[i & m_mask]);
+
+        release(head);
+        return qsizetype(head - tail);
+    }
+
+    qsizetype takeAll(QList<QCanBusFrame> *frames)
+    {
+        const quint64 tail = claim();
+        const quint64 head = m_head.loadAcquire();
+
+        frames->reserve(frames->size() + qsizetype(head - tail));
+        for (quint64 i = tail; i != head; ++i)
+            frames->append(std::move(m_frames[i & m_mask]));
+
+        release(head);
+        return qsizetype(head - tail);
+    }
+
+    void clear()
+    {
+        const quint64 tail = claim();
+        const quint64 head = m_head.loadAcquire();
+
+        for (quint64 i = tail; i != head; ++i)
+            m_frames[i & m_mask] = QCanBusFrame();
+
+        release(head);
+    }
+
+private:
+    static constexpr quint64 Busy = Q_UINT64_C(1) << 63;
+    static constexpr qsizetype CacheLineSize = 64;
+
+    static quint64 roundedCapacity(qsizetype capacity) noexcept
+    {
+        quint64 result = 1;
+        while (result < quint64(qBound<qsizetype>(1, capacity, MaximumCapacity)))
+            result <<= 1;
+        return result;
+    }
+
+    quint64 claim() noexcept
+    {
+        m_consumerThread.storeRelaxed(QThread::currentThreadId());
+        for (;;) {
+            const quint64 tail = m_tail.loadRelaxed();
+            if (!(tail & Busy) && m_tail.testAndSetAcquire(tail, tail | Busy))
+                return tail;
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    // Releases the claimed tail and wakes a producer waiting for space.
+    void release(quint64 tail)
+    {
+        m_tail.storeRelease(tail);
+        m_stalled.storeRelaxed(false);
+
+        // pairs with the fence in waitForSpace(), so that either the producer
+        // sees the new tail or this thread sees the waiting producer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.loadRelaxed() == 0)
+            return;
+
+        QMutexLocker locker(&m_waitMutex);
+        m_notFull.wakeAll();
+    }
+
+    // Producer side, returns false if the queue is still full after BlockTimeout.
+    bool waitForSpace(quint64 head)
+    {
+        QDeadlineTimer deadline(BlockTimeout);
+        QMutexLocker locker(&m_waitMutex);
+        m_waiters.ref();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool result = true;
+        while (head - (m_tail.loadAcquire() & ~Busy) > m_mask) {
+            if (m_stopped.loadAcquire() || !m_notFull.wait(&m_waitMutex, deadline)) {
+                result = head - (m_tail.loadAcquire() & ~Busy) <= m_mask;
+                break;
+            }
+        }
+
+        m_waiters.deref();
+        return result;
+    }
+
+    // written by the producer
+    alignas(CacheLineSize) QAtomicInteger<quint64> m_head = 0;
+    // written by the consumer, and by the producer when dropping the oldest frame
+    alignas(CacheLineSize) QAtomicInteger<quint64> m_tail = 0;
+    alignas(CacheLineSize) QAtomicInteger<quint64> m_dropped = 0;
+    QAtomicPointer<void> m_consumerThread = nullptr;
+    QAtomicInt m_stalled = false;
+    QAtomicInt m_stopped = false;
+
+    // only used by the Block policy
+    QAtomicInt m_waiters = 0;
+    QMutex m_waitMutex;
+    QWaitCondition m_notFull;
+
+    alignas(CacheLineSize) quint64 m_mask = 0;
+    std::vector<QCanBusFrame> m_frames;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCANBUSFRAMEQUEUE_P_H
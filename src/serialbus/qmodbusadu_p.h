@@ -39,6 +39,8 @@
 
 #include <QtSerialBus/qmodbuspdu.h>
 
+#include <array>
+
 //
 //  W A R N I N G
 //  -------------
@@ -52,6 +54,32 @@
 
 QT_BEGIN_NAMESPACE
 
+namespace QtModbusPrivate {
+
+using CrcTables = std::array<std::array<quint16, 256>, 8>;
+
+// Lookup tables for the slicing-by-8 Modbus CRC. The first table is the classic
+// byte-wise table, table n advances the CRC of a byte by n additional zero bytes.
+constexpr CrcTables createCrcTables()
+{
+    CrcTables tables = {};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint16 crc = quint16(i);
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc & 0x0001) ? quint16((crc >> 1) ^ 0xA001) : quint16(crc >> 1);
+        tables[0][i] = crc;
+    }
+    for (quint32 n = 1; n < 8; ++n) {
+        for (quint32 i = 0; i < 256; ++i) {
+            const quint16 previous = tables[n - 1][i];
+            tables[n][i] = quint16((previous >> 8) ^ tables[0][previous & 0xFF]);
+        }
+    }
+    return tables;
+}
+
+} // namespace QtModbusPrivate
+
 class QModbusSerialAdu
 {
 public:
@@ -111,10 +139,12 @@ public:
     */
     inline static quint8 calculateLRC(const char *data, qint32 len)
     {
-        quint32 lrc = 0;
-        while (len--)
-            lrc += *data++;
-        return -(quint8(lrc));
+        // unsigned 8 bit arithmetic, so the compiler can vectorize the loop
+        const uchar *bytes = reinterpret_cast<const uchar *>(data);
+        quint8 lrc = 0;
+        for (qint32 i = 0; i < len; ++i)
+            lrc += bytes[i];
+        return quint8(-lrc);
     }
 
     /*!
@@ -123,31 +153,27 @@ public:
 
         Returns the CRC checksum of the first \a len bytes of \a data.
 
-        \note The code used by the function was generated with pycrc. There is no copyright assigned
-        to the generated code, however, the author of the script requests to show the line stating
-        that the code was generated by pycrc (see implementation).
+        The checksum uses the reflected polynomial 0xA001 (Width = 16, Poly = 0x8005,
+        XorIn = 0xffff, ReflectIn = True, XorOut = 0x0000, ReflectOut = True) and processes
+        eight bytes per step with the slicing-by-8 lookup tables generated at compile time.
+        The returned value has its bytes swapped, so that it can be streamed in big-endian
+        byte order.
     */
     inline static quint16 calculateCRC(const char *data, qint32 len)
     {
-        // Generated by pycrc v0.8.3, https://pycrc.org
-        // Width = 16, Poly = 0x8005, XorIn = 0xffff, ReflectIn = True,
-        // XorOut = 0x0000, ReflectOut = True, Algorithm = bit-by-bit-fast
-
+        const uchar *bytes = reinterpret_cast<const uchar *>(data);
         quint16 crc = 0xFFFF;
-        while (len--) {
-            const quint8 c = *data++;
-            for (qint32 i = 0x01; i & 0xFF; i <<= 1) {
-                bool bit = crc & 0x8000;
-                if (c & i)
-                    bit = !bit;
-                crc <<= 1;
-                if (bit)
-                    crc ^= 0x8005;
-            }
-            crc &= 0xFFFF;
+
+        for (; len >= 8; len -= 8, bytes += 8) {
+            crc = crcTables[7][(crc ^ bytes[0]) & 0xFF] ^ crcTables[6][((crc >> 8) ^ bytes[1]) & 0xFF]
+                ^ crcTables[5][bytes[2]] ^ crcTables[4][bytes[3]]
+                ^ crcTables[3][bytes[4]] ^ crcTables[2][bytes[5]]
+                ^ crcTables[1][bytes[6]] ^ crcTables[0][bytes[7]];
         }
-        crc = crc_reflect(crc & 0xFFFF, 16) ^ 0x0000;
-        return (crc >> 8) | (crc << 8); // swap bytes
+        while (len--)
+            crc = (crc >> 8) ^ crcTables[0][(crc ^ *bytes++) & 0xFF];
+
+        return quint16((crc >> 8) | (crc << 8)); // swap bytes
     }
 
     inline static QByteArray create(Type type, int serverAddress, const QModbusPdu &pdu,
@@ -166,19 +192,7 @@ public:
     }
 
 private:
-    inline static quint16 crc_reflect(quint16 data, qint32 len)
-    {
-        // Generated by pycrc v0.8.3, https://pycrc.org
-        // Width = 16, Poly = 0x8005, XorIn = 0xffff, ReflectIn = True,
-        // XorOut = 0x0000, ReflectOut = True, Algorithm = bit-by-bit-fast
-
-        quint16 ret = data & 0x01;
-        for (qint32 i = 1; i < len; i++) {
-            data >>= 1;
-            ret = (ret << 1) | (data & 0x01);
-        }
-        return ret;
-    }
+    static constexpr QtModbusPrivate::CrcTables crcTables = QtModbusPrivate::createCrcTables();
 
 private:
     Type m_type = Rtu;
@@ -0,0 +1,156 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMODBUSBITPACKING_P_H
+#define QMODBUSBITPACKING_P_H
+
+#include <QtCore/qendian.h>
+#include <QtCore/qglobal.h>
+#include <private/qsimd_p.h>
+
+#include <cstring>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+// Converts between coil or discrete input values, one quint16 per value, and
+// the packed representation on the wire: eight values per byte, the first
+// value in the least significant bit.
+namespace QModbusBitPacking {
+
+// Packs the eight values at values into one byte; any non-zero value is a set bit.
+inline uchar packByte(const quint16 *values) noexcept
+{
+    // Each 16-bit lane holds one value, the first value in the lowest lane.
+    quint64 lanes[2];
+    std::memcpy(lanes, values, sizeof(lanes));
+
+    uchar byte = 0;
+    for (int half = 0; half < 2; ++half) {
+        quint64 x = qFromLittleEndian(lanes[half]);
+        // Fold the high byte of each lane into its low byte, then turn every
+        // non-zero low byte into bit 0 of its lane.
+        x = (x | (x >> 8)) & Q_UINT64_C(0x00ff00ff00ff00ff);
+        x = ((x + Q_UINT64_C(0x00ff00ff00ff00ff)) >> 8) & Q_UINT64_C(0x0001000100010001);
+        // Gather bit 0 of the four lanes into the bits 48 to 51.
+        x *= (Q_UINT64_C(1) << 48) | (Q_UINT64_C(1) << 33) | (Q_UINT64_C(1) << 18)
+            | (Q_UINT64_C(1) << 3);
+        byte |= uchar(((x >> 48) & 0x0f) << (half * 4));
+    }
+    return byte;
+}
+
+// Unpacks one byte into eight values of 0 or 1.
+inline void unpackByte(uchar byte, quint16 *values) noexcept
+{
+    quint64 lanes[2];
+    for (int half = 0; half < 2; ++half) {
+        // Spread the four bits of the nibble to bit 0 of the four lanes.
+        const quint64 nibble = (byte >> (half * 4)) & 0x0f;
+        const quint64 x = (nibble * ((Q_UINT64_C(1) << 45) | (Q_UINT64_C(1) << 30)
+                                     | (Q_UINT64_C(1) << 15) | 1))
+            & Q_UINT64_C(0x0001000100010001);
+        lanes[half] = qToLittleEndian(x);
+    }
+    std::memcpy(values, lanes, sizeof(lanes));
+}
+
+// Packs count values into (count + 7) / 8 bytes; the unused bits of the last
+// byte are zero.
+inline void pack(const quint16 *values, qsizetype count, uchar *bytes) noexcept
+{
+    qsizetype i = 0;
+#if defined(__SSE2__)
+    for (; count - i >= 16; i += 16) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i + 8));
+        // 0xff for every value that is zero, one byte per value
+        const __m128i zeros = _mm_packs_epi16(_mm_cmpeq_epi16(low, zero),
+                                              _mm_cmpeq_epi16(high, zero));
+        const uint mask = ~uint(_mm_movemask_epi8(zeros));
+        bytes[i / 8] = uchar(mask);
+        bytes[i / 8 + 1] = uchar(mask >> 8);
+    }
+#endif
+    for (; count - i >= 8; i += 8)
+        bytes[i / 8] = packByte(values + i);
+
+    if (i < count) {
+        uchar byte = 0;
+        for (int bit = 0; i + bit < count; ++bit) {
+            if (values[i + bit])
+                byte |= uchar(1U << bit);
+        }
+        bytes[i / 8] = byte;
+    }
+}
+
+// Unpacks the first count bits of bytes into values of 0 or 1.
+inline void unpack(const uchar *bytes, qsizetype count, quint16 *values) noexcept
+{
+    qsizetype i = 0;
+#if defined(__SSE2__)
+    const __m128i bits = _mm_setr_epi16(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    const __m128i one = _mm_set1_epi16(1);
+    for (; count - i >= 8; i += 8) {
+        const __m128i byte = _mm_set1_epi16(short(bytes[i / 8]));
+        const __m128i set = _mm_cmpeq_epi16(_mm_and_si128(byte, bits), bits);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(values + i), _mm_and_si128(set, one));
+    }
+#endif
+    for (; count - i >= 8; i += 8)
+        unpackByte(bytes[i / 8], values + i);
+
+    for (; i < count; ++i)
+        values[i] = (bytes[i / 8] >> (i % 8)) & 1;
+}
+
+} // namespace QModbusBitPacking
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSBITPACKING_P_H
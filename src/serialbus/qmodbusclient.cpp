@@ -36,9 +36,11 @@
 
 #include "qmodbusclient.h"
 #include "qmodbusclient_p.h"
+#include "qmodbusbitpacking_p.h"
 #include "qmodbus_symbols_p.h"
 
 #include <QtCore/qdebug.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qloggingcategory.h>
 
 QT_BEGIN_NAMESPACE
@@ -298,15 +300,11 @@ QModbusRequest QModbusClientPrivate::createWriteRequest(const QModbusDataUnit &d
         if ((data.valueCount() % 8) != 0)
             byteCount += 1;
 
-        qsizetype address = 0;
-        QList<quint8> bytes;
-        for (quint8 i = 0; i < byteCount; ++i) {
-            quint8 byte = 0;
-            for (int currentBit = 0; currentBit < 8; ++currentBit)
-                if (data.value(address++))
-                    byte |= (1U << currentBit);
-            bytes.append(byte);
-        }
+        // Values missing from data are written as zero.
+        QList<quint8> bytes(byteCount);
+        const QList<quint16> values = data.values();
+        QModbusBitPacking::pack(values.constData(), qMin(data.valueCount(), values.size()),
+                                bytes.data());
 
         return QModbusRequest(QModbusRequest::WriteMultipleCoils, quint16(data.startAddress()),
                               quint16(data.valueCount()), byteCount, bytes);
@@ -454,15 +452,9 @@ bool QModbusClientPrivate::collateBits(const QModbusPdu &response,
 
     if (data) {
         const int valueCount = byteCount *8;
-        const QByteArray payload = response.data();
-
-        qsizetype value = 0;
         QList<quint16> values(valueCount);
-        for (qsizetype i = 1; i < payload.size(); ++i) {
-            const quint8 byte = quint8(payload[i]);
-            for (qint32 currentBit = 0; currentBit < 8 && value < valueCount; ++currentBit)
-                values[value++] = (byte & (1U << currentBit) ? 1 : 0);
-        }
+        QModbusBitPacking::unpack(reinterpret_cast<const uchar *>(response.data().constData() + 1),
+                                  valueCount, values.data());
         data->setValues(values);
         data->setRegisterType(type);
     }
@@ -501,15 +493,9 @@ bool QModbusClientPrivate::collateBytes(const QModbusPdu &response,
         return false;
 
     if (data) {
-        QDataStream stream(response.data().remove(0, 1));
-
-        QList<quint16> values;
         const quint8 itemCount = byteCount / 2;
-        for (int i = 0; i < itemCount; i++) {
-            quint16 tmp;
-            stream >> tmp;
-            values.append(tmp);
-        }
+        QList<quint16> values(itemCount);
+        qFromBigEndian<quint16>(response.data().constData() + 1, itemCount, values.data());
         data->setValues(values);
         data->setRegisterType(type);
     }
@@ -37,7 +37,7 @@
 #ifndef QMODBUSCLIENT_P_H
 #define QMODBUSCLIENT_P_H
 
-#include <QtCore/qtimer.h>
+#include <QtCore/qpointer.h>
 #include <QtSerialBus/qmodbusclient.h>
 #include <QtSerialBus/qmodbuspdu.h>
 
@@ -107,15 +107,8 @@ public:
         QueueElement() = default;
         QueueElement(QModbusReply *r, const QModbusRequest &req, const QModbusDataUnit &u, int num,
                 int timeout = -1)
-            : reply(r), requestPdu(req), unit(u), numberOfRetries(num)
-        {
-            if (timeout >= 0) {
-                // always the case for TCP
-                timer = QSharedPointer<QTimer>::create();
-                timer->setSingleShot(true);
-                timer->setInterval(timeout);
-            }
-        }
+            : reply(r), requestPdu(req), unit(u), numberOfRetries(num), responseTimeout(timeout)
+        {}
         bool operator==(const QueueElement &other) const {
             return reply == other.reply;
         }
@@ -124,7 +117,7 @@ public:
         QModbusRequest requestPdu;
         QModbusDataUnit unit;
         int numberOfRetries;
-        QSharedPointer<QTimer> timer;
+        int responseTimeout = -1; // always set for TCP, the RTU client uses a shared timer
         QByteArray adu;
         qint64 bytesWritten = 0;
         qint32 m_timerId = INT_MIN;
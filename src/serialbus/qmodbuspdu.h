@@ -37,6 +37,7 @@
 #define QMODBUSPDU_H
 
 #include <QtCore/qdatastream.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qiodevice.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qmetatype.h>
@@ -145,40 +146,61 @@ private:
     template <typename T>
     using is_pod = std::integral_constant<bool, std::is_trivial<T>::value && std::is_standard_layout<T>::value>;
 
-    template <typename T> void encode(QDataStream *stream, const T &t) {
+    // The values are big-endian, the byte order QDataStream used before. Scalar
+    // arguments have a size known at compile time, lists add their elements.
+    template <typename T> struct EncodedSize
+        : std::integral_constant<qsizetype, qsizetype(sizeof(T))> {};
+    template <typename T> struct EncodedSize<QList<T>>
+        : std::integral_constant<qsizetype, 0> {};
+
+    template <typename T> static constexpr qsizetype listSize(const T &) noexcept { return 0; }
+    template <typename T> static qsizetype listSize(const QList<T> &list) noexcept {
+        return list.size() * qsizetype(sizeof(T));
+    }
+
+    template <typename T> static char *encodeValue(char *out, T t) noexcept {
         static_assert(is_pod<T>::value, "Only POD types supported.");
         static_assert(IsType<T, quint8, quint16>::value, "Only quint8 and quint16 supported.");
-        (*stream) << t;
+        qToBigEndian(t, out);
+        return out + sizeof(T);
     }
-    template <typename T> void decode(QDataStream *stream, T &t) const {
+    template <typename T> static char *encodeValue(char *out, const QList<T> &list) noexcept {
         static_assert(is_pod<T>::value, "Only POD types supported.");
-        static_assert(IsType<T, quint8 *, quint16 *>::value, "Only quint8* and quint16* supported.");
-        (*stream) >> *t;
+        static_assert(IsType<T, quint8, quint16>::value, "Only quint8 and quint16 supported.");
+        if (!list.isEmpty())
+            qToBigEndian<T>(list.constData(), list.size(), out);
+        return out + list.size() * qsizetype(sizeof(T));
     }
-    template<typename T>
-    void encode(QDataStream *stream, const QList<T> &vector)
-    {
+    // Like QDataStream, values behind the end of the data are read as 0
+    template <typename T> static void decodeValue(const char *&in, const char *end, T *t) noexcept {
         static_assert(is_pod<T>::value, "Only POD types supported.");
-        static_assert(IsType<T, quint8, quint16>::value, "Only quint8 and quint16 supported.");
-        for (int i = 0; i < vector.count(); ++i)
-            (*stream) << vector[i];
+        static_assert(IsType<T *, quint8 *, quint16 *>::value, "Only quint8* and quint16* supported.");
+        if (end - in < qsizetype(sizeof(T))) {
+            *t = 0;
+            in = end;
+            return;
+        }
+        *t = qFromBigEndian<T>(in);
+        in += sizeof(T);
     }
 
     template<typename ... Args> void encode(Args ... newData) {
-        m_data.clear();
-        Q_CONSTEXPR quint32 argCount = sizeof...(Args);
-        if (argCount > 0) {
-            QDataStream stream(&m_data, QIODevice::WriteOnly);
-            char tmp[argCount] = { (encode(&stream, newData), void(), '0')... };
-            Q_UNUSED(tmp);
+        if constexpr (sizeof...(Args) == 0) {
+            m_data.clear();
+        } else {
+            constexpr qsizetype fixedSize = (EncodedSize<Args>::value + ...);
+            m_data.resize(fixedSize + (listSize(newData) + ...));
+            char *out = m_data.data();
+            ((out = encodeValue(out, newData)), ...);
         }
     }
     template<typename ... Args> void decode(Args ... newData) const {
-        Q_CONSTEXPR quint32 argCount = sizeof...(Args);
-        if (argCount > 0 && !m_data.isEmpty()) {
-            QDataStream stream(m_data);
-            char tmp[argCount] = { (decode(&stream, newData), void(), '0')... };
-            Q_UNUSED(tmp);
+        if constexpr (sizeof...(Args) > 0) {
+            if (!m_data.isEmpty()) {
+                const char *in = m_data.constData();
+                const char *const end = in + m_data.size();
+                (decodeValue(in, end, newData), ...);
+            }
         }
     }
 
@@ -0,0 +1,439 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "qmodbusclient.h"
+#include "qmodbusreadplanner.h"
+#include "qmodbusreply.h"
+
+#include <QtCore/qdebug.h>
+#include <QtCore/qloggingcategory.h>
+#include <private/qobject_p.h>
+
+#include <algorithm>
+#include <numeric>
+#include <tuple>
+
+QT_BEGIN_NAMESPACE
+
+Q_DECLARE_LOGGING_CATEGORY(QT_MODBUS)
+
+class QModbusReadPlannerPrivate : public QObjectPrivate
+{
+    Q_DECLARE_PUBLIC(QModbusReadPlanner)
+
+public:
+    struct Tag
+    {
+        QModbusDataUnit unit;
+        int serverAddress;
+    };
+
+    void processReply(const QModbusReadPlanner::Request &request, const QList<Tag> &tags,
+                      QModbusReply *reply);
+    void requestFinished();
+
+    QList<Tag> m_tags;
+    int m_maximumGap = 0;
+    int m_pendingRequests = 0;
+};
+
+void QModbusReadPlannerPrivate::processReply(const QModbusReadPlanner::Request &request,
+                                             const QList<Tag> &tags, QModbusReply *reply)
+{
+    Q_Q(QModbusReadPlanner);
+    reply->deleteLater();
+
+    if (reply->error() != QModbusDevice::NoError) {
+        for (int index : request.tags)
+            emit q->tagErrorOccurred(index, reply->error());
+        requestFinished();
+        return;
+    }
+
+    const QModbusDataUnit result = reply->result();
+    const QList<quint16> values = result.values();
+    for (int index : request.tags) {
+        QModbusDataUnit data = tags.at(index).unit;
+        const qsizetype offset = qsizetype(data.startAddress()) - result.startAddress();
+        if (offset < 0 || offset + data.valueCount() > values.size()) {
+            qCWarning(QT_MODBUS) << "(Client) Read result does not cover tag" << index;
+            emit q->tagErrorOccurred(index, QModbusDevice::ProtocolError);
+            continue;
+        }
+        data.setValues(values.mid(offset, data.valueCount()));
+        emit q->tagRead(index, data);
+    }
+    requestFinished();
+}
+
+void QModbusReadPlannerPrivate::requestFinished()
+{
+    Q_Q(QModbusReadPlanner);
+    if (--m_pendingRequests == 0)
+        emit q->finished();
+}
+
+/*!
+    \class QModbusReadPlanner
+    \inmodule QtSerialBus
+    \since 6.3
+
+    \brief The QModbusReadPlanner class combines the reads of many tags into
+    few Modbus read requests.
+
+    A tag is a range of values of one register type of a Modbus server, as
+    described by a QModbusDataUnit. Instead of sending one read request per
+    tag, the tags are added to the planner once with addTag(). Each call to
+    read() then sends the smallest number of read requests that cover all tags:
+    tags of the same server and register type are read together if they
+    overlap, are adjacent or are at most maximumGap() addresses apart, as long
+    as a request stays within the protocol limit given by maximumReadCount().
+
+    The results are handed out per tag with the tagRead() and
+    tagErrorOccurred() signals, the finished() signal is emitted once all
+    requests have been answered.
+
+    \code
+    QModbusReadPlanner planner;
+    planner.setMaximumGap(4);
+    const int temperature = planner.addTag({ QModbusDataUnit::InputRegisters, 100, 2 }, 1);
+    const int pressure = planner.addTag({ QModbusDataUnit::InputRegisters, 104, 2 }, 1);
+    connect(&planner, &QModbusReadPlanner::tagRead, this,
+            [&](int tag, const QModbusDataUnit &data) { ... });
+    planner.read(client); // sends one request for the registers 100 to 105
+    \endcode
+
+    \sa QModbusClient::sendReadRequest()
+*/
+
+/*!
+    \class QModbusReadPlanner::Request
+    \inmodule QtSerialBus
+    \since 6.3
+
+    \brief The Request struct describes one read request planned by
+    QModbusReadPlanner.
+
+    The request reads \c unit from the server at \c serverAddress and covers
+    the tags with the indexes in \c tags.
+
+    \sa QModbusReadPlanner::requests()
+*/
+
+/*!
+    \fn void QModbusReadPlanner::tagRead(int tag, const QModbusDataUnit &data)
+
+    This signal is emitted when the values of \a tag have been read. \a data
+    holds the register type, address range and values of the tag.
+
+    \sa read(), tagErrorOccurred()
+*/
+
+/*!
+    \fn void QModbusReadPlanner::tagErrorOccurred(int tag, QModbusDevice::Error error)
+
+    This signal is emitted when \a tag could not be read because its read
+    request failed with \a error.
+
+    \sa read(), tagRead()
+*/
+
+/*!
+    \fn void QModbusReadPlanner::finished()
+
+    This signal is emitted when all requests sent by read() have been answered
+    or failed.
+
+    \sa isFinished()
+*/
+
+/*!
+    Constructs a QModbusReadPlanner without any tags with the specified \a parent.
+*/
+QModbusReadPlanner::QModbusReadPlanner(QObject *parent)
+    : QObject(*new QModbusReadPlannerPrivate, parent)
+{
+}
+
+/*!
+    Destroys the QModbusReadPlanner instance. The results of pending requests
+    are not handed out anymore; their replies are deleted when they finish.
+*/
+QModbusReadPlanner::~QModbusReadPlanner()
+{
+}
+
+/*!
+    Returns the number of unused addresses that may lie between two tags read
+    by one request. The default is \c 0, only overlapping and adjacent tags
+    are read together.
+
+    \sa setMaximumGap()
+*/
+int QModbusReadPlanner::maximumGap() const
+{
+    Q_D(const QModbusReadPlanner);
+    return d->m_maximumGap;
+}
+
+/*!
+    Sets the number of unused addresses that may lie between two tags read by
+    one request to \a gap. A larger gap means fewer, but longer requests.
+    Negative values are ignored.
+
+    \sa maximumGap()
+*/
+void QModbusReadPlanner::setMaximumGap(int gap)
+{
+    Q_D(QModbusReadPlanner);
+    if (gap >= 0)
+        d->m_maximumGap = gap;
+}
+
+/*!
+    Adds the values described by \a tag of the Modbus server at
+    \a serverAddress to the planner and returns the index of the tag, which is
+    passed to the tagRead() and tagErrorOccurred() signals. Returns \c -1 if
+    the tag cannot be read with a single request, because its register type is
+    invalid, its addresses are outside of the range \c 0 to \c 65535, or its
+    value count is zero or exceeds maximumReadCount().
+
+    \sa tag(), clear()
+*/
+int QModbusReadPlanner::addTag(const QModbusDataUnit &tag, int serverAddress)
+{
+    Q_D(QModbusReadPlanner);
+
+    const int maximum = maximumReadCount(tag.registerType());
+    const qint64 endAddress = qint64(tag.startAddress()) + tag.valueCount();
+    if (maximum == 0 || tag.startAddress() < 0 || tag.valueCount() < 1
+            || tag.valueCount() > maximum || endAddress > 0x10000
+            || serverAddress < 0 || serverAddress > 0xff) {
+        qCWarning(QT_MODBUS) << "(Client) Cannot plan reading of tag" << tag.registerType()
+                             << tag.startAddress() << tag.valueCount() << "from server"
+                             << serverAddress;
+        return -1;
+    }
+
+    d->m_tags.append({ QModbusDataUnit(tag.registerType(), tag.startAddress(),
+                                       quint16(tag.valueCount())), serverAddress });
+    return int(d->m_tags.size() - 1);
+}
+
+/*!
+    Returns the register type and address range of the tag with the index
+    \a tag, or an invalid QModbusDataUnit if there is no such tag.
+
+    \sa addTag(), tagServerAddress()
+*/
+QModbusDataUnit QModbusReadPlanner::tag(int tag) const
+{
+    Q_D(const QModbusReadPlanner);
+    if (tag < 0 || tag >= d->m_tags.size())
+        return QModbusDataUnit();
+    return d->m_tags.at(tag).unit;
+}
+
+/*!
+    Returns the address of the server the tag with the index \a tag is read
+    from, or \c -1 if there is no such tag.
+
+    \sa addTag(), tag()
+*/
+int QModbusReadPlanner::tagServerAddress(int tag) const
+{
+    Q_D(const QModbusReadPlanner);
+    if (tag < 0 || tag >= d->m_tags.size())
+        return -1;
+    return d->m_tags.at(tag).serverAddress;
+}
+
+/*!
+    Returns the number of tags added to the planner.
+*/
+qsizetype QModbusReadPlanner::tagCount() const
+{
+    Q_D(const QModbusReadPlanner);
+    return d->m_tags.size();
+}
+
+/*!
+    Removes all tags from the planner. Requests that have been sent already
+    still hand out their results with the indexes of the removed tags.
+*/
+void QModbusReadPlanner::clear()
+{
+    Q_D(QModbusReadPlanner);
+    d->m_tags.clear();
+}
+
+/*!
+    Returns the read requests that cover all tags, ordered by server address,
+    register type and start address.
+
+    Tags are sorted by address and assigned to requests from the lowest
+    address upwards. A tag joins the current request if it starts at most
+    maximumGap() addresses after the end of that request and the request does
+    not grow beyond maximumReadCount(); otherwise it starts a new request. This
+    gives the smallest number of requests for the given gap.
+
+    \sa read()
+*/
+QList<QModbusReadPlanner::Request> QModbusReadPlanner::requests() const
+{
+    Q_D(const QModbusReadPlanner);
+
+    using Tag = QModbusReadPlannerPrivate::Tag;
+    QList<int> order(d->m_tags.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [d](int left, int right) {
+        const Tag &l = d->m_tags.at(left);
+        const Tag &r = d->m_tags.at(right);
+        return std::make_tuple(l.serverAddress, l.unit.registerType(), l.unit.startAddress())
+            < std::make_tuple(r.serverAddress, r.unit.registerType(), r.unit.startAddress());
+    });
+
+    QList<Request> requests;
+    qint64 endAddress = 0; // of the last request, exclusive
+    for (int index : order) {
+        const Tag &tag = d->m_tags.at(index);
+        const QModbusDataUnit::RegisterType type = tag.unit.registerType();
+        const int startAddress = tag.unit.startAddress();
+        const qint64 tagEndAddress = qint64(startAddress) + tag.unit.valueCount();
+
+        if (!requests.isEmpty()) {
+            Request &last = requests.last();
+            const int lastStartAddress = last.unit.startAddress();
+            const qint64 mergedEndAddress = qMax(endAddress, tagEndAddress);
+            if (last.serverAddress == tag.serverAddress && last.unit.registerType() == type
+                    && startAddress - endAddress <= d->m_maximumGap
+                    && mergedEndAddress - lastStartAddress <= maximumReadCount(type)) {
+                last.tags.append(index);
+                if (mergedEndAddress != endAddress) {
+                    endAddress = mergedEndAddress;
+                    last.unit = QModbusDataUnit(type, lastStartAddress,
+                                                quint16(endAddress - lastStartAddress));
+                }
+                continue;
+            }
+        }
+
+        requests.append({ tag.serverAddress, tag.unit, { index } });
+        endAddress = tagEndAddress;
+    }
+    return requests;
+}
+
+/*!
+    Sends the requests() that cover all tags with \a client and returns
+    \c true if all of them could be sent. The results are handed out with the
+    tagRead() and tagErrorOccurred() signals; the tags of a request that could
+    not be sent report the error of \a client right away. The finished() signal
+    is emitted once all requests have been answered.
+
+    \sa requests(), isFinished()
+*/
+bool QModbusReadPlanner::read(QModbusClient *client)
+{
+    Q_D(QModbusReadPlanner);
+    if (!client)
+        return false;
+
+    const QList<QModbusReadPlannerPrivate::Tag> tags = d->m_tags;
+    const QList<Request> planned = requests();
+
+    // Do not emit finished() while requests are still being sent.
+    ++d->m_pendingRequests;
+
+    bool sent = true;
+    for (const Request &request : planned) {
+        QModbusReply *reply = client->sendReadRequest(request.unit, request.serverAddress);
+        if (!reply) {
+            sent = false;
+            for (int index : request.tags)
+                emit tagErrorOccurred(index, client->error());
+            continue;
+        }
+
+        ++d->m_pendingRequests;
+        if (reply->isFinished()) {
+            d->processReply(request, tags, reply);
+        } else {
+            connect(reply, &QModbusReply::finished, reply, &QObject::deleteLater);
+            connect(reply, &QModbusReply::finished, this, [this, request, tags, reply]() {
+                Q_D(QModbusReadPlanner);
+                d->processReply(request, tags, reply);
+            });
+        }
+    }
+
+    d->requestFinished();
+    return sent;
+}
+
+/*!
+    Returns \c true if all requests sent by read() have been answered or
+    failed.
+
+    \sa finished()
+*/
+bool QModbusReadPlanner::isFinished() const
+{
+    Q_D(const QModbusReadPlanner);
+    return d->m_pendingRequests == 0;
+}
+
+/*!
+    Returns the largest number of values of the register \a type that one read
+    request may cover according to the Modbus Application Protocol
+    Specification: \c 2000 coils or discrete inputs, or \c 125 input or holding
+    registers. Returns \c 0 for an invalid \a type.
+*/
+int QModbusReadPlanner::maximumReadCount(QModbusDataUnit::RegisterType type)
+{
+    switch (type) {
+    case QModbusDataUnit::Coils:
+    case QModbusDataUnit::DiscreteInputs:
+        return 0x07D0;
+    case QModbusDataUnit::InputRegisters:
+    case QModbusDataUnit::HoldingRegisters:
+        return 0x007D;
+    default:
+        return 0;
+    }
+}
+
+QT_END_NAMESPACE
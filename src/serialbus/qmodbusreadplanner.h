@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2017 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMODBUSREADPLANNER_H
+#define QMODBUSREADPLANNER_H
+
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+#include <QtSerialBus/qmodbusdataunit.h>
+#include <QtSerialBus/qmodbusdevice.h>
+
+QT_BEGIN_NAMESPACE
+
+class QModbusClient;
+class QModbusReadPlannerPrivate;
+
+class Q_SERIALBUS_EXPORT QModbusReadPlanner : public QObject
+{
+    Q_OBJECT
+    Q_DECLARE_PRIVATE(QModbusReadPlanner)
+
+public:
+    struct Request
+    {
+        int serverAddress = -1;
+        QModbusDataUnit unit;
+        QList<int> tags;
+    };
+
+    explicit QModbusReadPlanner(QObject *parent = nullptr);
+    ~QModbusReadPlanner();
+
+    int maximumGap() const;
+    void setMaximumGap(int gap);
+
+    int addTag(const QModbusDataUnit &tag, int serverAddress);
+    QModbusDataUnit tag(int tag) const;
+    int tagServerAddress(int tag) const;
+    qsizetype tagCount() const;
+    void clear();
+
+    QList<Request> requests() const;
+
+    bool read(QModbusClient *client);
+    bool isFinished() const;
+
+    static int maximumReadCount(QModbusDataUnit::RegisterType type);
+
+Q_SIGNALS:
+    void tagRead(int tag, const QModbusDataUnit &data);
+    void tagErrorOccurred(int tag, QModbusDevice::Error error);
+    void finished();
+};
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSREADPLANNER_H
@@ -0,0 +1,214 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMODBUSREGISTERBANK_P_H
+#define QMODBUSREGISTERBANK_P_H
+
+#include <QtSerialBus/qmodbusdataunit.h>
+
+#include <QtCore/qlist.h>
+
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+// Default backing store of QModbusServer.
+//
+// Each of the four tables holds any number of address ranges. The values of
+// all ranges of a table are stored in one flat array, and the ranges are kept
+// sorted by address, so that a request is resolved with a binary search to a
+// pointer into that array. Adjacent ranges are merged, so that a request may
+// span them.
+class QModbusRegisterBank
+{
+public:
+    // Replaces all tables with the given ranges. Ranges of the same table must
+    // not overlap; otherwise false is returned and the bank stays unchanged.
+    // Invalid units are ignored.
+    bool setRanges(const QList<QModbusDataUnit> &ranges)
+    {
+        std::array<Table, TableCount> tables;
+
+        std::vector<const QModbusDataUnit *> sorted;
+        sorted.reserve(ranges.size());
+        for (const QModbusDataUnit &unit : ranges) {
+            if (unit.isValid() && tableIndex(unit.registerType()) >= 0)
+                sorted.push_back(&unit);
+        }
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const QModbusDataUnit *a, const QModbusDataUnit *b) {
+            return a->startAddress() < b->startAddress();
+        });
+
+        for (const QModbusDataUnit *unit : sorted) {
+            Table &table = tables[tableIndex(unit->registerType())];
+            table.defined = true;
+
+            const qsizetype count = unit->valueCount();
+            if (count <= 0)
+                continue;
+
+            const int startAddress = unit->startAddress();
+            const qint64 endAddress = qint64(startAddress) + count;
+            if (!table.ranges.empty() && startAddress < table.ranges.back().endAddress)
+                return false;
+
+            if (!table.ranges.empty() && startAddress == table.ranges.back().endAddress)
+                table.ranges.back().endAddress = endAddress;
+            else
+                table.ranges.push_back({ startAddress, endAddress, qsizetype(table.values.size()) });
+
+            // values the unit does not carry are zero
+            const QList<quint16> values = unit->values();
+            const qsizetype available = qMin(count, values.size());
+            table.values.insert(table.values.end(), values.cbegin(), values.cbegin() + available);
+            table.values.resize(table.values.size() + (count - available), 0);
+        }
+
+        m_tables = std::move(tables);
+        return true;
+    }
+
+    bool hasTable(QModbusDataUnit::RegisterType type) const
+    {
+        const int index = tableIndex(type);
+        return index >= 0 && m_tables[index].defined;
+    }
+
+    // Returns the values from address to address + count - 1, or nullptr if
+    // they are not all inside one range.
+    const quint16 *find(QModbusDataUnit::RegisterType type, int address, qsizetype count) const
+    {
+        const int index = tableIndex(type);
+        if (index < 0)
+            return nullptr;
+
+        const Table &table = m_tables[index];
+        auto range = std::upper_bound(table.ranges.cbegin(), table.ranges.cend(), address,
+                                      [](int address, const Range &range) {
+            return address < range.startAddress;
+        });
+        if (range == table.ranges.cbegin())
+            return nullptr;
+        --range;
+
+        // like the single range store before, the first and the last address
+        // of the request must be inside the range
+        const qint64 lastAddress = qint64(address) + count - 1;
+        if (address >= range->endAddress || lastAddress < range->startAddress
+                || lastAddress >= range->endAddress) {
+            return nullptr;
+        }
+        return table.values.data() + range->offset + (address - range->startAddress);
+    }
+
+    quint16 *find(QModbusDataUnit::RegisterType type, int address, qsizetype count)
+    {
+        return const_cast<quint16 *>(std::as_const(*this).find(type, address, count));
+    }
+
+    // Returns one unit from the first to the last address of the table, the
+    // gaps between the ranges read as zero.
+    QModbusDataUnit table(QModbusDataUnit::RegisterType type) const
+    {
+        const int index = tableIndex(type);
+        if (index < 0 || m_tables[index].ranges.empty())
+            return QModbusDataUnit(type, 0, QList<quint16>());
+
+        const Table &table = m_tables[index];
+        const int startAddress = table.ranges.front().startAddress;
+        QList<quint16> values(table.ranges.back().endAddress - startAddress, 0);
+        for (const Range &range : table.ranges) {
+            const auto first = table.values.cbegin() + range.offset;
+            std::copy(first, first + (range.endAddress - range.startAddress),
+                      values.begin() + (range.startAddress - startAddress));
+        }
+        return QModbusDataUnit(type, startAddress, values);
+    }
+
+private:
+    enum { TableCount = 4 };
+
+    struct Range
+    {
+        int startAddress;
+        qint64 endAddress; // exclusive
+        qsizetype offset; // into Table::values
+    };
+
+    struct Table
+    {
+        bool defined = false;
+        std::vector<Range> ranges;
+        std::vector<quint16> values;
+    };
+
+    static int tableIndex(QModbusDataUnit::RegisterType type)
+    {
+        switch (type) {
+        case QModbusDataUnit::DiscreteInputs:
+            return 0;
+        case QModbusDataUnit::Coils:
+            return 1;
+        case QModbusDataUnit::InputRegisters:
+            return 2;
+        case QModbusDataUnit::HoldingRegisters:
+            return 3;
+        default:
+            return -1;
+        }
+    }
+
+    std::array<Table, TableCount> m_tables;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSREGISTERBANK_P_H
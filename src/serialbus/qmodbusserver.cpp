@@ -37,14 +37,16 @@
 #include "qmodbusdeviceidentification.h"
 #include "qmodbusserver.h"
 #include "qmodbusserver_p.h"
+#include "qmodbusbitpacking_p.h"
 #include "qmodbus_symbols_p.h"
 
-#include <QtCore/qbitarray.h>
 #include <QtCore/qdebug.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qloggingcategory.h>
 
 #include <algorithm>
+#include <cstring>
 
 QT_BEGIN_NAMESPACE
 
@@ -127,6 +129,28 @@ bool QModbusServer::setMap(const QModbusDataUnitMap &map)
     return d_func()->setMap(map);
 }
 
+/*!
+    \since 6.3
+
+    Sets the registered map structure for requests from other Modbus clients to
+    \a ranges. Unlike setMap(), a register type may be given any number of
+    ranges; each unit in \a ranges defines the register type, the addresses
+    and the initial values of one of them. Ranges that directly follow each
+    other are merged, so that a single request may span them. Returns \c true
+    on success; otherwise \c false if two ranges of the same register type
+    overlap, in which case the previous map is kept.
+
+    \note This function sets up the default backing store used by readData()
+    and writeData(). Sub-classes that implement a different backing store
+    need to reimplement setMap() instead.
+
+    \sa setMap()
+*/
+bool QModbusServer::setMapRanges(const QList<QModbusDataUnit> &ranges)
+{
+    return d_func()->setMapRanges(ranges);
+}
+
 /*!
     Sets the address for this Modbus server instance to \a serverAddress.
 
@@ -208,29 +232,29 @@ QVariant QModbusServer::value(int option) const
 
     switch (option) {
         case DiagnosticRegister:
-            return d->m_serverOptions.value(option, quint16(0x0000));
+            return d->m_unit->serverOptions.value(option, quint16(0x0000));
         case ExceptionStatusOffset:
-            return d->m_serverOptions.value(option, quint16(0x0000));
+            return d->m_unit->serverOptions.value(option, quint16(0x0000));
         case DeviceBusy:
-            return d->m_serverOptions.value(option, quint16(0x0000));
+            return d->m_unit->serverOptions.value(option, quint16(0x0000));
         case AsciiInputDelimiter:
-            return d->m_serverOptions.value(option, '\n');
+            return d->m_unit->serverOptions.value(option, '\n');
         case ListenOnlyMode:
-            return d->m_serverOptions.value(option, false);
+            return d->m_unit->serverOptions.value(option, false);
         case ServerIdentifier:
-            return d->m_serverOptions.value(option, quint8(0x0a));
+            return d->m_unit->serverOptions.value(option, quint8(0x0a));
         case RunIndicatorStatus:
-            return d->m_serverOptions.value(option, quint8(0xff));
+            return d->m_unit->serverOptions.value(option, quint8(0xff));
         case AdditionalData:
-            return d->m_serverOptions.value(option, QByteArray("Qt Modbus Server"));
+            return d->m_unit->serverOptions.value(option, QByteArray("Qt Modbus Server"));
         case DeviceIdentification:
-            return d->m_serverOptions.value(option, QVariant());
+            return d->m_unit->serverOptions.value(option, QVariant());
     };
 
     if (option < UserOption)
         return QVariant();
 
-    return d->m_serverOptions.value(option, QVariant());
+    return d->m_unit->serverOptions.value(option, QVariant());
 }
 
 /*!
@@ -319,7 +343,7 @@ bool QModbusServer::setValue(int option, const QVariant &newValue)
     switch (option) {
     case DiagnosticRegister:
         CHECK_INT_OR_UINT(newValue);
-        d->m_serverOptions.insert(option, newValue);
+        d->m_unit->serverOptions.insert(option, newValue);
         return true;
     case ExceptionStatusOffset: {
         CHECK_INT_OR_UINT(newValue);
@@ -327,7 +351,7 @@ bool QModbusServer::setValue(int option, const QVariant &newValue)
         QModbusDataUnit coils(QModbusDataUnit::Coils, tmp, 8);
         if (!data(&coils))
             return false;
-        d->m_serverOptions.insert(option, tmp);
+        d->m_unit->serverOptions.insert(option, tmp);
         return true;
     }
     case DeviceBusy: {
@@ -335,7 +359,7 @@ bool QModbusServer::setValue(int option, const QVariant &newValue)
         const quint16 tmp = newValue.value<quint16>();
         if ((tmp != 0x0000) && (tmp != 0xffff))
             return false;
-        d->m_serverOptions.insert(option, tmp);
+        d->m_unit->serverOptions.insert(option, tmp);
         return true;
     }
     case AsciiInputDelimiter: {
@@ -343,25 +367,25 @@ bool QModbusServer::setValue(int option, const QVariant &newValue)
         bool ok = false;
         if (newValue.toUInt(&ok) > 0xff || !ok)
             return false;
-        d->m_serverOptions.insert(option, newValue);
+        d->m_unit->serverOptions.insert(option, newValue);
         return true;
     }
     case ListenOnlyMode: {
         if (newValue.typeId() != QMetaType::Type::Bool)
             return false;
-        d->m_serverOptions.insert(option, newValue);
+        d->m_unit->serverOptions.insert(option, newValue);
         return true;
     }
     case ServerIdentifier:
         CHECK_INT_OR_UINT(newValue);
-        d->m_serverOptions.insert(option, newValue);
+        d->m_unit->serverOptions.insert(option, newValue);
         return true;
     case RunIndicatorStatus: {
         CHECK_INT_OR_UINT(newValue);
         const quint8 tmp = newValue.value<quint8>();
         if ((tmp != 0x00) && (tmp != 0xff))
             return false;
-        d->m_serverOptions.insert(option, tmp);
+        d->m_unit->serverOptions.insert(option, tmp);
         return true;
     }
     case AdditionalData: {
@@ -370,13 +394,13 @@ bool QModbusServer::setValue(int option, const QVariant &newValue)
         const QByteArray additionalData = newValue.toByteArray();
         if (additionalData.size() > 249)
             return false;
-        d->m_serverOptions.insert(option, additionalData);
+        d->m_unit->serverOptions.insert(option, additionalData);
         return true;
     }
     case DeviceIdentification:
         if (!newValue.canConvert<QModbusDeviceIdentification>())
             return false;
-        d->m_serverOptions.insert(option, newValue);
+        d->m_unit->serverOptions.insert(option, newValue);
         return true;
     default:
         break;
@@ -384,7 +408,7 @@ bool QModbusServer::setValue(int option, const QVariant &newValue)
 
     if (option < UserOption)
         return false;
-    d->m_serverOptions.insert(option, newValue);
+    d->m_unit->serverOptions.insert(option, newValue);
     return true;
 
 #undef CHECK_INT_OR_UINT
@@ -482,31 +506,22 @@ bool QModbusServer::setData(const QModbusDataUnit &newData)
 bool QModbusServer::writeData(const QModbusDataUnit &newData)
 {
     Q_D(QModbusServer);
-    if (!d->m_modbusDataUnitMap.contains(newData.registerType()))
-        return false;
 
-    QModbusDataUnit &current = d->m_modbusDataUnitMap[newData.registerType()];
-    if (!current.isValid())
+    const qsizetype count = newData.valueCount();
+    quint16 *current = d->m_unit->registerBank.find(newData.registerType(), newData.startAddress(),
+                                              count);
+    if (!current)
         return false;
 
-    // check range start is within internal map range
-    int internalRangeEndAddress = current.startAddress() + current.valueCount() - 1;
-    if (newData.startAddress() < current.startAddress()
-        || newData.startAddress() > internalRangeEndAddress) {
-        return false;
-    }
-
-    // check range end is within internal map range
-    int rangeEndAddress = newData.startAddress() + newData.valueCount() - 1;
-    if (rangeEndAddress < current.startAddress() || rangeEndAddress > internalRangeEndAddress)
-        return false;
-
-    bool changeRequired = false;
-    for (qsizetype i = 0; i < newData.valueCount(); i++) {
-        const quint16 newValue = newData.value(i);
-        const qsizetype translatedIndex = newData.startAddress() - current.startAddress() + i;
-        changeRequired |= (current.value(translatedIndex) != newValue);
-        current.setValue(translatedIndex, newValue);
+    // values missing from newData are written as zero
+    const QList<quint16> values = newData.values();
+    const qsizetype available = qMin(count, values.size());
+    const size_t bytes = size_t(available) * sizeof(quint16);
+    bool changeRequired = std::memcmp(current, values.constData(), bytes) != 0;
+    std::memcpy(current, values.constData(), bytes);
+    for (qsizetype i = available; i < count; ++i) {
+        changeRequired |= (current[i] != 0);
+        current[i] = 0;
     }
 
     if (changeRequired)
@@ -529,32 +544,22 @@ bool QModbusServer::readData(QModbusDataUnit *newData) const
 {
     Q_D(const QModbusServer);
 
-    if ((!newData) || (!d->m_modbusDataUnitMap.contains(newData->registerType())))
-        return false;
-
-    const QModbusDataUnit &current = d->m_modbusDataUnitMap.value(newData->registerType());
-    if (!current.isValid())
+    if ((!newData) || (!d->m_unit->registerBank.hasTable(newData->registerType())))
         return false;
 
      // return entire map for given type
     if (newData->startAddress() < 0) {
-        *newData = current;
+        *newData = d->m_unit->registerBank.table(newData->registerType());
         return true;
     }
 
-    // check range start is within internal map range
-    int internalRangeEndAddress = current.startAddress() + current.valueCount() - 1;
-    if (newData->startAddress() < current.startAddress()
-        || newData->startAddress() > internalRangeEndAddress) {
+    const qsizetype count = newData->valueCount();
+    const quint16 *current = d->m_unit->registerBank.find(newData->registerType(),
+                                                    newData->startAddress(), count);
+    if (!current)
         return false;
-    }
 
-    // check range end is within internal map range
-    const int rangeEndAddress = newData->startAddress() + newData->valueCount() - 1;
-    if (rangeEndAddress < current.startAddress() || rangeEndAddress > internalRangeEndAddress)
-        return false;
-
-    newData->setValues(current.values().mid(newData->startAddress() - current.startAddress(), newData->valueCount()));
+    newData->setValues(QList<quint16>(current, current + count));
     return true;
 }
 
@@ -627,8 +632,22 @@ QModbusResponse QModbusServer::processPrivateRequest(const QModbusPdu &request)
 
 bool QModbusServerPrivate::setMap(const QModbusDataUnitMap &map)
 {
-    m_modbusDataUnitMap = map;
-    return true;
+    // the map key decides about the table, as it did for lookups before
+    QList<QModbusDataUnit> ranges;
+    ranges.reserve(map.size());
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        if (!it.value().isValid())
+            continue;
+        QModbusDataUnit unit = it.value();
+        unit.setRegisterType(it.key());
+        ranges.append(unit);
+    }
+    return m_unit->registerBank.setRanges(ranges);
+}
+
+bool QModbusServerPrivate::setMapRanges(const QList<QModbusDataUnit> &ranges)
+{
+    return m_unit->registerBank.setRanges(ranges);
 }
 
 QModbusResponse QModbusServerPrivate::processRequest(const QModbusPdu &request)
@@ -725,22 +744,14 @@ QModbusResponse QModbusServerPrivate::readBits(const QModbusPdu &request,
             QModbusExceptionResponse::IllegalDataAddress);
     }
 
-    quint8 byteCount = quint8(count / 8);
-    if ((count % 8) != 0) {
-        byteCount += 1;
-        // If the range is not a multiple of 8, resize.
-        unit.setValueCount(byteCount * 8);
-    }
-
-    // Using byteCount * 8 so the remaining bits in the last byte are zero
-    QBitArray bytes(byteCount * 8);
-
-    address = 0; // The data range now starts with zero.
-    for ( ; address < count; ++address)
-        bytes.setBit(address, unit.value(address));
+    const quint8 byteCount = quint8((count + 7) / 8);
 
-    QByteArray payload = QByteArray::fromRawData(bytes.bits(), byteCount);
-    payload.prepend(char(byteCount));
+    // The remaining bits in the last byte, and values missing from the unit, are zero.
+    QByteArray payload(1 + byteCount, '\0');
+    payload[0] = char(byteCount);
+    const QList<quint16> values = unit.values();
+    QModbusBitPacking::pack(values.constData(), qMin<qsizetype>(count, values.size()),
+                            reinterpret_cast<uchar *>(payload.data() + 1));
     return QModbusResponse(request.functionCode(), payload);
 }
 
@@ -864,7 +875,7 @@ QModbusResponse QModbusServerPrivate::processDiagnosticsRequest(const QModbusReq
         // back into communication. If data is 0xff00, the event log history is also cleared.
         q_func()->disconnectDevice();
         if (data == 0xff00)
-            m_commEventLog.clear();
+            m_unit->commEventLog.clear();
 
         resetCommunicationCounters();
         q_func()->setValue(QModbusServer::ListenOnlyMode, false);
@@ -908,11 +919,11 @@ QModbusResponse QModbusServerPrivate::processDiagnosticsRequest(const QModbusReq
     case Diagnostics::ReturnBusCharacterOverrunCount:
         CHECK_SIZE_AND_CONDITION(request, (data != 0x0000));
         return QModbusResponse(request.functionCode(), subFunctionCode,
-                               m_counters[static_cast<Counter> (subFunctionCode)]);
+                               m_unit->counters[static_cast<Counter> (subFunctionCode)]);
 
     case Diagnostics::ClearOverrunCounterAndFlag: {
         CHECK_SIZE_AND_CONDITION(request, (data != 0x0000));
-        m_counters[Diagnostics::ReturnBusCharacterOverrunCount] = 0;
+        m_unit->counters[Diagnostics::ReturnBusCharacterOverrunCount] = 0;
         quint16 reg = q_func()->value(QModbusServer::DiagnosticRegister).value<quint16>();
         q_func()->setValue(QModbusServer::DiagnosticRegister, reg &~ 1); // clear first bit
         return QModbusResponse(request.functionCode(), request.data());
@@ -933,7 +944,8 @@ QModbusResponse QModbusServerPrivate::processGetCommEventCounterRequest(const QM
             QModbusExceptionResponse::ServerDeviceFailure);
     }
     const quint16 deviceBusy = tmp.value<quint16>();
-    return QModbusResponse(request.functionCode(), deviceBusy, m_counters[Counter::CommEvent]);
+    return QModbusResponse(request.functionCode(), deviceBusy,
+                           m_unit->counters[Counter::CommEvent]);
 }
 
 QModbusResponse QModbusServerPrivate::processGetCommEventLogRequest(const QModbusRequest &request)
@@ -946,12 +958,12 @@ QModbusResponse QModbusServerPrivate::processGetCommEventLogRequest(const QModbu
     }
     const quint16 deviceBusy = tmp.value<quint16>();
 
-    QList<quint8> eventLog(int(m_commEventLog.size()));
-    std::copy(m_commEventLog.cbegin(), m_commEventLog.cend(), eventLog.begin());
+    QList<quint8> eventLog(int(m_unit->commEventLog.size()));
+    std::copy(m_unit->commEventLog.cbegin(), m_unit->commEventLog.cend(), eventLog.begin());
 
     // 6 -> 3 x 2 Bytes (Status, Event Count and Message Count)
     return QModbusResponse(request.functionCode(), quint8(eventLog.size() + 6), deviceBusy,
-        m_counters[Counter::CommEvent], m_counters[Counter::BusMessage], eventLog);
+        m_unit->counters[Counter::CommEvent], m_unit->counters[Counter::BusMessage], eventLog);
 }
 
 QModbusResponse QModbusServerPrivate::processWriteMultipleCoilsRequest(const QModbusRequest &request)
@@ -983,20 +995,12 @@ QModbusResponse QModbusServerPrivate::processWriteMultipleCoilsRequest(const QMo
             QModbusExceptionResponse::IllegalDataAddress);
     }
 
-    QList<quint8> bytes;
-    const QByteArray payload = request.data().mid(5);
-    for (qint32 i = payload.size() - 1; i >= 0; --i)
-        bytes.append(quint8(payload[i]));
-
     // Since we picked the coils at start address, data
     // range is numberOfCoils and therefore index too.
-    quint16 coil = numberOfCoils;
-    qint32 currentBit = 8 - ((byteCount * 8) - numberOfCoils);
-    for (quint8 currentByte : qAsConst(bytes)) {
-        for (currentBit -= 1; currentBit >= 0; --currentBit)
-            coils.setValue(--coil, currentByte & (1U << currentBit) ? 1 : 0);
-        currentBit = 8;
-    }
+    QList<quint16> values(numberOfCoils);
+    QModbusBitPacking::unpack(reinterpret_cast<const uchar *>(request.data().constData() + 5),
+                              numberOfCoils, values.data());
+    coils.setValues(values);
 
     if (!q_func()->setData(coils)) {
         return QModbusExceptionResponse(request.functionCode(),
@@ -1032,16 +1036,8 @@ QModbusResponse QModbusServerPrivate::processWriteMultipleRegistersRequest(
             QModbusExceptionResponse::IllegalDataAddress);
     }
 
-    const QByteArray pduData = request.data().remove(0,5);
-    QDataStream stream(pduData);
-
-    QList<quint16> values;
-    quint16 tmp;
-    for (int i = 0; i < numberOfRegisters; i++) {
-        stream >> tmp;
-        values.append(tmp);
-    }
-
+    QList<quint16> values(numberOfRegisters);
+    qFromBigEndian<quint16>(request.data().constData() + 5, numberOfRegisters, values.data());
     registers.setValues(values);
 
     if (!q_func()->setData(registers)) {
@@ -1131,16 +1127,8 @@ QModbusResponse QModbusServerPrivate::processReadWriteMultipleRegistersRequest(
             QModbusExceptionResponse::IllegalDataAddress);
     }
 
-    const QByteArray pduData = request.data().remove(0,9);
-    QDataStream stream(pduData);
-
-    QList<quint16> values;
-    quint16 tmp;
-    for (int i = 0; i < writeQuantity; i++) {
-        stream >> tmp;
-        values.append(tmp);
-    }
-
+    QList<quint16> values(writeQuantity);
+    qFromBigEndian<quint16>(request.data().constData() + 9, writeQuantity, values.data());
     writeRegisters.setValues(values);
 
     if (!q_func()->setData(writeRegisters)) {
@@ -1304,9 +1292,9 @@ void QModbusServerPrivate::storeModbusCommEvent(const QModbusCommEvent &eventByt
     // Inserts an event byte at the start of the event log. If the event log
     // is already full, the byte at the end of the log will be removed. The
     // event log size is 64 bytes, starting at index 0.
-    m_commEventLog.push_front(eventByte);
-    if (m_commEventLog.size() > 64)
-        m_commEventLog.pop_back();
+    m_unit->commEventLog.push_front(eventByte);
+    if (m_unit->commEventLog.size() > 64)
+        m_unit->commEventLog.pop_back();
 }
 
 #undef CHECK_SIZE_EQUALS
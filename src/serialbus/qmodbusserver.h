@@ -75,6 +75,7 @@ public:
     void setServerAddress(int serverAddress);
 
     virtual bool setMap(const QModbusDataUnitMap &map);
+    bool setMapRanges(const QList<QModbusDataUnit> &ranges);
     virtual bool processesBroadcast() const { return false; }
 
     virtual QVariant value(int option) const;
@@ -42,10 +42,12 @@
 
 #include <private/qmodbuscommevent_p.h>
 #include <private/qmodbusdevice_p.h>
+#include <private/qmodbusregisterbank_p.h>
 #include <private/qmodbus_symbols_p.h>
 
 #include <array>
 #include <deque>
+#include <memory>
 
 //
 //  W A R N I N G
@@ -77,15 +79,44 @@ public:
         BusCharacterOverrun = Diagnostics::ReturnBusCharacterOverrunCount
     };
 
-    QModbusServerPrivate()
-        : m_counters()
+    // The registers, options, counters and event log of one server unit.
+    struct Unit
     {
-    }
+        std::array<quint16, 20> counters {};
+        QHash<int, QVariant> serverOptions;
+        QModbusRegisterBank registerBank;
+        std::deque<quint8> commEventLog;
+    };
+
+    QModbusServerPrivate() = default;
 
     bool setMap(const QModbusDataUnitMap &map);
+    bool setMapRanges(const QList<QModbusDataUnit> &ranges);
 
-    void resetCommunicationCounters() { m_counters.fill(0u); }
-    void incrementCounter(QModbusServerPrivate::Counter counter) { m_counters[counter]++; }
+    void resetCommunicationCounters() { m_unit->counters.fill(0u); }
+    void incrementCounter(QModbusServerPrivate::Counter counter) { m_unit->counters[counter]++; }
+
+    // Returns the unit that answers to unitId, or nullptr if there is none.
+    Unit *unit(int unitId) const
+    {
+        if (unitId == m_serverAddress)
+            return const_cast<Unit *>(&m_defaultUnit);
+        if (unitId < 0 || unitId >= int(m_units.size()))
+            return nullptr;
+        return m_units[unitId].get();
+    }
+
+    // Makes the unit that answers to unitId the current one; -1 selects, and
+    // an unknown unitId falls back to, the unit at the server address.
+    bool selectUnit(int unitId)
+    {
+        Unit *selected = (unitId == -1) ? &m_defaultUnit : unit(unitId);
+        m_unit = selected ? selected : &m_defaultUnit;
+        m_unitId = (m_unit == &m_defaultUnit) ? -1 : unitId;
+        return selected != nullptr;
+    }
+
+    int currentUnitId() const { return m_unitId < 0 ? m_serverAddress : m_unitId; }
 
     QModbusResponse processRequest(const QModbusPdu &request);
 
@@ -116,10 +147,14 @@ public:
     void storeModbusCommEvent(const QModbusCommEvent &eventByte);
 
     int m_serverAddress = 1;
-    std::array<quint16, 20> m_counters;
-    QHash<int, QVariant> m_serverOptions;
-    QModbusDataUnitMap m_modbusDataUnitMap;
-    std::deque<quint8> m_commEventLog;
+
+    // The unit at the server address and the additional units, indexed by unit
+    // identifier. m_unit is the one all accessors and requests operate on;
+    // m_unitId is -1 while this is the unit at the server address.
+    Unit m_defaultUnit;
+    std::array<std::unique_ptr<Unit>, 256> m_units;
+    Unit *m_unit = &m_defaultUnit;
+    int m_unitId = -1;
 };
 
 QT_END_NAMESPACE
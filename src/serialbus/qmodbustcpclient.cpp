@@ -49,6 +49,13 @@ QT_BEGIN_NAMESPACE
     \brief The QModbusTcpClient class is the interface class for Modbus TCP client device.
 
     QModbusTcpClient communicates with the Modbus backend providing users with a convenient API.
+
+    Requests are pipelined: a request is sent without waiting for the responses
+    to earlier requests, and all requests issued during one event loop iteration
+    are written to the socket at once. The number of requests awaiting a
+    response can be limited with setMaxInFlightRequests() and, for gateways
+    serving several units, with setMaxInFlightRequestsPerServer(). Requests
+    beyond these limits are queued and sent as soon as earlier requests finish.
 */
 
 /*!
@@ -69,6 +76,76 @@ QModbusTcpClient::~QModbusTcpClient()
     close();
 }
 
+/*!
+    \since 6.3
+
+    Returns the maximum number of requests that may await a response at the
+    same time. The default value is \c 0, meaning that there is no limit.
+
+    \sa setMaxInFlightRequests(), maxInFlightRequestsPerServer()
+*/
+int QModbusTcpClient::maxInFlightRequests() const
+{
+    Q_D(const QModbusTcpClient);
+    return d->m_maxInFlight;
+}
+
+/*!
+    \since 6.3
+
+    Sets the maximum number of requests that may await a response at the same
+    time to \a count. Further requests are queued and sent in the order they
+    were issued once earlier requests are answered, time out, or are deleted.
+    A \a count of \c 0 or less removes the limit.
+
+    \note The response timeout of a queued request only starts when the request
+    is written to the network.
+
+    \sa maxInFlightRequests(), setMaxInFlightRequestsPerServer()
+*/
+void QModbusTcpClient::setMaxInFlightRequests(int count)
+{
+    Q_D(QModbusTcpClient);
+    d->m_maxInFlight = qMax(0, count);
+    d->sendQueuedRequests();
+}
+
+/*!
+    \since 6.3
+
+    Returns the maximum number of requests to the same server address that may
+    await a response at the same time. The default value is \c 0, meaning that
+    there is no limit.
+
+    \sa setMaxInFlightRequestsPerServer(), maxInFlightRequests()
+*/
+int QModbusTcpClient::maxInFlightRequestsPerServer() const
+{
+    Q_D(const QModbusTcpClient);
+    return d->m_maxInFlightPerServer;
+}
+
+/*!
+    \since 6.3
+
+    Sets the maximum number of requests to the same server address that may
+    await a response at the same time to \a count. This is useful when talking
+    to a Modbus TCP gateway, where each server address denotes a separate
+    device behind the gateway that can only process a limited number of
+    requests at once. Queued requests to other server addresses are not held
+    back by a server that has no free slot. A \a count of \c 0 or less removes
+    the limit.
+
+    \sa maxInFlightRequestsPerServer(), setMaxInFlightRequests()
+*/
+void QModbusTcpClient::setMaxInFlightRequestsPerServer(int count)
+{
+    Q_D(QModbusTcpClient);
+    d->m_maxInFlightPerServer = qMax(0, count);
+    d->updateReadyServers();
+    d->sendQueuedRequests();
+}
+
 /*!
     \internal
 */
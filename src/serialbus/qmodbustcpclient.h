@@ -52,6 +52,12 @@ public:
     explicit QModbusTcpClient(QObject *parent = nullptr);
     ~QModbusTcpClient();
 
+    int maxInFlightRequests() const;
+    void setMaxInFlightRequests(int count);
+
+    int maxInFlightRequestsPerServer() const;
+    void setMaxInFlightRequestsPerServer(int count);
+
 protected:
     QModbusTcpClient(QModbusTcpClientPrivate &dd, QObject *parent = nullptr);
 
@@ -38,11 +38,15 @@
 #define QMODBUSTCPCLIENT_P_H
 
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qmap.h>
 #include <QtNetwork/qhostaddress.h>
 #include <QtNetwork/qtcpsocket.h>
 #include "QtSerialBus/qmodbustcpclient.h"
 
 #include "private/qmodbusclient_p.h"
+#include "private/qmodbustimeoutqueue_p.h"
+
+#include <utility>
 
 //
 //  W A R N I N G
@@ -70,6 +74,8 @@ public:
         Q_Q(QModbusTcpClient);
 
         m_socket = new QTcpSocket(q);
+        // a child, so that it follows the client to another thread
+        m_responseTimeouts = new QModbusTimeoutQueue(q);
 
         QObject::connect(m_socket, &QAbstractSocket::connected, q, [this]() {
             qCDebug(QT_MODBUS) << "(TCP client) Connected to" << m_socket->peerAddress()
@@ -99,6 +105,22 @@ public:
                         QModbusDevice::ConnectionError);
         });
 
+        QObject::connect(m_responseTimeouts, &QModbusTimeoutQueue::timeout, q,
+                         [this](quint16 tId) { handleResponseTimeout(tId); });
+
+        QObject::connect(q, &QModbusClient::timeoutChanged, q, [this](int timeout) {
+            // Like the client-wide default, apply the new timeout to outstanding requests.
+            for (auto it = m_transactionStore.begin(); it != m_transactionStore.end(); ++it) {
+                it->responseTimeout = timeout;
+                if (m_responseTimeouts->isActive(it.key()))
+                    m_responseTimeouts->start(it.key(), timeout);
+            }
+            for (auto &queue : m_queuedRequests) {
+                for (QueueElement &element : queue)
+                    element.responseTimeout = timeout;
+            }
+        });
+
         QObject::connect(m_socket, &QIODevice::readyRead, q, [this](){
             responseBuffer += m_socket->read(m_socket->bytesAvailable());
             qCDebug(QT_MODBUS_LOW) << "(TCP client) Response buffer:" << responseBuffer.toHex();
@@ -107,7 +129,7 @@ public:
                 // can we read enough for Modbus ADU header?
                 if (responseBuffer.size() < mbpaHeaderSize) {
                     qCDebug(QT_MODBUS_LOW) << "(TCP client) MBPA header too short. Waiting for more data.";
-                    return;
+                    break;
                 }
 
                 quint8 serverAddress;
@@ -116,9 +138,9 @@ public:
                 input >> transactionId >> protocolId >> bytesPdu >> serverAddress;
 
                 // stop the timer as soon as we know enough about the transaction
-                const bool knownTransaction = m_transactionStore.contains(transactionId);
-                if (knownTransaction && m_transactionStore[transactionId].timer)
-                    m_transactionStore[transactionId].timer->stop();
+                const bool knownTransaction = m_inFlightTransactions.contains(transactionId);
+                if (knownTransaction)
+                    m_responseTimeouts->stop(transactionId);
 
                 qCDebug(QT_MODBUS) << "(TCP client) tid:" << Qt::hex << transactionId << "size:"
                     << bytesPdu << "server address:" << serverAddress;
@@ -130,7 +152,7 @@ public:
                 int tcpAduSize = mbpaHeaderSize + bytesPdu;
                 if (responseBuffer.size() < tcpAduSize) {
                     qCDebug(QT_MODBUS) << "(TCP client) PDU too short. Waiting for more data";
-                    return;
+                    break;
                 }
 
                 QModbusResponse responsePdu;
@@ -144,9 +166,15 @@ public:
                     qCDebug(QT_MODBUS) << "(TCP client) No pending request for response with "
                         "given transaction ID, ignoring response message.";
                 } else {
-                    processQueueElement(responsePdu, m_transactionStore[transactionId]);
+                    // Release the window slot before the reply is finished, so that any
+                    // request sent from a slot connected to QModbusReply::finished()
+                    // already sees the freed slot.
+                    const QueueElement element = m_transactionStore.take(transactionId);
+                    releaseTransaction(transactionId);
+                    processQueueElement(responsePdu, element);
                 }
             }
+            sendQueuedRequests();
         });
     }
 
@@ -154,77 +182,235 @@ public:
                                  const QModbusDataUnit &unit,
                                  QModbusReply::ReplyType type) override
     {
-        auto writeToSocket = [this](quint16 tId, const QModbusRequest &request, int address) {
-            QByteArray buffer;
-            QDataStream output(&buffer, QIODevice::WriteOnly);
-            output << tId << quint16(0) << quint16(request.size() + 1) << quint8(address) << request;
-
-            int writtenBytes = m_socket->write(buffer);
-            if (writtenBytes == -1 || writtenBytes < buffer.size()) {
-                Q_Q(QModbusTcpClient);
-                qCDebug(QT_MODBUS) << "(TCP client) Cannot write request to socket.";
-                q->setError(QModbusTcpClient::tr("Could not write request to socket."),
-                            QModbusDevice::WriteError);
-                return false;
-            }
-            qCDebug(QT_MODBUS_LOW) << "(TCP client) Sent TCP ADU:" << buffer.toHex();
-            qCDebug(QT_MODBUS) << "(TCP client) Sent TCP PDU:" << request << "with tId:" <<Qt:: hex
-                << tId;
-            return true;
-        };
-
-        const int tId = transactionId();
-        if (!writeToSocket(tId, request, serverAddress))
-            return nullptr;
-
         Q_Q(QModbusTcpClient);
+
         auto reply = new QModbusReply(type, serverAddress, q);
         const auto element = QueueElement{ reply, request, unit, m_numberOfRetries,
             m_responseTimeoutDuration };
-        m_transactionStore.insert(tId, element);
 
-        q->connect(reply, &QObject::destroyed, q, [this, tId](QObject *) {
-            if (!m_transactionStore.contains(tId))
+        // The transaction id is only assigned when the request is sent, so the
+        // request is known by the order it was issued in until then.
+        const quint64 sequence = m_nextSequence++;
+        q->connect(reply, &QObject::destroyed, q, [this, serverAddress, sequence](QObject *) {
+            if (removeQueuedRequest(serverAddress, sequence))
+                return;
+
+            // Finished transactions are gone already, only a pending one is found here.
+            const auto it = m_inFlightSequences.constFind(sequence);
+            if (it == m_inFlightSequences.cend())
                 return;
-            const QueueElement element = m_transactionStore.take(tId);
-            if (element.timer)
-                element.timer->stop();
+            const quint16 tId = it.value();
+            m_transactionStore.remove(tId);
+            m_responseTimeouts->stop(tId);
+            releaseTransaction(tId);
+            sendQueuedRequests();
         });
 
-        if (element.timer) {
-            q->connect(q, &QModbusClient::timeoutChanged,
-                       element.timer.data(), QOverload<int>::of(&QTimer::setInterval));
-            QObject::connect(element.timer.data(), &QTimer::timeout, q, [this, writeToSocket, tId]() {
-                if (!m_transactionStore.contains(tId))
-                    return;
-
-                QueueElement elem = m_transactionStore.take(tId);
-                if (elem.reply.isNull())
-                    return;
-
-                if (elem.numberOfRetries > 0) {
-                    elem.numberOfRetries--;
-                    if (!writeToSocket(tId, elem.requestPdu, elem.reply->serverAddress()))
-                        return;
-                    m_transactionStore.insert(tId, elem);
-                    elem.timer->start();
-                    qCDebug(QT_MODBUS) << "(TCP client) Resend request with tId:" << Qt::hex << tId;
-                } else {
-                    qCDebug(QT_MODBUS) << "(TCP client) Timeout of request with tId:" <<Qt::hex << tId;
-                    elem.reply->setError(QModbusDevice::TimeoutError,
-                        QModbusClient::tr("Request timeout."));
-                }
-            });
-            element.timer->start();
-        } else {
-            qCWarning(QT_MODBUS) << "(TCP client) No response timeout timer for request with tId:"
-                << Qt::hex << tId << ". Expected timeout:" << m_responseTimeoutDuration;
+        if (element.responseTimeout < 0) {
+            qCWarning(QT_MODBUS) << "(TCP client) No response timeout for request to server"
+                << serverAddress << ". Expected timeout:" << m_responseTimeoutDuration;
         }
-        incrementTransactionId();
+
+        // Requests beyond the in-flight window wait here, in the order they were issued.
+        m_queuedRequests[serverAddress].insert(sequence, element);
+        updateReadyServer(serverAddress);
+        sendQueuedRequests();
 
         return reply;
     }
 
+    /*
+        Sends as many queued requests as the in-flight windows allow, oldest
+        first. Only server addresses with a free slot are considered, so that a
+        busy unit behind a gateway does not stall requests addressed to other
+        units.
+    */
+    void sendQueuedRequests()
+    {
+        while (!m_readyServers.isEmpty()) {
+            if (m_maxInFlight > 0 && m_inFlightTransactions.size() >= m_maxInFlight)
+                break;
+
+            quint16 tId;
+            if (!nextFreeTransactionId(&tId))
+                break; // every transaction id is in flight
+
+            const int serverAddress = m_readyServers.first();
+            m_readyServers.erase(m_readyServers.begin());
+
+            const auto queue = m_queuedRequests.find(serverAddress);
+            const quint64 sequence = queue->firstKey();
+            const QueueElement element = queue->take(sequence);
+            if (queue->isEmpty())
+                m_queuedRequests.erase(queue);
+
+            m_transactionStore.insert(tId, element);
+            m_inFlightTransactions.insert(tId, { serverAddress, sequence });
+            m_inFlightSequences.insert(sequence, tId);
+            ++m_inFlightPerServer[serverAddress];
+            updateReadyServer(serverAddress);
+
+            writeToSocket(tId, element.requestPdu, serverAddress);
+            if (element.responseTimeout >= 0)
+                m_responseTimeouts->start(tId, element.responseTimeout);
+        }
+    }
+
+    /*
+        Stores the next transaction id that is not used by a request in flight
+        in \a tId. Returns false if all ids are in use.
+    */
+    bool nextFreeTransactionId(quint16 *tId)
+    {
+        for (int i = 0; i <= 0xffff; ++i) {
+            const quint16 id = quint16(transactionId());
+            incrementTransactionId();
+            if (!m_transactionStore.contains(id)) {
+                *tId = id;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool hasFreeSlot(int serverAddress) const
+    {
+        return m_maxInFlightPerServer <= 0
+                || m_inFlightPerServer.value(serverAddress) < m_maxInFlightPerServer;
+    }
+
+    /*
+        Marks \a serverAddress as ready to send if it has queued requests and a
+        free slot. Calling this function for a ready server address is harmless.
+    */
+    void updateReadyServer(int serverAddress)
+    {
+        const auto queue = m_queuedRequests.constFind(serverAddress);
+        if (queue != m_queuedRequests.cend() && hasFreeSlot(serverAddress))
+            m_readyServers.insert(queue->firstKey(), serverAddress);
+    }
+
+    // Needed after the per server limit changed.
+    void updateReadyServers()
+    {
+        m_readyServers.clear();
+        for (auto it = m_queuedRequests.cbegin(); it != m_queuedRequests.cend(); ++it)
+            updateReadyServer(it.key());
+    }
+
+    void handleResponseTimeout(quint16 tId)
+    {
+        if (!m_transactionStore.contains(tId))
+            return;
+
+        QueueElement elem = m_transactionStore.take(tId);
+        if (elem.reply.isNull()) {
+            releaseTransaction(tId);
+            sendQueuedRequests();
+            return;
+        }
+
+        if (elem.numberOfRetries > 0) {
+            elem.numberOfRetries--;
+            writeToSocket(tId, elem.requestPdu, elem.reply->serverAddress());
+            m_transactionStore.insert(tId, elem);
+            m_responseTimeouts->start(tId, elem.responseTimeout);
+            qCDebug(QT_MODBUS) << "(TCP client) Resend request with tId:" << Qt::hex << tId;
+        } else {
+            qCDebug(QT_MODBUS) << "(TCP client) Timeout of request with tId:" <<Qt::hex << tId;
+            releaseTransaction(tId);
+            elem.reply->setError(QModbusDevice::TimeoutError,
+                QModbusClient::tr("Request timeout."));
+            sendQueuedRequests();
+        }
+    }
+
+    // Frees the slot of the sent transaction \a tId in the in-flight windows.
+    void releaseTransaction(quint16 tId)
+    {
+        const auto it = m_inFlightTransactions.constFind(tId);
+        if (it == m_inFlightTransactions.cend())
+            return;
+
+        const int serverAddress = it->serverAddress;
+        m_inFlightSequences.remove(it->sequence);
+        m_inFlightTransactions.erase(it);
+        if (--m_inFlightPerServer[serverAddress] <= 0)
+            m_inFlightPerServer.remove(serverAddress);
+        updateReadyServer(serverAddress);
+    }
+
+    // Removes a request that was not sent yet. Returns false if it is not queued.
+    bool removeQueuedRequest(int serverAddress, quint64 sequence)
+    {
+        const auto queue = m_queuedRequests.find(serverAddress);
+        if (queue == m_queuedRequests.end() || !queue->contains(sequence))
+            return false;
+
+        // the server address is ready under the sequence of its oldest request
+        if (queue->firstKey() == sequence)
+            m_readyServers.remove(sequence);
+
+        queue->remove(sequence);
+        if (queue->isEmpty())
+            m_queuedRequests.erase(queue);
+        else
+            updateReadyServer(serverAddress);
+        return true;
+    }
+
+    /*
+        Appends the ADU to the write buffer. All ADUs appended during one event
+        loop iteration are handed to the socket with a single write() call.
+    */
+    void writeToSocket(quint16 tId, const QModbusRequest &request, int address)
+    {
+        QDataStream output(&m_writeBuffer, QIODevice::WriteOnly | QIODevice::Append);
+        output << tId << quint16(0) << quint16(request.size() + 1) << quint8(address) << request;
+
+        m_bufferedTransactions.append(tId);
+        qCDebug(QT_MODBUS) << "(TCP client) Queued TCP PDU:" << request << "with tId:" << Qt::hex
+            << tId;
+
+        if (m_writeFlushPending)
+            return;
+
+        Q_Q(QModbusTcpClient);
+        m_writeFlushPending = true;
+        QMetaObject::invokeMethod(q, [this]() { flushWriteBuffer(); }, Qt::QueuedConnection);
+    }
+
+    void flushWriteBuffer()
+    {
+        m_writeFlushPending = false;
+        if (m_writeBuffer.isEmpty())
+            return;
+
+        const QByteArray buffer = std::exchange(m_writeBuffer, {});
+        const QList<quint16> transactions = std::exchange(m_bufferedTransactions, {});
+        const qint64 writtenBytes = m_socket->write(buffer);
+        if (writtenBytes == -1 || writtenBytes < buffer.size()) {
+            Q_Q(QModbusTcpClient);
+            qCDebug(QT_MODBUS) << "(TCP client) Cannot write request to socket.";
+            const QString error = QModbusTcpClient::tr("Could not write request to socket.");
+            q->setError(error, QModbusDevice::WriteError);
+
+            // The requests are not sent, so there is no point in waiting for a response.
+            for (const quint16 tId : transactions) {
+                if (!m_transactionStore.contains(tId))
+                    continue;
+                const QueueElement element = m_transactionStore.take(tId);
+                m_responseTimeouts->stop(tId);
+                releaseTransaction(tId);
+                if (!element.reply.isNull())
+                    element.reply->setError(QModbusDevice::WriteError, error);
+            }
+            sendQueuedRequests();
+            return;
+        }
+        qCDebug(QT_MODBUS_LOW) << "(TCP client) Sent TCP ADUs:" << buffer.toHex();
+    }
+
     // TODO: Review once we have a transport layer in place.
     bool isOpen() const override
     {
@@ -235,18 +421,33 @@ public:
 
     void cleanupTransactionStore()
     {
-        if (m_transactionStore.isEmpty())
+        if (m_transactionStore.isEmpty() && m_queuedRequests.isEmpty())
             return;
 
         qCDebug(QT_MODBUS) << "(TCP client) Cleanup of pending requests";
 
-        for (const auto &elem : qAsConst(m_transactionStore)) {
+        const QHash<quint16, QueueElement> store = std::exchange(m_transactionStore, {});
+        const auto queues = std::exchange(m_queuedRequests, {});
+        m_readyServers.clear();
+        m_inFlightTransactions.clear();
+        m_inFlightSequences.clear();
+        m_inFlightPerServer.clear();
+        m_writeBuffer.clear();
+        m_bufferedTransactions.clear();
+        m_responseTimeouts->clear();
+
+        const auto abort = [](const QueueElement &elem) {
             if (elem.reply.isNull())
-                continue;
+                return;
             elem.reply->setError(QModbusDevice::ReplyAbortedError,
                                  QModbusClient::tr("Reply aborted due to connection closure."));
+        };
+        for (const auto &elem : store)
+            abort(elem);
+        for (const auto &queue : queues) {
+            for (const auto &elem : queue)
+                abort(elem);
         }
-        m_transactionStore.clear();
     }
 
     // This doesn't overflow, it rather "wraps around". Expected.
@@ -257,10 +458,34 @@ public:
 
     QTcpSocket *m_socket = nullptr;
     QByteArray responseBuffer;
-    QHash<quint16, QueueElement> m_transactionStore;
+    QHash<quint16, QueueElement> m_transactionStore; // requests in flight
     int mbpaHeaderSize = 7;
 
-private:   // Private to avoid using the wrong id inside the timer lambda,
+    // Requests that were not sent yet, per server address and keyed by their
+    // sequence, the order they were issued in across all server addresses.
+    QHash<int, QMap<quint64, QueueElement>> m_queuedRequests;
+    // server addresses with queued requests and a free slot, keyed by the
+    // sequence of their oldest queued request
+    QMap<quint64, int> m_readyServers;
+    quint64 m_nextSequence = 0;
+
+    struct InFlightTransaction {
+        int serverAddress;
+        quint64 sequence;
+    };
+    QHash<quint16, InFlightTransaction> m_inFlightTransactions; // by transaction id
+    QHash<quint64, quint16> m_inFlightSequences; // sequence -> transaction id
+    QHash<int, int> m_inFlightPerServer;
+    int m_maxInFlight = 0;
+    int m_maxInFlightPerServer = 0;
+
+    QByteArray m_writeBuffer;
+    QList<quint16> m_bufferedTransactions; // the transactions in m_writeBuffer
+    bool m_writeFlushPending = false;
+
+    QModbusTimeoutQueue *m_responseTimeouts = nullptr;
+
+private:   // Private to avoid using the wrong id inside the reply lambda,
     quint16 m_transactionId = 0; // capturing 'this' will not copy the id.
 };
 
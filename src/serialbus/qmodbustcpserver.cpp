@@ -190,6 +190,115 @@ void QModbusTcpServer::installConnectionObserver(QModbusTcpConnectionObserver *o
     d->m_observer.reset(observer);
 }
 
+/*!
+    \since 6.3
+
+    Adds a unit that answers requests with the unit identifier \a unitId, in
+    addition to this server at its serverAddress(). Returns \c true on success;
+    otherwise \c false if \a unitId is outside of the range \c 0 to \c 255, is
+    the serverAddress() or has been added already.
+
+    Each unit has its own register map, options, diagnostic counters and event
+    log, which start out empty or at their defaults. They are set up by making
+    the unit the current one with setCurrentServerUnit() and calling setMap(),
+    setData() or setValue(). This way a single server and listening socket can
+    simulate many Modbus devices; requests are dispatched to their unit by a
+    table lookup.
+
+    \note If the serverAddress() is later changed to \a unitId, the requests to
+    \a unitId are answered by this server's own unit.
+
+    \sa removeServerUnit(), serverUnits(), setCurrentServerUnit()
+*/
+bool QModbusTcpServer::addServerUnit(int unitId)
+{
+    Q_D(QModbusTcpServer);
+    if (unitId < 0 || unitId >= int(d->m_units.size()) || unitId == serverAddress()
+            || d->m_units[unitId]) {
+        return false;
+    }
+    d->m_units[unitId] = std::make_unique<QModbusServerPrivate::Unit>();
+    return true;
+}
+
+/*!
+    \since 6.3
+
+    Removes the unit with the identifier \a unitId that was added with
+    addServerUnit(), together with its register map, options, counters and
+    event log. If it was the current unit, this server's own unit becomes the
+    current one. Returns \c true on success; otherwise \c false.
+
+    \sa addServerUnit(), currentServerUnit()
+*/
+bool QModbusTcpServer::removeServerUnit(int unitId)
+{
+    Q_D(QModbusTcpServer);
+    if (unitId < 0 || unitId >= int(d->m_units.size()) || !d->m_units[unitId])
+        return false;
+
+    if (d->m_unitId == unitId)
+        d->selectUnit(-1);
+    d->m_units[unitId].reset();
+    return true;
+}
+
+/*!
+    \since 6.3
+
+    Returns the identifiers of the units added with addServerUnit(), in
+    ascending order.
+*/
+QList<int> QModbusTcpServer::serverUnits() const
+{
+    Q_D(const QModbusTcpServer);
+    QList<int> units;
+    for (int unitId = 0; unitId < int(d->m_units.size()); ++unitId) {
+        if (d->m_units[unitId])
+            units.append(unitId);
+    }
+    return units;
+}
+
+/*!
+    \since 6.3
+
+    Makes the unit with the identifier \a unitId the current unit, which is
+    either serverAddress() or a unit added with addServerUnit(). Returns
+    \c true on success; otherwise \c false and the current unit is kept.
+
+    The data(), setData(), setMap(), setMapRanges(), value() and setValue()
+    functions operate on the current unit.
+
+    While a request is processed, the unit it is addressed to is the current
+    unit. Reimplementations of processRequest(), readData() and writeData(),
+    as well as slots connected to dataWritten(), can call currentServerUnit()
+    to tell the units apart.
+
+    \sa currentServerUnit(), addServerUnit()
+*/
+bool QModbusTcpServer::setCurrentServerUnit(int unitId)
+{
+    Q_D(QModbusTcpServer);
+    if (!d->unit(unitId))
+        return false;
+    return d->selectUnit(unitId);
+}
+
+/*!
+    \since 6.3
+
+    Returns the identifier of the current unit. This is serverAddress() unless
+    another unit was made the current one with setCurrentServerUnit().
+
+    \sa setCurrentServerUnit()
+*/
+int QModbusTcpServer::currentServerUnit() const
+{
+    Q_D(const QModbusTcpServer);
+    return d->currentUnitId();
+}
+
 /*!
     \class QModbusTcpConnectionObserver
     \inmodule QtSerialBus
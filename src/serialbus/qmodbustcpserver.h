@@ -64,6 +64,13 @@ public:
 
     void installConnectionObserver(QModbusTcpConnectionObserver *observer);
 
+    bool addServerUnit(int unitId);
+    bool removeServerUnit(int unitId);
+    QList<int> serverUnits() const;
+
+    bool setCurrentServerUnit(int unitId);
+    int currentServerUnit() const;
+
 Q_SIGNALS:
     void modbusClientDisconnected(QTcpSocket *modbusClient);
 
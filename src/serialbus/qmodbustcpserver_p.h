@@ -37,8 +37,8 @@
 #ifndef QMODBUSTCPSERVER_P_H
 #define QMODBUSTCPSERVER_P_H
 
-#include <QtCore/qdatastream.h>
 #include <QtCore/qdebug.h>
+#include <QtCore/qendian.h>
 #include <QtCore/qloggingcategory.h>
 #include <QtCore/qobject.h>
 #include <QtNetwork/qhostaddress.h>
@@ -48,6 +48,7 @@
 
 #include <private/qmodbusserver_p.h>
 
+#include <cstring>
 #include <memory>
 
 //
@@ -103,16 +104,158 @@ public:
     */
     bool matchingServerAddress(quint8 unitId) const
     {
-        Q_Q(const QModbusTcpServer);
-        if (q->serverAddress() == unitId)
+        // Either our address or one of the units added with addServerUnit().
+        if (unit(unitId))
             return true;
 
         // No, not our address! Ignore!
+        Q_Q(const QModbusTcpServer);
         qCDebug(QT_MODBUS) << "(TCP server) Wrong server unit identifier address, expected"
-            << q->serverAddress() << "got" << unitId;
+            << q->serverAddress() << "or an added unit, got" << unitId;
         return false;
     }
 
+    struct ConnectionBuffer
+    {
+        // Received bytes; everything before inputOffset has been processed already.
+        QByteArray input;
+        qsizetype inputOffset = 0;
+        // Responses that are written to the socket once all complete requests are processed.
+        QByteArray output;
+    };
+
+    /*
+        Appends everything the socket has to offer to the input buffer and
+        processes all complete ADUs in place. The buffer and its capacity are
+        kept across calls; only an incomplete trailing ADU is moved to the
+        front of the buffer.
+    */
+    void readRequests(QTcpSocket *socket, ConnectionBuffer *buffer)
+    {
+        QByteArray &input = buffer->input;
+        if (buffer->inputOffset > 0) {
+            const qsizetype remaining = input.size() - buffer->inputOffset;
+            if (remaining > 0)
+                std::memmove(input.data(), input.constData() + buffer->inputOffset, remaining);
+            input.resize(remaining);
+            buffer->inputOffset = 0;
+        }
+
+        const qint64 available = socket->bytesAvailable();
+        if (available > 0) {
+            const qsizetype size = input.size();
+            input.resize(size + available);
+            const qint64 read = socket->read(input.data() + size, available);
+            input.resize(size + qMax<qint64>(0, read));
+        }
+
+        while (input.size() - buffer->inputOffset > 0) {
+            const qsizetype left = input.size() - buffer->inputOffset;
+            const char *adu = input.constData() + buffer->inputOffset;
+            qCDebug(QT_MODBUS_LOW).noquote() << "(TCP server) Read buffer: 0x"
+                + QByteArray::fromRawData(adu, left).toHex();
+
+            if (left < mbpaHeaderSize) {
+                qCDebug(QT_MODBUS) << "(TCP server) MBPA header too short. Waiting for more data.";
+                return;
+            }
+
+            const quint16 transactionId = qFromBigEndian<quint16>(adu);
+            const quint16 protocolId = qFromBigEndian<quint16>(adu + 2);
+            const quint16 bytesPdu = qFromBigEndian<quint16>(adu + 4);
+            const quint8 unitId = quint8(adu[6]);
+
+            qCDebug(QT_MODBUS_LOW) << "(TCP server) Request MBPA:" << "Transaction Id:"
+                << Qt::hex << transactionId << "Protocol Id:" << protocolId << "PDU bytes:"
+                << bytesPdu << "Unit Id:" << unitId;
+
+            if (bytesPdu == 0) {
+                // The length field must at least cover the Unit Identifier, skip the header.
+                qCDebug(QT_MODBUS) << "(TCP server) Invalid MBPA length field, dropping header.";
+                buffer->inputOffset += mbpaHeaderSize;
+                continue;
+            }
+
+            // The length field is the byte count of the following fields, including the Unit
+            // Identifier and the PDU, so we remove on byte.
+            const qsizetype pduSize = bytesPdu - 1;
+            const qsizetype current = mbpaHeaderSize + pduSize;
+            if (left < current) {
+                qCDebug(QT_MODBUS) << "(TCP server) PDU too short. Waiting for more data";
+                return;
+            }
+
+            QModbusRequest request;
+            if (pduSize > 0) {
+                request.setFunctionCode(QModbusPdu::FunctionCode(quint8(adu[mbpaHeaderSize])));
+                request.setData(QByteArray(adu + mbpaHeaderSize + 1, pduSize - 1));
+            }
+            buffer->inputOffset += current;
+
+            if (!matchingServerAddress(unitId))
+                continue;
+
+            // The addressed unit is the current one while the request is processed.
+            const int currentUnitId = m_unitId;
+            selectUnit(unitId);
+
+            qCDebug(QT_MODBUS) << "(TCP server) Request PDU:" << request;
+            const QModbusResponse response = forwardProcessRequest(request);
+            qCDebug(QT_MODBUS) << "(TCP server) Response PDU:" << response;
+
+            selectUnit(currentUnitId);
+
+            appendResponse(&buffer->output, transactionId, protocolId, unitId, response);
+        }
+    }
+
+    static void appendResponse(QByteArray *output, quint16 transactionId, quint16 protocolId,
+                               quint8 unitId, const QModbusResponse &response)
+    {
+        const QByteArray &data = response.data();
+        const qsizetype offset = output->size();
+        output->resize(offset + mbpaHeaderSize + 1 + data.size());
+
+        char *adu = output->data() + offset;
+        qToBigEndian<quint16>(transactionId, adu);
+        qToBigEndian<quint16>(protocolId, adu + 2);
+        // The length field is the byte count of the following fields, including the Unit
+        // Identifier and PDU fields, so we add one byte to the response size.
+        qToBigEndian<quint16>(quint16(response.size() + 1), adu + 4);
+        adu[6] = char(unitId);
+        quint8 functionCode = quint8(response.functionCode());
+        if (response.isException())
+            functionCode |= QModbusPdu::ExceptionByte;
+        adu[7] = char(functionCode);
+        if (!data.isEmpty())
+            std::memcpy(adu + mbpaHeaderSize + 1, data.constData(), data.size());
+    }
+
+    void writeResponses(QTcpSocket *socket, ConnectionBuffer *buffer)
+    {
+        QByteArray &output = buffer->output;
+        if (output.isEmpty())
+            return;
+
+        if (!socket->isOpen()) {
+            qCDebug(QT_MODBUS) << "(TCP server) Requesting socket has closed.";
+            forwardError(QModbusTcpServer::tr("Requesting socket is closed"),
+                         QModbusDevice::WriteError);
+            output.resize(0);
+            return;
+        }
+
+        // Write from the raw pointer so that the socket copies the data and the
+        // output buffer keeps its capacity for the next batch of responses.
+        const qint64 writtenBytes = socket->write(output.constData(), output.size());
+        if (writtenBytes == -1 || writtenBytes < output.size()) {
+            qCDebug(QT_MODBUS) << "(TCP server) Cannot write requested response to socket.";
+            forwardError(QModbusTcpServer::tr("Could not write response to client"),
+                         QModbusDevice::WriteError);
+        }
+        output.resize(0);
+    }
+
     void setupTcpServer()
     {
         m_tcpServer = new QTcpServer(q_func());
@@ -134,7 +277,7 @@ public:
 
             connections.append(socket);
 
-            auto buffer = new QByteArray();
+            auto buffer = new ConnectionBuffer();
 
             QObject::connect(socket, &QObject::destroyed, q, [buffer]() {
                 // cleanup buffer
@@ -151,68 +294,8 @@ public:
                 if (!socket)
                     return;
 
-                buffer->append(socket->readAll());
-                while (!buffer->isEmpty()) {
-                    qCDebug(QT_MODBUS_LOW).noquote() << "(TCP server) Read buffer: 0x"
-                        + buffer->toHex();
-
-                    if (buffer->size() < mbpaHeaderSize) {
-                        qCDebug(QT_MODBUS) << "(TCP server) MBPA header too short. Waiting for more data.";
-                        return;
-                    }
-
-                    quint8 unitId;
-                    quint16 transactionId, bytesPdu, protocolId;
-                    QDataStream input(*buffer);
-                    input >> transactionId >> protocolId >> bytesPdu >> unitId;
-
-                    qCDebug(QT_MODBUS_LOW) << "(TCP server) Request MBPA:" << "Transaction Id:"
-                        << Qt::hex << transactionId << "Protocol Id:" << protocolId << "PDU bytes:"
-                        << bytesPdu << "Unit Id:" << unitId;
-
-                    // The length field is the byte count of the following fields, including the Unit
-                    // Identifier and the PDU, so we remove on byte.
-                    bytesPdu--;
-
-                    const quint16 current = mbpaHeaderSize + bytesPdu;
-                    if (buffer->size() < current) {
-                        qCDebug(QT_MODBUS) << "(TCP server) PDU too short. Waiting for more data";
-                        return;
-                    }
-
-                    QModbusRequest request;
-                    input >> request;
-
-                    buffer->remove(0, current);
-
-                    if (!matchingServerAddress(unitId))
-                        continue;
-
-                    qCDebug(QT_MODBUS) << "(TCP server) Request PDU:" << request;
-                    const QModbusResponse response = forwardProcessRequest(request);
-                    qCDebug(QT_MODBUS) << "(TCP server) Response PDU:" << response;
-
-                    QByteArray result;
-                    QDataStream output(&result, QIODevice::WriteOnly);
-                    // The length field is the byte count of the following fields, including the Unit
-                    // Identifier and PDU fields, so we add one byte to the response size.
-                    output << transactionId << protocolId << quint16(response.size() + 1)
-                           << unitId << response;
-
-                    if (!socket->isOpen()) {
-                        qCDebug(QT_MODBUS) << "(TCP server) Requesting socket has closed.";
-                        forwardError(QModbusTcpServer::tr("Requesting socket is closed"),
-                                     QModbusDevice::WriteError);
-                        return;
-                    }
-
-                    qint64 writtenBytes = socket->write(result);
-                    if (writtenBytes == -1 || writtenBytes < result.size()) {
-                        qCDebug(QT_MODBUS) << "(TCP server) Cannot write requested response to socket.";
-                        forwardError(QModbusTcpServer::tr("Could not write response to client"),
-                                     QModbusDevice::WriteError);
-                    }
-                }
+                readRequests(socket, buffer);
+                writeResponses(socket, buffer);
             });
         });
 
@@ -0,0 +1,188 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMODBUSTIMEOUTQUEUE_P_H
+#define QMODBUSTIMEOUTQUEUE_P_H
+
+#include <QtCore/qbasictimer.h>
+#include <QtCore/qcoreevent.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qobject.h>
+
+#include <algorithm>
+#include <vector>
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+QT_BEGIN_NAMESPACE
+
+// Response timeouts of all outstanding transactions of one client, driven by
+// a single timer.
+//
+// Deadlines are kept in a binary min-heap. Stopping or restarting a timeout
+// does not touch the heap; the transaction's generation number changes
+// instead and the stale heap entry is dropped once it reaches the top. The
+// timer is only restarted when the earliest deadline changes.
+class QModbusTimeoutQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit QModbusTimeoutQueue(QObject *parent = nullptr)
+        : QObject(parent)
+    {
+        m_clock.start();
+    }
+
+    void start(quint16 transactionId, int msec)
+    {
+        const quint32 generation = ++m_generation;
+        m_active.insert(transactionId, generation);
+
+        if (m_heap.size() > 2 * size_t(m_active.size()) + 64)
+            compact();
+
+        m_heap.push_back({ m_clock.elapsed() + qMax(0, msec), transactionId, generation });
+        std::push_heap(m_heap.begin(), m_heap.end(), later);
+        rearm();
+    }
+
+    void stop(quint16 transactionId)
+    {
+        // The heap entry is discarded lazily, the timer keeps running until then.
+        m_active.remove(transactionId);
+    }
+
+    bool isActive(quint16 transactionId) const { return m_active.contains(transactionId); }
+
+    void clear()
+    {
+        m_active.clear();
+        m_heap.clear();
+        m_timer.stop();
+    }
+
+signals:
+    void timeout(quint16 transactionId);
+
+private:
+    struct Entry {
+        qint64 deadline;
+        quint16 transactionId;
+        quint32 generation;
+    };
+
+    static bool later(const Entry &lhs, const Entry &rhs) { return lhs.deadline > rhs.deadline; }
+
+    bool isStale(const Entry &entry) const
+    {
+        const auto it = m_active.constFind(entry.transactionId);
+        return it == m_active.cend() || it.value() != entry.generation;
+    }
+
+    void compact()
+    {
+        m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(),
+                                    [this](const Entry &entry) { return isStale(entry); }),
+                     m_heap.end());
+        std::make_heap(m_heap.begin(), m_heap.end(), later);
+    }
+
+    void rearm()
+    {
+        while (!m_heap.empty() && isStale(m_heap.front())) {
+            std::pop_heap(m_heap.begin(), m_heap.end(), later);
+            m_heap.pop_back();
+        }
+
+        if (m_heap.empty()) {
+            m_timer.stop();
+            return;
+        }
+
+        const qint64 deadline = m_heap.front().deadline;
+        if (m_timer.isActive() && deadline == m_armedDeadline)
+            return;
+
+        m_armedDeadline = deadline;
+        m_timer.start(int(qMax<qint64>(0, deadline - m_clock.elapsed())), this);
+    }
+
+    void timerEvent(QTimerEvent *event) override
+    {
+        if (event->timerId() != m_timer.timerId())
+            return;
+        m_timer.stop();
+
+        const qint64 now = m_clock.elapsed();
+        QList<quint16> expired;
+        while (!m_heap.empty() && m_heap.front().deadline <= now) {
+            const Entry entry = m_heap.front();
+            std::pop_heap(m_heap.begin(), m_heap.end(), later);
+            m_heap.pop_back();
+            if (isStale(entry))
+                continue;
+            m_active.remove(entry.transactionId);
+            expired.append(entry.transactionId);
+        }
+        rearm();
+
+        for (quint16 transactionId : qAsConst(expired))
+            emit timeout(transactionId);
+    }
+
+    std::vector<Entry> m_heap;
+    QHash<quint16, quint32> m_active; // transaction id -> generation
+    quint32 m_generation = 0;
+    qint64 m_armedDeadline = 0;
+    QBasicTimer m_timer;
+    QElapsedTimer m_clock;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMODBUSTIMEOUTQUEUE_P_H
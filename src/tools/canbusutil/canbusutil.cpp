@@ -37,6 +37,7 @@
 #include "canbusutil.h"
 
 #include <QCoreApplication>
+#include <QDir>
 #include <QTextStream>
 
 CanBusUtil::CanBusUtil(QTextStream &output, QCoreApplication &app, QObject *parent) :
@@ -58,12 +59,32 @@ void CanBusUtil::setShowFlags(bool showFlags)
     m_readTask->setShowFlags(showFlags);
 }
 
+void CanBusUtil::setOutputFormat(ReadTask::OutputFormat format)
+{
+    m_readTask->setOutputFormat(format);
+}
+
 void CanBusUtil::setConfigurationParameter(QCanBusDevice::ConfigurationKey key,
                                            const QVariant &value)
 {
     m_configurationParameter[key] = value;
 }
 
+void CanBusUtil::setRecordDirectory(const QString &directory)
+{
+    m_recordDirectory = directory;
+}
+
+void CanBusUtil::setReplayDirectory(const QString &directory)
+{
+    m_replayDirectory = directory;
+}
+
+void CanBusUtil::setReplaySpeed(double speed)
+{
+    m_replaySpeed = speed;
+}
+
 bool CanBusUtil::start(const QString &pluginName, const QString &deviceName, const QString &data)
 {
     if (!m_canBus) {
@@ -76,12 +97,18 @@ bool CanBusUtil::start(const QString &pluginName, const QString &deviceName, con
     m_data = data;
     m_listening = data.isEmpty();
 
+    if (!m_recordDirectory.isEmpty())
+        return startRecording();
+    if (!m_replayDirectory.isEmpty())
+        return startReplay();
+
     if (!connectCanDevice())
         return false;
 
     if (m_listening) {
         if (m_readTask->isShowFlags())
              m_canDevice->setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+        m_readTask->setDeviceName(m_deviceName);
         connect(m_canDevice.get(), &QCanBusDevice::framesReceived,
                 m_readTask, &ReadTask::handleFrames);
     } else {
@@ -195,30 +222,36 @@ bool CanBusUtil::setFrameFromPayload(QString payload, QCanBusFrame *frame)
     return true;
 }
 
-bool CanBusUtil::connectCanDevice()
+QCanBusDevice *CanBusUtil::createConnectedDevice(const QString &deviceName)
 {
-    if (!m_canBus->plugins().contains(m_pluginName)) {
-        m_output << tr("Cannot find CAN bus plugin '%1'.").arg(m_pluginName) << Qt::endl;
-        return false;
-    }
-
-    m_canDevice.reset(m_canBus->createDevice(m_pluginName, m_deviceName));
-    if (!m_canDevice) {
-        m_output << tr("Cannot create CAN bus device: '%1'").arg(m_deviceName) << Qt::endl;
-        return false;
+    std::unique_ptr<QCanBusDevice> device(m_canBus->createDevice(m_pluginName, deviceName));
+    if (!device) {
+        m_output << tr("Cannot create CAN bus device: '%1'").arg(deviceName) << Qt::endl;
+        return nullptr;
     }
 
     const auto constEnd = m_configurationParameter.constEnd();
     for (auto i = m_configurationParameter.constBegin(); i != constEnd; ++i)
-        m_canDevice->setConfigurationParameter(i.key(), i.value());
+        device->setConfigurationParameter(i.key(), i.value());
+
+    connect(device.get(), &QCanBusDevice::errorOccurred, m_readTask, &ReadTask::handleError);
+    if (!device->connectDevice()) {
+        m_output << tr("Cannot create CAN bus device: '%1'").arg(deviceName) << Qt::endl;
+        return nullptr;
+    }
+
+    return device.release();
+}
 
-    connect(m_canDevice.get(), &QCanBusDevice::errorOccurred, m_readTask, &ReadTask::handleError);
-    if (!m_canDevice->connectDevice()) {
-        m_output << tr("Cannot create CAN bus device: '%1'").arg(m_deviceName) << Qt::endl;
+bool CanBusUtil::connectCanDevice()
+{
+    if (!m_canBus->plugins().contains(m_pluginName)) {
+        m_output << tr("Cannot find CAN bus plugin '%1'.").arg(m_pluginName) << Qt::endl;
         return false;
     }
 
-    return true;
+    m_canDevice.reset(createConnectedDevice(m_deviceName));
+    return m_canDevice != nullptr;
 }
 
 bool CanBusUtil::sendData()
@@ -245,3 +278,63 @@ bool CanBusUtil::sendData()
 
     return m_canDevice->writeFrame(frame);
 }
+
+QString CanBusUtil::logFileName(const QString &directory, const QString &deviceName) const
+{
+    return QDir(directory).filePath(deviceName + QLatin1String(".canlog"));
+}
+
+bool CanBusUtil::startRecording()
+{
+    if (!m_canBus->plugins().contains(m_pluginName)) {
+        m_output << tr("Cannot find CAN bus plugin '%1'.").arg(m_pluginName) << Qt::endl;
+        return false;
+    }
+    if (!QDir().mkpath(m_recordDirectory)) {
+        m_output << tr("Cannot create directory '%1'.").arg(m_recordDirectory) << Qt::endl;
+        return false;
+    }
+
+    m_recordTask = new RecordTask(m_output, this);
+    connect(&m_app, &QCoreApplication::aboutToQuit, m_recordTask, &RecordTask::finish);
+
+    // one log file per channel
+    const QStringList deviceNames = m_deviceName.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &deviceName : deviceNames) {
+        std::unique_ptr<QCanBusDevice> device(createConnectedDevice(deviceName));
+        if (!device)
+            return false;
+        if (!m_recordTask->addChannel(device.get(), logFileName(m_recordDirectory, deviceName)))
+            return false;
+        m_channelDevices.push_back(std::move(device));
+    }
+
+    return true;
+}
+
+bool CanBusUtil::startReplay()
+{
+    if (!m_canBus->plugins().contains(m_pluginName)) {
+        m_output << tr("Cannot find CAN bus plugin '%1'.").arg(m_pluginName) << Qt::endl;
+        return false;
+    }
+
+    m_replayTask = new ReplayTask(m_output, this);
+    m_replayTask->setSpeed(m_replaySpeed);
+    connect(m_replayTask, &ReplayTask::finished, &m_app, QCoreApplication::quit,
+            Qt::QueuedConnection);
+
+    // each channel replays the log file recorded for the device of the same name
+    const QStringList deviceNames = m_deviceName.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &deviceName : deviceNames) {
+        std::unique_ptr<QCanBusDevice> device(createConnectedDevice(deviceName));
+        if (!device)
+            return false;
+        if (!m_replayTask->addChannel(device.get(), logFileName(m_replayDirectory, deviceName)))
+            return false;
+        m_channelDevices.push_back(std::move(device));
+    }
+
+    QTimer::singleShot(0, m_replayTask, &ReplayTask::start);
+    return true;
+}
@@ -38,6 +38,8 @@
 #define CANBUSUTIL_H
 
 #include "readtask.h"
+#include "recordtask.h"
+#include "replaytask.h"
 
 #include <QObject>
 
@@ -57,7 +59,11 @@ public:
 
     void setShowTimeStamp(bool showTimeStamp);
     void setShowFlags(bool showFlags);
+    void setOutputFormat(ReadTask::OutputFormat format);
     void setConfigurationParameter(QCanBusDevice::ConfigurationKey key, const QVariant &value);
+    void setRecordDirectory(const QString &directory);
+    void setReplayDirectory(const QString &directory);
+    void setReplaySpeed(double speed);
     bool start(const QString &pluginName, const QString &deviceName, const QString &data = QString());
     int  printPlugins();
     int  printDevices(const QString &pluginName);
@@ -65,8 +71,12 @@ public:
 private:
     bool parseDataField(QCanBusFrame::FrameId &id, QString &payload);
     bool setFrameFromPayload(QString payload, QCanBusFrame *frame);
+    QCanBusDevice *createConnectedDevice(const QString &deviceName);
     bool connectCanDevice();
     bool sendData();
+    QString logFileName(const QString &directory, const QString &deviceName) const;
+    bool startRecording();
+    bool startReplay();
 
 private:
     QCanBus *m_canBus = nullptr;
@@ -77,7 +87,13 @@ private:
     QString m_deviceName;
     QString m_data;
     std::unique_ptr<QCanBusDevice> m_canDevice;
+    std::vector<std::unique_ptr<QCanBusDevice>> m_channelDevices;
     ReadTask *m_readTask = nullptr;
+    RecordTask *m_recordTask = nullptr;
+    ReplayTask *m_replayTask = nullptr;
+    QString m_recordDirectory;
+    QString m_replayDirectory;
+    double m_replaySpeed = 1.0;
     using ConfigurationParameter = QHash<QCanBusDevice::ConfigurationKey, QVariant>;
     ConfigurationParameter m_configurationParameter;
 };
@@ -0,0 +1,329 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "canlog.h"
+
+#include <QtEndian>
+
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+const char Magic[8] = { 'Q', 'C', 'A', 'N', 'L', 'O', 'G', '\0' };
+
+// The writer maps the file in windows of this size
+constexpr qsizetype WindowSize = 4 * 1024 * 1024;
+
+constexpr QCanBusFrame::FrameType FrameTypes[] = {
+    QCanBusFrame::DataFrame,
+    QCanBusFrame::RemoteRequestFrame,
+    QCanBusFrame::ErrorFrame
+};
+
+uchar *writeVarint(uchar *p, quint64 value)
+{
+    while (value >= 0x80) {
+        *p++ = uchar(value) | 0x80;
+        value >>= 7;
+    }
+    *p++ = uchar(value);
+    return p;
+}
+
+bool readVarint(const uchar *&p, const uchar *end, quint64 *value)
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64 && p != end; shift += 7) {
+        const uchar byte = *p++;
+        result |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+quint64 zigZagEncode(qint64 value)
+{
+    return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+qint64 zigZagDecode(quint64 value)
+{
+    return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+qint64 toMicroSeconds(const QCanBusFrame::TimeStamp &timeStamp)
+{
+    return timeStamp.seconds() * 1000000 + timeStamp.microSeconds();
+}
+
+} // namespace
+
+uchar *CanLog::writeHeader(uchar *p)
+{
+    std::memcpy(p, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(CanLog::Version, p + 8);
+    qToLittleEndian<quint32>(0, p + 12);
+    return p + CanLog::HeaderSize;
+}
+
+uchar *CanLog::writeRecord(uchar *p, const QCanBusFrame &frame, qint64 *lastTimeStamp)
+{
+    quint8 type = 0;
+    switch (frame.frameType()) {
+    case QCanBusFrame::DataFrame:
+        type = 0;
+        break;
+    case QCanBusFrame::RemoteRequestFrame:
+        type = 1;
+        break;
+    case QCanBusFrame::ErrorFrame:
+        type = 2;
+        break;
+    default:
+        return p; // nothing to record
+    }
+
+    quint8 flags = CanLog::RecordMarker | (type << CanLog::FrameTypeShift);
+    if (frame.hasExtendedFrameFormat())
+        flags |= CanLog::ExtendedFrameFormat;
+    if (frame.hasFlexibleDataRateFormat())
+        flags |= CanLog::FlexibleDataRateFormat;
+    if (frame.hasBitrateSwitch())
+        flags |= CanLog::BitrateSwitch;
+    if (frame.hasErrorStateIndicator())
+        flags |= CanLog::ErrorStateIndicator;
+    if (frame.hasLocalEcho())
+        flags |= CanLog::LocalEcho;
+    *p++ = flags;
+
+    // the difference wraps around like the sum in CanLogReader::readNext()
+    const qint64 timeStamp = toMicroSeconds(frame.timeStamp());
+    p = writeVarint(p, zigZagEncode(qint64(quint64(timeStamp) - quint64(*lastTimeStamp))));
+    *lastTimeStamp = timeStamp;
+    // error frames keep their error flags in the frame ID
+    p = writeVarint(p, type == 2 ? quint32(frame.error()) : frame.frameId());
+
+    const QByteArrayView payload = frame.payloadView();
+    const qsizetype payloadSize = qMin<qsizetype>(payload.size(), 64);
+    *p++ = uchar(payloadSize);
+    std::memcpy(p, payload.data(), payloadSize);
+    return p + payloadSize;
+}
+
+CanLogWriter::CanLogWriter(const QString &fileName) :
+    m_file(fileName)
+{
+}
+
+CanLogWriter::~CanLogWriter()
+{
+    close();
+}
+
+bool CanLogWriter::open()
+{
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    if (!reserve(CanLog::HeaderSize))
+        return false;
+
+    CanLog::writeHeader(m_window + m_windowUsed);
+    m_windowUsed += CanLog::HeaderSize;
+    return true;
+}
+
+bool CanLogWriter::write(const QCanBusFrame &frame)
+{
+    if (!reserve(CanLog::MaximumRecordSize))
+        return false;
+
+    uchar *const record = m_window + m_windowUsed;
+    const uchar *const end = CanLog::writeRecord(record, frame, &m_lastTimeStamp);
+    if (end != record) {
+        m_windowUsed += end - record;
+        ++m_framesWritten;
+    }
+    return true;
+}
+
+void CanLogWriter::close()
+{
+    if (!m_file.isOpen())
+        return;
+
+    if (m_window) {
+        m_file.unmap(m_window);
+        m_window = nullptr;
+    }
+    // cut off the unused rest of the last window
+    m_file.resize(m_windowStart + m_windowUsed);
+    m_file.close();
+}
+
+bool CanLogWriter::reserve(qsizetype size)
+{
+    if (m_window && m_windowUsed + size <= m_windowSize)
+        return true;
+
+    // move the window behind the last record, the kernel writes back the old one
+    const qint64 offset = m_windowStart + m_windowUsed;
+    if (m_window) {
+        m_file.unmap(m_window);
+        m_window = nullptr;
+    }
+    m_windowStart = offset;
+    m_windowUsed = 0;
+    m_windowSize = qMax(WindowSize, size);
+
+    if (!m_file.resize(m_windowStart + m_windowSize)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_window = m_file.map(m_windowStart, m_windowSize);
+    if (!m_window) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    return true;
+}
+
+CanLogReader::CanLogReader(const QString &fileName) :
+    m_file(fileName)
+{
+}
+
+CanLogReader::~CanLogReader()
+{
+    close();
+}
+
+bool CanLogReader::open()
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size >= CanLog::HeaderSize)
+        m_data = m_file.map(0, m_size);
+    if (!m_data || std::memcmp(m_data, Magic, sizeof(Magic)) != 0) {
+        m_errorString = tr("Not a CAN bus log file.");
+        close();
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(m_data + 8);
+    if (version != CanLog::Version) {
+        m_errorString = tr("Unsupported log file version %1.").arg(version);
+        close();
+        return false;
+    }
+
+    m_position = CanLog::HeaderSize;
+    m_lastTimeStamp = 0;
+    return true;
+}
+
+bool CanLogReader::readNext(QCanBusFrame *frame)
+{
+    if (!m_data || m_position >= m_size)
+        return false;
+
+    const uchar *p = m_data + m_position;
+    const uchar *const end = m_data + m_size;
+
+    const quint8 flags = *p++;
+    if (!(flags & CanLog::RecordMarker)) {
+        // the rest of a window of an interrupted recording
+        m_position = m_size;
+        return false;
+    }
+
+    quint64 delta = 0;
+    quint64 frameId = 0;
+    const int type = (flags & CanLog::FrameTypeMask) >> CanLog::FrameTypeShift;
+    if (!readVarint(p, end, &delta) || !readVarint(p, end, &frameId) || p == end
+            || frameId > 0x1FFFFFFFU || type >= int(std::size(FrameTypes))) {
+        m_errorString = tr("Corrupt record at offset %1.").arg(m_position);
+        m_position = m_size;
+        return false;
+    }
+    const int payloadSize = *p++;
+    if (payloadSize > 64 || end - p < payloadSize) {
+        m_errorString = tr("Corrupt record at offset %1.").arg(m_position);
+        m_position = m_size;
+        return false;
+    }
+    m_lastTimeStamp = qint64(quint64(m_lastTimeStamp) + quint64(zigZagDecode(delta)));
+
+    QCanBusFrame result(FrameTypes[type]);
+    if (result.frameType() == QCanBusFrame::ErrorFrame)
+        result.setError(QCanBusFrame::FrameErrors(quint32(frameId)));
+    else
+        result.setFrameId(QCanBusFrame::FrameId(frameId));
+    result.setExtendedFrameFormat(flags & CanLog::ExtendedFrameFormat);
+    result.setPayload(reinterpret_cast<const char *>(p), payloadSize);
+    result.setFlexibleDataRateFormat(flags & CanLog::FlexibleDataRateFormat);
+    if (flags & CanLog::BitrateSwitch)
+        result.setBitrateSwitch(true);
+    if (flags & CanLog::ErrorStateIndicator)
+        result.setErrorStateIndicator(true);
+    result.setLocalEcho(flags & CanLog::LocalEcho);
+    result.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(m_lastTimeStamp));
+    *frame = result;
+
+    m_position = (p + payloadSize) - m_data;
+    return true;
+}
+
+void CanLogReader::close()
+{
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_size = m_position = 0;
+}
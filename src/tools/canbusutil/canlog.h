@@ -0,0 +1,136 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef CANLOG_H
+#define CANLOG_H
+
+#include <QCanBusFrame>
+#include <QCoreApplication>
+#include <QFile>
+
+/*
+    Compact binary log of CAN bus frames, one file per channel.
+
+    The file starts with a 16 byte header: the magic "QCANLOG\0", followed by
+    the format version and a reserved field as little endian quint32. Each
+    frame is stored as one record:
+
+    * quint8 flags: RecordMarker (always set), extended frame format,
+      flexible data rate format, bitrate switch, error state indicator,
+      local echo, and the frame type in two bits
+    * the timestamp in microseconds, as zigzag encoded LEB128 difference
+      to the timestamp of the previous record
+    * the frame ID as LEB128, or the error flags for error frames
+    * quint8 payload length, followed by the payload
+
+    A typical classic CAN frame takes 13 to 16 bytes. The writer grows the file
+    in memory-mapped windows, so a recording that is interrupted leaves zero
+    bytes at the end, which the reader recognizes by the missing RecordMarker.
+*/
+namespace CanLog {
+enum : quint32 { Version = 1 };
+enum : int { HeaderSize = 16, MaximumRecordSize = 1 + 10 + 5 + 1 + 64 };
+enum RecordFlag : quint8 {
+    ExtendedFrameFormat = 0x01,
+    FlexibleDataRateFormat = 0x02,
+    BitrateSwitch = 0x04,
+    ErrorStateIndicator = 0x08,
+    LocalEcho = 0x10,
+    FrameTypeMask = 0x60,
+    RecordMarker = 0x80
+};
+enum : int { FrameTypeShift = 5 };
+
+// Both functions write at most HeaderSize or MaximumRecordSize bytes to p and
+// return the position behind them. Frames of other types than data, remote
+// request and error frames are skipped.
+uchar *writeHeader(uchar *p);
+uchar *writeRecord(uchar *p, const QCanBusFrame &frame, qint64 *lastTimeStamp);
+}
+
+class CanLogWriter
+{
+    Q_DECLARE_TR_FUNCTIONS(CanLogWriter)
+public:
+    explicit CanLogWriter(const QString &fileName);
+    ~CanLogWriter();
+
+    bool open();
+    bool write(const QCanBusFrame &frame);
+    void close();
+
+    QString fileName() const { return m_file.fileName(); }
+    QString errorString() const { return m_errorString; }
+    qint64 framesWritten() const { return m_framesWritten; }
+
+private:
+    bool reserve(qsizetype size);
+
+    QFile m_file;
+    QString m_errorString;
+    uchar *m_window = nullptr;
+    qint64 m_windowStart = 0;
+    qsizetype m_windowSize = 0;
+    qsizetype m_windowUsed = 0;
+    qint64 m_lastTimeStamp = 0;
+    qint64 m_framesWritten = 0;
+};
+
+class CanLogReader
+{
+    Q_DECLARE_TR_FUNCTIONS(CanLogReader)
+public:
+    explicit CanLogReader(const QString &fileName);
+    ~CanLogReader();
+
+    bool open();
+    bool readNext(QCanBusFrame *frame);
+    void close();
+
+    QString fileName() const { return m_file.fileName(); }
+    QString errorString() const { return m_errorString; }
+
+private:
+    QFile m_file;
+    QString m_errorString;
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    qint64 m_position = 0;
+    qint64 m_lastTimeStamp = 0;
+};
+
+#endif // CANLOG_H
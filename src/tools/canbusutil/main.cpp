@@ -60,7 +60,9 @@ int main(int argc, char *argv[])
     QCommandLineParser parser;
     parser.setApplicationDescription(CanBusUtil::tr(
         "Sends arbitrary CAN bus frames.\n"
-        "If the -l option is set, all received CAN bus frames are dumped."));
+        "If the -l option is set, all received CAN bus frames are dumped.\n"
+        "If the -r option is set, all received CAN bus frames are recorded into "
+        "binary log files, which the -p option replays with the original timing."));
     parser.addHelpOption();
     parser.addVersionOption();
 
@@ -68,7 +70,8 @@ int main(int argc, char *argv[])
             CanBusUtil::tr("Plugin name to use. See --list-plugins."));
 
     parser.addPositionalArgument(QStringLiteral("device"),
-            CanBusUtil::tr("Device to use."));
+            CanBusUtil::tr("Device to use. When recording or replaying, a comma "
+                           "separated list of devices, e.g. can0,can1."));
 
     parser.addPositionalArgument(QStringLiteral("data"),
             CanBusUtil::tr(
@@ -85,6 +88,13 @@ int main(int argc, char *argv[])
             CanBusUtil::tr("Start listening CAN data on device."));
     parser.addOption(listeningOption);
 
+    const QCommandLineOption formatOption(QStringLiteral("format"),
+            CanBusUtil::tr("Output format of received CAN bus frames: text (default), "
+                           "candump for fast candump style lines, or binary for the "
+                           "record format of the -r option, e.g. to pipe into other tools."),
+            QStringLiteral("format"), QStringLiteral("text"));
+    parser.addOption(formatOption);
+
     const QCommandLineOption listOption({"L", "list-plugins"},
             CanBusUtil::tr("List all available plugins."));
     parser.addOption(listOption);
@@ -124,6 +134,23 @@ int main(int argc, char *argv[])
             QStringLiteral("bitrate"));
     parser.addOption(dataBitrateOption);
 
+    const QCommandLineOption recordOption({"r", "record"},
+            CanBusUtil::tr("Record all received CAN bus frames into one file "
+                           "<directory>/<device>.canlog per device."),
+            QStringLiteral("directory"));
+    parser.addOption(recordOption);
+
+    const QCommandLineOption replayOption({"p", "replay"},
+            CanBusUtil::tr("Replay the files <directory>/<device>.canlog "
+                           "with their original timing."),
+            QStringLiteral("directory"));
+    parser.addOption(replayOption);
+
+    const QCommandLineOption speedOption({"s", "speed"},
+            CanBusUtil::tr("Replay faster (> 1) or slower (< 1) by the given factor."),
+            QStringLiteral("factor"));
+    parser.addOption(speedOption);
+
     parser.process(app);
 
     if (parser.isSet(listOption))
@@ -147,9 +174,37 @@ int main(int argc, char *argv[])
                                        parser.value(dataBitrateOption).toInt());
     }
 
-    if (parser.isSet(listeningOption)) {
+    if (parser.isSet(recordOption) || parser.isSet(replayOption)) {
+        if (args.size() != 2) {
+            output << CanBusUtil::tr("Invalid number of arguments (%1 given).").arg(args.size());
+            output << Qt::endl << Qt::endl << parser.helpText();
+            return 1;
+        }
+        util.setRecordDirectory(parser.value(recordOption));
+        util.setReplayDirectory(parser.value(replayOption));
+        if (parser.isSet(speedOption)) {
+            bool ok = false;
+            const double speed = parser.value(speedOption).toDouble(&ok);
+            if (!ok || speed <= 0) {
+                output << CanBusUtil::tr("Invalid replay speed: '%1'.")
+                          .arg(parser.value(speedOption)) << Qt::endl;
+                return 1;
+            }
+            util.setReplaySpeed(speed);
+        }
+    } else if (parser.isSet(listeningOption)) {
         util.setShowTimeStamp(parser.isSet(showTimeStampOption));
         util.setShowFlags(parser.isSet(showFlagsOption));
+
+        const QString format = parser.value(formatOption);
+        if (format == QLatin1String("candump")) {
+            util.setOutputFormat(ReadTask::OutputFormat::CanDump);
+        } else if (format == QLatin1String("binary")) {
+            util.setOutputFormat(ReadTask::OutputFormat::Binary);
+        } else if (format != QLatin1String("text")) {
+            output << CanBusUtil::tr("Invalid output format: '%1'.").arg(format) << Qt::endl;
+            return 1;
+        }
     } else if (args.size() == 3) {
         data = args.at(2);
     } else if (args.size() == 1 && parser.isSet(listDevicesOption)) {
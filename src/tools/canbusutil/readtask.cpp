@@ -35,6 +35,50 @@
 ****************************************************************************/
 
 #include "readtask.h"
+#include "canlog.h"
+
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#  include <fcntl.h>
+#  include <io.h>
+#  include <stdio.h>
+#endif
+
+namespace {
+// Frames taken from the device's receive queue at once
+constexpr size_t FrameBatchSize = 256;
+// The fast output formats write the buffer when it exceeds this size
+constexpr qsizetype FlushThreshold = 64 * 1024;
+// Longest candump line without the device name
+constexpr qsizetype MaximumLineSize = 19 + 4 + 7 + 8 + 6 + 1 + 64 * 3 + 16 + 1;
+// Marks the ID of error frames in candump output, CAN_ERR_FLAG in <linux/can.h>
+constexpr quint32 CanErrorFlag = 0x20000000U;
+
+char *appendHex(char *p, quint32 value, int digits)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    for (int i = digits - 1; i >= 0; --i)
+        p[digits - 1 - i] = hexDigits[(value >> (4 * i)) & 0xf];
+    return p + digits;
+}
+
+char *appendDecimal(char *p, quint64 value, int digits)
+{
+    for (int i = digits - 1; i >= 0; --i) {
+        p[i] = char('0' + value % 10);
+        value /= 10;
+    }
+    return p + digits;
+}
+
+char *appendLiteral(char *p, const char *text)
+{
+    while (*text)
+        *p++ = *text++;
+    return p;
+}
+}
 
 ReadTask::ReadTask(QTextStream &output, QObject *parent) :
     QObject(parent),
@@ -55,6 +99,21 @@ void ReadTask::setShowFlags(bool showFlags)
     m_showFlags = showFlags;
 }
 
+void ReadTask::setOutputFormat(OutputFormat format)
+{
+    m_outputFormat = format;
+#ifdef Q_OS_WIN
+    // stdout is opened in text mode, which would turn every 0x0a byte of a record into CR LF
+    if (format == OutputFormat::Binary)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+}
+
+void ReadTask::setDeviceName(const QString &deviceName)
+{
+    m_deviceName = deviceName.toUtf8();
+}
+
 void ReadTask::handleFrames() {
     auto canDevice = qobject_cast<QCanBusDevice *>(QObject::sender());
     if (canDevice == nullptr) {
@@ -62,6 +121,11 @@ void ReadTask::handleFrames() {
         return;
     }
 
+    if (m_outputFormat != OutputFormat::Text) {
+        writeFramesFast(canDevice);
+        return;
+    }
+
     while (canDevice->framesAvailable()) {
         const QCanBusFrame frame = canDevice->readFrame();
 
@@ -91,8 +155,122 @@ void ReadTask::handleFrames() {
         else
             view += frame.toString();
 
-        m_output << view << Qt::endl;
+        m_output << view << '\n';
     }
+    // one flush for all frames that were available
+    m_output.flush();
+}
+
+void ReadTask::writeFramesFast(QCanBusDevice *canDevice)
+{
+    if (m_frames.empty())
+        m_frames.resize(FrameBatchSize);
+
+    if (m_outputFormat == OutputFormat::Binary && !m_headerWritten) {
+        m_buffer.resize(CanLog::HeaderSize);
+        CanLog::writeHeader(reinterpret_cast<uchar *>(m_buffer.data()));
+        m_headerWritten = true;
+    }
+
+    qsizetype count = 0;
+    while ((count = canDevice->readFrames(m_frames.data(), qsizetype(m_frames.size()))) > 0) {
+        for (qsizetype i = 0; i < count; ++i) {
+            if (m_outputFormat == OutputFormat::Binary) {
+                const qsizetype size = m_buffer.size();
+                m_buffer.resize(size + CanLog::MaximumRecordSize);
+                uchar *const record = reinterpret_cast<uchar *>(m_buffer.data()) + size;
+                const uchar *const end = CanLog::writeRecord(record, m_frames[i],
+                                                             &m_lastTimeStamp);
+                m_buffer.resize(size + (end - record));
+            } else {
+                appendCanDumpLine(m_frames[i]);
+            }
+        }
+        if (m_buffer.size() >= FlushThreshold)
+            flushBuffer();
+    }
+    flushBuffer();
+}
+
+/*
+    Appends a line in the format of candump from the Linux can-utils, like
+    "(1630000000.123456)  can0  123   [3]  11 22 33". Timestamp and flags are
+    only written when requested.
+*/
+void ReadTask::appendCanDumpLine(const QCanBusFrame &frame)
+{
+    const qsizetype size = m_buffer.size();
+    m_buffer.resize(size + MaximumLineSize + m_deviceName.size());
+    char *const line = m_buffer.data() + size;
+    char *p = line;
+
+    if (m_showTimeStamp) {
+        const QCanBusFrame::TimeStamp timeStamp = frame.timeStamp();
+        *p++ = '(';
+        p = appendDecimal(p, quint64(qMax<qint64>(0, timeStamp.seconds())), 10);
+        *p++ = '.';
+        p = appendDecimal(p, quint64(qMax<qint64>(0, timeStamp.microSeconds())), 6);
+        *p++ = ')';
+    }
+
+    p = appendLiteral(p, "  ");
+    std::memcpy(p, m_deviceName.constData(), m_deviceName.size());
+    p += m_deviceName.size();
+    p = appendLiteral(p, "  ");
+
+    if (m_showFlags) {
+        p = appendLiteral(p, frame.hasBitrateSwitch() ? "B " : "- ");
+        p = appendLiteral(p, frame.hasErrorStateIndicator() ? "E " : "- ");
+        p = appendLiteral(p, frame.hasLocalEcho() ? "L  " : "-  ");
+    }
+
+    if (frame.frameType() == QCanBusFrame::ErrorFrame)
+        p = appendHex(p, CanErrorFlag | quint32(frame.error()), 8);
+    else if (frame.hasExtendedFrameFormat())
+        p = appendHex(p, frame.frameId(), 8);
+    else
+        p = appendHex(p, frame.frameId(), 3);
+
+    const QByteArrayView payload = frame.payloadView();
+    const qsizetype payloadSize = qMin<qsizetype>(payload.size(), 64);
+    if (frame.hasFlexibleDataRateFormat()) {
+        p = appendLiteral(p, "  [");
+        p = appendDecimal(p, quint64(payloadSize), 2);
+    } else {
+        p = appendLiteral(p, "   [");
+        p = appendDecimal(p, quint64(payloadSize), 1);
+    }
+    *p++ = ']';
+
+    if (frame.frameType() == QCanBusFrame::RemoteRequestFrame) {
+        p = appendLiteral(p, "  remote request");
+    } else if (payloadSize > 0) {
+        *p++ = ' ';
+        for (qsizetype i = 0; i < payloadSize; ++i) {
+            *p++ = ' ';
+            p = appendHex(p, quint8(payload.at(i)), 2);
+        }
+    }
+    if (frame.frameType() == QCanBusFrame::ErrorFrame)
+        p = appendLiteral(p, "  ERRORFRAME");
+    *p++ = '\n';
+
+    m_buffer.resize(size + (p - line));
+}
+
+void ReadTask::flushBuffer()
+{
+    if (m_buffer.isEmpty())
+        return;
+
+    // keep the order with text written before, like error messages
+    m_output.flush();
+    if (QIODevice *device = m_output.device()) {
+        device->write(m_buffer);
+        device->flush();
+    }
+    // keeps the capacity for the next batch
+    m_buffer.resize(0);
 }
 
 void ReadTask::handleError(QCanBusDevice::CanBusError /*error*/)
@@ -103,5 +281,11 @@ void ReadTask::handleError(QCanBusDevice::CanBusError /*error*/)
         return;
     }
 
+    // do not mix error messages into the binary output
+    if (m_outputFormat == OutputFormat::Binary) {
+        qWarning("Read error: '%ls'", qUtf16Printable(canDevice->errorString()));
+        return;
+    }
+
     m_output << tr("Read error: '%1'").arg(canDevice->errorString()) << Qt::endl;
 }
@@ -41,23 +41,43 @@
 #include <QtSerialBus>
 #include <QCanBusFrame>
 
+#include <vector>
+
 class ReadTask : public QObject
 {
     Q_OBJECT
 public:
+    enum class OutputFormat {
+        Text,       // human readable, error frames are interpreted
+        CanDump,    // candump style lines, formatted without QString
+        Binary      // canlog records, see canlog.h
+    };
+
     explicit ReadTask(QTextStream &m_output, QObject *parent = nullptr);
     void setShowTimeStamp(bool showStamp);
     bool isShowFlags() const;
     void setShowFlags(bool isShowFlags);
+    void setOutputFormat(OutputFormat format);
+    void setDeviceName(const QString &deviceName);
 
 public slots:
     void handleFrames();
     void handleError(QCanBusDevice::CanBusError /*error*/);
 
 private:
+    void writeFramesFast(QCanBusDevice *canDevice);
+    void appendCanDumpLine(const QCanBusFrame &frame);
+    void flushBuffer();
+
     QTextStream &m_output;
     bool m_showTimeStamp = false;
     bool m_showFlags = false;
+    OutputFormat m_outputFormat = OutputFormat::Text;
+    QByteArray m_deviceName;
+    QByteArray m_buffer;
+    std::vector<QCanBusFrame> m_frames;
+    qint64 m_lastTimeStamp = 0;
+    bool m_headerWritten = false;
 };
 
 #endif // READTASK_H
@@ -0,0 +1,115 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "recordtask.h"
+
+#include <QTextStream>
+
+namespace {
+// Frames taken from the device's receive queue at once
+constexpr size_t FrameBatchSize = 256;
+}
+
+RecordTask::RecordTask(QTextStream &output, QObject *parent) :
+    QObject(parent),
+    m_output(output),
+    m_frames(FrameBatchSize)
+{
+}
+
+RecordTask::~RecordTask()
+{
+    finish();
+}
+
+bool RecordTask::addChannel(QCanBusDevice *device, const QString &fileName)
+{
+    auto writer = std::make_unique<CanLogWriter>(fileName);
+    if (!writer->open()) {
+        m_output << tr("Cannot create log file '%1': %2")
+                    .arg(fileName, writer->errorString()) << Qt::endl;
+        return false;
+    }
+
+    const size_t index = m_channels.size();
+    m_channels.push_back({ device, std::move(writer) });
+    connect(device, &QCanBusDevice::framesReceived, this, [this, index]() {
+        handleFrames(index);
+    });
+    return true;
+}
+
+void RecordTask::finish()
+{
+    for (size_t i = 0; i < m_channels.size(); ++i) {
+        Channel &channel = m_channels[i];
+        if (!channel.writer)
+            continue;
+
+        // take the frames that arrived since the last notification
+        handleFrames(i);
+        if (!channel.writer)
+            continue;
+
+        channel.writer->close();
+        m_output << tr("Recorded %1 frames to '%2'.")
+                    .arg(channel.writer->framesWritten())
+                    .arg(channel.writer->fileName()) << Qt::endl;
+        channel.writer.reset();
+    }
+}
+
+void RecordTask::handleFrames(size_t index)
+{
+    Channel &channel = m_channels[index];
+    if (!channel.device || !channel.writer)
+        return;
+
+    qsizetype count = 0;
+    while ((count = channel.device->readFrames(m_frames.data(), qsizetype(m_frames.size()))) > 0) {
+        for (qsizetype i = 0; i < count; ++i) {
+            if (Q_UNLIKELY(!channel.writer->write(m_frames[i]))) {
+                m_output << tr("Cannot write log file '%1': %2")
+                            .arg(channel.writer->fileName(), channel.writer->errorString())
+                         << Qt::endl;
+                // keep what was recorded so far
+                channel.writer.reset();
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef RECORDTASK_H
+#define RECORDTASK_H
+
+#include "canlog.h"
+
+#include <QObject>
+#include <QPointer>
+#include <QtSerialBus>
+
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+class QTextStream;
+
+QT_END_NAMESPACE
+
+class RecordTask : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RecordTask(QTextStream &output, QObject *parent = nullptr);
+    ~RecordTask();
+
+    bool addChannel(QCanBusDevice *device, const QString &fileName);
+
+public slots:
+    void finish();
+
+private:
+    struct Channel
+    {
+        QPointer<QCanBusDevice> device;
+        std::unique_ptr<CanLogWriter> writer;
+    };
+
+    void handleFrames(size_t index);
+
+    QTextStream &m_output;
+    std::vector<Channel> m_channels;
+    std::vector<QCanBusFrame> m_frames;
+};
+
+#endif // RECORDTASK_H
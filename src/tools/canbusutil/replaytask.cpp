@@ -0,0 +1,158 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "replaytask.h"
+
+#include <QTextStream>
+#include <QThread>
+
+#include <limits>
+
+// Frames due in less than this many nanoseconds are not waited for with a timer
+constexpr qint64 SpinThreshold = 1000000;
+
+ReplayTask::ReplayTask(QTextStream &output, QObject *parent) :
+    QObject(parent),
+    m_output(output)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &ReplayTask::replayDueFrames);
+}
+
+bool ReplayTask::addChannel(QCanBusDevice *device, const QString &fileName)
+{
+    Channel channel;
+    channel.device = device;
+    channel.reader = std::make_unique<CanLogReader>(fileName);
+    if (!channel.reader->open()) {
+        m_output << tr("Cannot open log file '%1': %2")
+                    .arg(fileName, channel.reader->errorString()) << Qt::endl;
+        return false;
+    }
+
+    readNextFrame(&channel);
+    m_channels.push_back(std::move(channel));
+    return true;
+}
+
+void ReplayTask::setSpeed(double speed)
+{
+    m_speed = speed;
+}
+
+void ReplayTask::start()
+{
+    // all channels share the time base of the earliest frame
+    m_startTimeStamp = std::numeric_limits<qint64>::max();
+    for (const Channel &channel : m_channels) {
+        if (channel.hasNextFrame)
+            m_startTimeStamp = qMin(m_startTimeStamp, channel.nextTimeStamp);
+    }
+
+    m_clock.start();
+    replayDueFrames();
+}
+
+void ReplayTask::readNextFrame(Channel *channel)
+{
+    channel->hasNextFrame = channel->reader->readNext(&channel->nextFrame);
+    if (channel->hasNextFrame) {
+        channel->nextTimeStamp = channel->nextFrame.timeStamp().seconds() * 1000000
+                + channel->nextFrame.timeStamp().microSeconds();
+    } else if (!channel->reader->errorString().isEmpty()) {
+        m_output << tr("Cannot read log file '%1': %2")
+                    .arg(channel->reader->fileName(), channel->reader->errorString())
+                 << Qt::endl;
+    }
+}
+
+void ReplayTask::replayDueFrames()
+{
+    qint64 now = m_clock.nsecsElapsed();
+
+    for (;;) {
+        // merge the channels in timestamp order
+        Channel *channel = nullptr;
+        for (Channel &candidate : m_channels) {
+            if (candidate.hasNextFrame
+                    && (!channel || candidate.nextTimeStamp < channel->nextTimeStamp)) {
+                channel = &candidate;
+            }
+        }
+
+        if (!channel) {
+            // let the plugins send the frames they have queued before quitting
+            for (const Channel &pending : m_channels) {
+                if (pending.device && pending.device->framesToWrite() > 0) {
+                    m_timer.start(1);
+                    return;
+                }
+            }
+            for (const Channel &finished : m_channels) {
+                m_output << tr("Replayed %1 frames from '%2'.")
+                            .arg(finished.framesWritten)
+                            .arg(finished.reader->fileName()) << Qt::endl;
+            }
+            emit finished();
+            return;
+        }
+
+        const qint64 due = qint64((channel->nextTimeStamp - m_startTimeStamp) * 1000 / m_speed);
+        if (due > now)
+            now = m_clock.nsecsElapsed(); // sending may have taken a while
+        if (due - now >= SpinThreshold) {
+            // wake up early, the rest of the wait is spun below
+            m_timer.start(int((due - now) / 1000000));
+            return;
+        }
+        // timers have millisecond granularity, spin for the sub-millisecond rest
+        while (now < due) {
+            QThread::yieldCurrentThread();
+            now = m_clock.nsecsElapsed();
+        }
+
+        QCanBusFrame &frame = channel->nextFrame;
+        // error frames are generated by the controller and cannot be sent
+        if (channel->device && frame.frameType() != QCanBusFrame::ErrorFrame) {
+            frame.setLocalEcho(false);
+            if (channel->device->writeFrame(frame))
+                ++channel->framesWritten;
+        }
+        readNextFrame(channel);
+    }
+}
@@ -0,0 +1,93 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the tools applications of the QtSerialBus module.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#ifndef REPLAYTASK_H
+#define REPLAYTASK_H
+
+#include "canlog.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QtSerialBus>
+
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+class QTextStream;
+
+QT_END_NAMESPACE
+
+class ReplayTask : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ReplayTask(QTextStream &output, QObject *parent = nullptr);
+
+    bool addChannel(QCanBusDevice *device, const QString &fileName);
+    void setSpeed(double speed);
+    void start();
+
+signals:
+    void finished();
+
+private:
+    struct Channel
+    {
+        QPointer<QCanBusDevice> device;
+        std::unique_ptr<CanLogReader> reader;
+        QCanBusFrame nextFrame;
+        qint64 nextTimeStamp = 0;
+        bool hasNextFrame = false;
+        qint64 framesWritten = 0;
+    };
+
+    void readNextFrame(Channel *channel);
+    void replayDueFrames();
+
+    QTextStream &m_output;
+    std::vector<Channel> m_channels;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+    double m_speed = 1.0;
+    qint64 m_startTimeStamp = 0;
+};
+
+#endif // REPLAYTASK_H
@@ -0,0 +1,165 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include "canlog.h"
+
+#include <QtCore/qtemporarydir.h>
+#include <QtTest/QtTest>
+
+#include <limits>
+
+class tst_CanLog : public QObject
+{
+    Q_OBJECT
+
+    static QCanBusFrame frame(QCanBusFrame::FrameId frameId, const QByteArray &payload,
+                              qint64 microSeconds)
+    {
+        QCanBusFrame result(frameId, payload);
+        result.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(microSeconds));
+        return result;
+    }
+
+    static QList<QCanBusFrame> writeAndRead(const QString &fileName,
+                                            const QList<QCanBusFrame> &frames)
+    {
+        CanLogWriter writer(fileName);
+        if (!writer.open())
+            return {};
+        for (const QCanBusFrame &frame : frames)
+            writer.write(frame);
+        writer.close();
+
+        QList<QCanBusFrame> result;
+        CanLogReader reader(fileName);
+        if (!reader.open())
+            return {};
+        QCanBusFrame frame;
+        while (reader.readNext(&frame))
+            result.append(frame);
+        if (!reader.errorString().isEmpty())
+            return {};
+        return result;
+    }
+
+    static void compare(const QCanBusFrame &actual, const QCanBusFrame &expected)
+    {
+        QCOMPARE(actual.frameType(), expected.frameType());
+        QCOMPARE(actual.frameId(), expected.frameId());
+        QCOMPARE(actual.error(), expected.error());
+        QCOMPARE(actual.payload(), expected.payload());
+        QCOMPARE(actual.hasExtendedFrameFormat(), expected.hasExtendedFrameFormat());
+        QCOMPARE(actual.hasFlexibleDataRateFormat(), expected.hasFlexibleDataRateFormat());
+        QCOMPARE(actual.hasBitrateSwitch(), expected.hasBitrateSwitch());
+        QCOMPARE(actual.hasErrorStateIndicator(), expected.hasErrorStateIndicator());
+        QCOMPARE(actual.hasLocalEcho(), expected.hasLocalEcho());
+        QCOMPARE(actual.timeStamp().seconds(), expected.timeStamp().seconds());
+        QCOMPARE(actual.timeStamp().microSeconds(), expected.timeStamp().microSeconds());
+    }
+
+private slots:
+    void roundTrip()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        QList<QCanBusFrame> frames;
+        frames.append(frame(0x123, QByteArray::fromHex("0102030405060708"), 1000000));
+
+        QCanBusFrame extended = frame(0x1abcdef0, QByteArray::fromHex("ff"), 1000250);
+        extended.setExtendedFrameFormat(true);
+        extended.setLocalEcho(true);
+        frames.append(extended);
+
+        QCanBusFrame remote = frame(0x7ff, QByteArray(), 1000500);
+        remote.setFrameType(QCanBusFrame::RemoteRequestFrame);
+        frames.append(remote);
+
+        QByteArray fdPayload(64, Qt::Uninitialized);
+        for (int i = 0; i < fdPayload.size(); ++i)
+            fdPayload[i] = char(i * 3);
+        QCanBusFrame fd = frame(0x18daf110, fdPayload, 1000750);
+        fd.setExtendedFrameFormat(true);
+        fd.setBitrateSwitch(true);
+        fd.setErrorStateIndicator(true);
+        QVERIFY(fd.hasFlexibleDataRateFormat());
+        frames.append(fd);
+
+        QCanBusFrame error(QCanBusFrame::ErrorFrame);
+        error.setError(QCanBusFrame::ControllerError | QCanBusFrame::BusOffError);
+        error.setPayload(QByteArray::fromHex("0004000000000000"));
+        error.setTimeStamp(QCanBusFrame::TimeStamp::fromMicroSeconds(1001000));
+        frames.append(error);
+
+        const QList<QCanBusFrame> restored = writeAndRead(dir.filePath(u"frames.qcanlog"_qs),
+                                                          frames);
+        QCOMPARE(restored.size(), frames.size());
+        for (int i = 0; i < frames.size(); ++i) {
+            compare(restored.at(i), frames.at(i));
+            if (QTest::currentTestFailed())
+                return;
+        }
+        QCOMPARE(restored.last().error(),
+                 QCanBusFrame::ControllerError | QCanBusFrame::BusOffError);
+    }
+
+    void timeStampWrapAround()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // the differences between these timestamps do not fit into a qint64
+        constexpr qint64 Max = std::numeric_limits<qint64>::max();
+        constexpr qint64 Min = std::numeric_limits<qint64>::min() + 1;
+        QList<QCanBusFrame> frames;
+        for (qint64 microSeconds : { qint64(0), Max, Min, Max, qint64(-1), qint64(1) })
+            frames.append(frame(0x100, QByteArray::fromHex("aa"), microSeconds));
+
+        const QList<QCanBusFrame> restored = writeAndRead(dir.filePath(u"frames.qcanlog"_qs),
+                                                          frames);
+        QCOMPARE(restored.size(), frames.size());
+        for (int i = 0; i < frames.size(); ++i) {
+            compare(restored.at(i), frames.at(i));
+            if (QTest::currentTestFailed())
+                return;
+        }
+    }
+};
+
+QTEST_MAIN(tst_CanLog)
+
+#include "tst_canlog.moc"
@@ -0,0 +1,203 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qcanbus.h>
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qlibrary.h>
+#include <QtTest/qtest.h>
+
+#include <memory>
+#include <vector>
+
+// Layout of the driver's TPCANMsg, see tests/auto/plugins/pcanbasic
+struct StubPcanMsg
+{
+    quint32 id;
+    quint8 msgType;
+    quint8 len;
+    quint8 data[8];
+};
+
+typedef void (*StubPcanResetFunction)();
+typedef void (*StubPcanSetTransmitQueueSizeFunction)(qint32 size);
+typedef qint32 (*StubPcanWriteCallsFunction)();
+typedef qint32 (*StubPcanTakeTransmittedFunction)(quint16 channel, StubPcanMsg *msg, qint32 count);
+
+static const quint16 usbChannel1 = 0x51; // PCAN_USBBUS1, "usb0"
+
+class tst_PeakCanBackend : public QObject
+{
+    Q_OBJECT
+public:
+    tst_PeakCanBackend() = default;
+
+private slots:
+    void initTestCase();
+    void init();
+    void batchedTransmit();
+    void partialTransmit();
+
+private:
+    QList<quint32> takeTransmittedIds(int maxCount);
+
+    QLibrary stub;
+    StubPcanResetFunction reset = nullptr;
+    StubPcanSetTransmitQueueSizeFunction setTransmitQueueSize = nullptr;
+    StubPcanWriteCallsFunction writeCalls = nullptr;
+    StubPcanTakeTransmittedFunction takeTransmitted = nullptr;
+};
+
+void tst_PeakCanBackend::initTestCase()
+{
+    // Load the stub first, so that the plugin's lookup of "pcanbasic" resolves to it
+    stub.setFileName(QStringLiteral(PCANBASIC_STUB_PATH));
+    QVERIFY2(stub.load(), qPrintable(stub.errorString()));
+
+    reset = reinterpret_cast<StubPcanResetFunction>(stub.resolve("StubPcanReset"));
+    setTransmitQueueSize = reinterpret_cast<StubPcanSetTransmitQueueSizeFunction>(
+                stub.resolve("StubPcanSetTransmitQueueSize"));
+    writeCalls = reinterpret_cast<StubPcanWriteCallsFunction>(stub.resolve("StubPcanWriteCalls"));
+    takeTransmitted = reinterpret_cast<StubPcanTakeTransmittedFunction>(
+                stub.resolve("StubPcanTakeTransmitted"));
+    QVERIFY(reset && setTransmitQueueSize && writeCalls && takeTransmitted);
+
+    if (!QCanBus::instance()->plugins().contains(QStringLiteral("peakcan")))
+        QSKIP("The peakcan plugin is not available.");
+}
+
+void tst_PeakCanBackend::init()
+{
+    reset();
+}
+
+QList<quint32> tst_PeakCanBackend::takeTransmittedIds(int maxCount)
+{
+    std::vector<StubPcanMsg> messages(maxCount);
+    const qint32 count = takeTransmitted(usbChannel1, messages.data(), maxCount);
+
+    QList<quint32> ids;
+    for (qint32 i = 0; i < count; ++i)
+        ids.append(messages[i].id);
+    return ids;
+}
+
+void tst_PeakCanBackend::batchedTransmit()
+{
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(
+            QCanBus::instance()->createDevice(QStringLiteral("peakcan"), QStringLiteral("usb0"),
+                                              &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(device->connectDevice());
+
+    QList<qint64> framesWritten;
+    connect(device.get(), &QCanBusDevice::framesWritten,
+            [&framesWritten](qint64 count) { framesWritten.append(count); });
+
+    constexpr int frameCount = 300;
+    QList<quint32> expectedIds;
+    for (int i = 0; i < frameCount; ++i) {
+        QVERIFY(device->writeFrame(QCanBusFrame(quint32(0x200 + i), QByteArray(1, char(i)))));
+        expectedIds.append(quint32(0x200 + i));
+    }
+    QCOMPARE(device->framesToWrite(), qint64(frameCount));
+
+    // One write event hands over the whole queue, one CAN_Write() per frame
+    QTRY_COMPARE(framesWritten.size(), 1);
+    QCOMPARE(framesWritten.first(), qint64(frameCount));
+    QCOMPARE(device->framesToWrite(), qint64(0));
+    QCOMPARE(writeCalls(), frameCount);
+
+    std::vector<StubPcanMsg> messages(frameCount);
+    QCOMPARE(takeTransmitted(usbChannel1, messages.data(), frameCount), frameCount);
+    for (int i = 0; i < frameCount; ++i) {
+        QCOMPARE(messages[i].id, expectedIds.at(i));
+        QCOMPARE(messages[i].len, quint8(1));
+        QCOMPARE(messages[i].data[0], quint8(i));
+    }
+
+    device->disconnectDevice();
+}
+
+void tst_PeakCanBackend::partialTransmit()
+{
+    // The driver's transmit queue fills up in the middle of the outgoing frames,
+    // which must stay queued in order and be retried instead of dropped.
+    setTransmitQueueSize(100);
+
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(
+            QCanBus::instance()->createDevice(QStringLiteral("peakcan"), QStringLiteral("usb0"),
+                                              &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(device->connectDevice());
+
+    QList<qint64> framesWritten;
+    connect(device.get(), &QCanBusDevice::framesWritten,
+            [&framesWritten](qint64 count) { framesWritten.append(count); });
+
+    constexpr int frameCount = 150;
+    QList<quint32> expectedIds;
+    for (int i = 0; i < frameCount; ++i) {
+        QVERIFY(device->writeFrame(QCanBusFrame(quint32(0x300 + i), QByteArray())));
+        expectedIds.append(quint32(0x300 + i));
+    }
+
+    QTRY_COMPARE(framesWritten.size(), 1);
+    QCOMPARE(framesWritten.first(), qint64(100));
+    QCOMPARE(device->framesToWrite(), qint64(frameCount - 100));
+
+    // Polling a full queue neither writes nor drops frames
+    QTest::qWait(20);
+    QCOMPARE(framesWritten.size(), 1);
+    QCOMPARE(device->framesToWrite(), qint64(frameCount - 100));
+
+    QList<quint32> ids = takeTransmittedIds(frameCount);
+    QCOMPARE(ids.size(), 100);
+    QTRY_COMPARE(device->framesToWrite(), qint64(0));
+    QCOMPARE(framesWritten.last(), qint64(frameCount - 100));
+    ids += takeTransmittedIds(frameCount);
+    QCOMPARE(ids, expectedIds);
+    QCOMPARE(device->error(), QCanBusDevice::NoError);
+
+    device->disconnectDevice();
+}
+
+QTEST_MAIN(tst_PeakCanBackend)
+
+#include "tst_peakcanbackend.moc"
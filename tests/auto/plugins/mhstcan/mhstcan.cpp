@@ -0,0 +1,301 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+// A minimal stand-in for the Tiny-CAN driver library (mhstcan). It keeps the
+// receive FIFO of each channel in memory, so that the tinycan plugin can be
+// tested without hardware. The StubCan* functions let tests inject messages
+// and inspect how the plugin used the driver.
+
+#include <QtCore/qglobal.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+
+#ifdef Q_OS_WIN32
+#  include <windows.h>
+#  define DRV_CALLBACK_TYPE WINAPI
+#else
+#  define DRV_CALLBACK_TYPE
+#endif
+
+#define STUB_EXPORT extern "C" Q_DECL_EXPORT
+
+#pragma pack(push, 1)
+struct TCanFlagsBits
+{
+    unsigned Len:4;
+    unsigned TxD:1;
+    unsigned Error:1;
+    unsigned RTR:1;
+    unsigned EFF:1;
+    unsigned Source:8;
+};
+
+union TCanFlags
+{
+    TCanFlagsBits Flag;
+    quint32 Long;
+};
+
+union TCanData
+{
+    char Chars[8];
+    quint8 Bytes[8];
+    quint16 Words[4];
+    quint32 Longs[2];
+};
+
+struct TTime
+{
+    quint32 Sec;
+    quint32 USec;
+};
+
+struct TCanMsg
+{
+    quint32 Id;
+    TCanFlags Flags;
+    TCanData Data;
+    TTime Time;
+};
+
+struct TDeviceStatus
+{
+    quint32 DrvStatus;
+    quint8 CanStatus;
+    quint8 FifoStatus;
+};
+#pragma pack(pop)
+
+typedef void (DRV_CALLBACK_TYPE *CanPnPEventCallback)(quint32 index, qint32 status);
+typedef void (DRV_CALLBACK_TYPE *CanStatusEventCallback)(quint32 index, TDeviceStatus *status);
+typedef void (DRV_CALLBACK_TYPE *CanRxEventCallback)(quint32 index, TCanMsg *msg, qint32 count);
+
+namespace {
+
+struct Channel
+{
+    std::deque<TCanMsg> receiveFifo;
+    std::deque<TCanMsg> transmitFifo;
+};
+
+struct Driver
+{
+    std::mutex mutex;
+    std::map<quint32, Channel> channels;
+    CanRxEventCallback rxCallback = nullptr;
+    qint32 receiveCalls = 0;
+    qint32 transmitCalls = 0;
+    qint32 transmitFifoSize = 255;
+};
+
+Driver &driver()
+{
+    static Driver instance;
+    return instance;
+}
+
+} // namespace
+
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanInitDriver(char *) { return 0; }
+STUB_EXPORT void DRV_CALLBACK_TYPE CanDownDriver() {}
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanSetOptions(char *) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanDeviceOpen(quint32, char *) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanDeviceClose(quint32) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanApplaySettings(quint32) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanSetMode(quint32, quint8, quint16) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanSet(quint32, quint16, quint16, void *, qint32) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanGet(quint32, quint16, quint16, void *, qint32) { return 0; }
+
+// Accepts as many messages as fit into the TX FIFO, they stay there until taken by the test
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanTransmit(quint32 index, TCanMsg *msg, qint32 count)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    ++d.transmitCalls;
+
+    std::deque<TCanMsg> &fifo = d.channels[index].transmitFifo;
+    qint32 written = 0;
+    while (written < count && qint32(fifo.size()) < d.transmitFifoSize)
+        fifo.push_back(msg[written++]);
+    return written;
+}
+
+STUB_EXPORT void DRV_CALLBACK_TYPE CanTransmitClear(quint32 index)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.channels[index].transmitFifo.clear();
+}
+
+STUB_EXPORT quint32 DRV_CALLBACK_TYPE CanTransmitGetCount(quint32 index)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return quint32(d.channels[index].transmitFifo.size());
+}
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanTransmitSet(quint32, quint16, quint32) { return 0; }
+
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanReceive(quint32 index, TCanMsg *msg, qint32 count)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    ++d.receiveCalls;
+
+    std::deque<TCanMsg> &fifo = d.channels[index].receiveFifo;
+    qint32 read = 0;
+    while (read < count && !fifo.empty()) {
+        msg[read++] = fifo.front();
+        fifo.pop_front();
+    }
+    return read;
+}
+
+STUB_EXPORT void DRV_CALLBACK_TYPE CanReceiveClear(quint32 index)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.channels[index].receiveFifo.clear();
+}
+
+STUB_EXPORT quint32 DRV_CALLBACK_TYPE CanReceiveGetCount(quint32 index)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return quint32(d.channels[index].receiveFifo.size());
+}
+
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanSetSpeed(quint32, quint16) { return 0; }
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanSetSpeedUser(quint32, quint32) { return 0; }
+
+STUB_EXPORT char *DRV_CALLBACK_TYPE CanDrvInfo()
+{
+    static char info[] = "Description=Qt test stub";
+    return info;
+}
+
+STUB_EXPORT char *DRV_CALLBACK_TYPE CanDrvHwInfo(quint32)
+{
+    static char info[] = "";
+    return info;
+}
+
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanSetFilter(quint32, void *) { return 0; }
+
+STUB_EXPORT qint32 DRV_CALLBACK_TYPE CanGetDeviceStatus(quint32, TDeviceStatus *status)
+{
+    status->DrvStatus = 8; // DRV_STATUS_CAN_RUN
+    status->CanStatus = 0; // CAN_STATUS_OK
+    status->FifoStatus = 0; // FIFO_OK
+    return 0;
+}
+
+STUB_EXPORT void DRV_CALLBACK_TYPE CanSetPnPEventCallback(CanPnPEventCallback) {}
+STUB_EXPORT void DRV_CALLBACK_TYPE CanSetStatusEventCallback(CanStatusEventCallback) {}
+
+STUB_EXPORT void DRV_CALLBACK_TYPE CanSetRxEventCallback(CanRxEventCallback callback)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.rxCallback = callback;
+}
+
+STUB_EXPORT void DRV_CALLBACK_TYPE CanSetEvents(quint16) {}
+STUB_EXPORT quint32 DRV_CALLBACK_TYPE CanEventStatus() { return 0; }
+
+// Test interface
+
+STUB_EXPORT void StubCanReset()
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.channels.clear();
+    d.receiveCalls = 0;
+    d.transmitCalls = 0;
+    d.transmitFifoSize = 255;
+}
+
+// Appends count messages to the receive FIFO and signals them like the driver thread does.
+STUB_EXPORT void StubCanInjectReceive(quint32 index, const TCanMsg *msg, qint32 count)
+{
+    Driver &d = driver();
+    CanRxEventCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(d.mutex);
+        std::deque<TCanMsg> &fifo = d.channels[index].receiveFifo;
+        fifo.insert(fifo.end(), msg, msg + count);
+        callback = d.rxCallback;
+    }
+    if (callback)
+        callback(index, nullptr, count);
+}
+
+STUB_EXPORT qint32 StubCanReceiveCalls()
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.receiveCalls;
+}
+
+STUB_EXPORT void StubCanSetTransmitFifoSize(qint32 size)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.transmitFifoSize = size;
+}
+
+STUB_EXPORT qint32 StubCanTransmitCalls()
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.transmitCalls;
+}
+
+// Removes up to count messages from the TX FIFO, as if they were sent on the bus.
+STUB_EXPORT qint32 StubCanTakeTransmitted(quint32 index, TCanMsg *msg, qint32 count)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+
+    std::deque<TCanMsg> &fifo = d.channels[index].transmitFifo;
+    qint32 taken = 0;
+    while (taken < count && !fifo.empty()) {
+        msg[taken++] = fifo.front();
+        fifo.pop_front();
+    }
+    return taken;
+}
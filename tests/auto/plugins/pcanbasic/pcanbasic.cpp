@@ -0,0 +1,245 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+// A minimal stand-in for the PCAN-Basic driver library. Every channel is
+// available and keeps its transmit queue in memory, so that the peakcan plugin
+// can be tested without hardware. The StubPcan* functions let tests limit the
+// transmit queue and inspect what the plugin wrote.
+
+#include <QtCore/qglobal.h>
+
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#ifdef Q_OS_WIN32
+#  include <windows.h>
+#  define DRV_CALLBACK_TYPE WINAPI
+#else
+#  include <unistd.h>
+#  define DRV_CALLBACK_TYPE
+#endif
+
+#define STUB_EXPORT extern "C" Q_DECL_EXPORT
+
+// Values from the PCAN-Basic header, see src/plugins/canbus/peakcan/peakcan_symbols_p.h
+#define PCAN_ERROR_OK            0x00000U
+#define PCAN_ERROR_QRCVEMPTY     0x00020U
+#define PCAN_ERROR_QXMTFULL      0x00080U
+#define PCAN_ERROR_ILLPARAMTYPE  0x04000U
+
+#define PCAN_RECEIVE_EVENT       0x03U
+#define PCAN_API_VERSION         0x05U
+
+typedef quint32 TPCANStatus;
+typedef quint16 TPCANHandle;
+
+struct TPCANMsg
+{
+    quint32 ID;
+    quint8 MSGTYPE;
+    quint8 LEN;
+    quint8 DATA[8];
+};
+
+struct TPCANTimestamp
+{
+    quint32 millis;
+    quint16 millis_overflow;
+    quint16 micros;
+};
+
+struct TPCANMsgFD
+{
+    quint32 ID;
+    quint8 MSGTYPE;
+    quint8 DLC;
+    quint8 DATA[64];
+};
+
+namespace {
+
+struct Driver
+{
+    std::mutex mutex;
+    std::map<TPCANHandle, std::deque<TPCANMsg>> transmitQueues;
+    qint32 writeCalls = 0;
+    qint32 transmitQueueSize = 32768;
+#ifndef Q_OS_WIN32
+    int receivePipe[2] = { -1, -1 };
+#endif
+};
+
+Driver &driver()
+{
+    static Driver instance;
+    return instance;
+}
+
+} // namespace
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_Initialize(TPCANHandle, quint16, quint8, quint32,
+                                                         quint16)
+{
+    return PCAN_ERROR_OK;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_InitializeFD(TPCANHandle, char *)
+{
+    return PCAN_ERROR_OK;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_Uninitialize(TPCANHandle) { return PCAN_ERROR_OK; }
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_Reset(TPCANHandle) { return PCAN_ERROR_OK; }
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_GetStatus(TPCANHandle) { return PCAN_ERROR_OK; }
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_Read(TPCANHandle, TPCANMsg *, TPCANTimestamp *)
+{
+    return PCAN_ERROR_QRCVEMPTY;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_ReadFD(TPCANHandle, TPCANMsgFD *, quint64 *)
+{
+    return PCAN_ERROR_QRCVEMPTY;
+}
+
+// Accepts one message if there is room in the transmit queue, it stays there
+// until taken by the test
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_Write(TPCANHandle channel, TPCANMsg *msg)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    ++d.writeCalls;
+
+    std::deque<TPCANMsg> &queue = d.transmitQueues[channel];
+    if (qint32(queue.size()) >= d.transmitQueueSize)
+        return PCAN_ERROR_QXMTFULL;
+    queue.push_back(*msg);
+    return PCAN_ERROR_OK;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_WriteFD(TPCANHandle, TPCANMsgFD *)
+{
+    return PCAN_ERROR_ILLPARAMTYPE;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_FilterMessages(TPCANHandle, quint32, quint32, quint8)
+{
+    return PCAN_ERROR_OK;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_GetValue(TPCANHandle, quint8 parameter,
+                                                       void *buffer, quint32 length)
+{
+    switch (parameter) {
+    case PCAN_API_VERSION: {
+        static const char version[] = "4.0.0.0";
+        if (length < sizeof(version))
+            return PCAN_ERROR_ILLPARAMTYPE;
+        std::memcpy(buffer, version, sizeof(version));
+        return PCAN_ERROR_OK;
+    }
+#ifndef Q_OS_WIN32
+    case PCAN_RECEIVE_EVENT: {
+        // A descriptor that never becomes readable, as no messages are received
+        Driver &d = driver();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        if (d.receivePipe[0] < 0 && ::pipe(d.receivePipe) != 0)
+            return PCAN_ERROR_ILLPARAMTYPE;
+        if (length < sizeof(int))
+            return PCAN_ERROR_ILLPARAMTYPE;
+        std::memcpy(buffer, &d.receivePipe[0], sizeof(int));
+        return PCAN_ERROR_OK;
+    }
+#endif
+    default:
+        return PCAN_ERROR_ILLPARAMTYPE;
+    }
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_SetValue(TPCANHandle, quint8, void *, quint32)
+{
+    return PCAN_ERROR_OK;
+}
+
+STUB_EXPORT TPCANStatus DRV_CALLBACK_TYPE CAN_GetErrorText(TPCANStatus error, quint16, char *buffer)
+{
+    const char *text = error == PCAN_ERROR_QXMTFULL ? "Transmit queue is full"
+                                                    : "Qt test stub error";
+    std::strcpy(buffer, text);
+    return PCAN_ERROR_OK;
+}
+
+// Test interface
+
+STUB_EXPORT void StubPcanReset()
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.transmitQueues.clear();
+    d.writeCalls = 0;
+    d.transmitQueueSize = 32768;
+}
+
+STUB_EXPORT void StubPcanSetTransmitQueueSize(qint32 size)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    d.transmitQueueSize = size;
+}
+
+STUB_EXPORT qint32 StubPcanWriteCalls()
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+    return d.writeCalls;
+}
+
+// Removes up to count messages from the transmit queue, as if they were sent on the bus.
+STUB_EXPORT qint32 StubPcanTakeTransmitted(TPCANHandle channel, TPCANMsg *msg, qint32 count)
+{
+    Driver &d = driver();
+    std::lock_guard<std::mutex> lock(d.mutex);
+
+    std::deque<TPCANMsg> &queue = d.transmitQueues[channel];
+    qint32 taken = 0;
+    while (taken < count && !queue.empty()) {
+        msg[taken++] = queue.front();
+        queue.pop_front();
+    }
+    return taken;
+}
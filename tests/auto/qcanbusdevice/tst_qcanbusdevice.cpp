@@ -37,12 +37,16 @@
 #include <QtSerialBus/qcanbusdevice.h>
 #include <QtSerialBus/qcanbusframe.h>
 
+#include <QtCore/qdatetime.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qthread.h>
 #include <QtCore/qtimer.h>
 #include <QtCore/QtPlugin>
 #include <QtTest/qsignalspy.h>
 #include <QtTest/qtest.h>
 
 #include <memory>
+#include <numeric>
 
 Q_DECLARE_METATYPE(QCanBusDevice::Filter)
 
@@ -56,6 +60,9 @@ public:
         referenceFrame.setPayload(QByteArray("FOOBAR"));
         referenceFrame.setTimeStamp({ 22, 23 });
         referenceFrame.setExtendedFrameFormat(1);
+
+        connect(this, &QCanBusDevice::configurationParameterChanged,
+                this, [this](ConfigurationKey key) { changedKeys.append(key); });
     }
 
     bool triggerNewFrame()
@@ -69,21 +76,65 @@ public:
         return true;
     }
 
+    bool triggerNewFrames(const QList<QCanBusFrame> &frames)
+    {
+        if (state() != QCanBusDevice::ConnectedState)
+            return false;
+
+        enqueueReceivedFrames(frames);
+        return true;
+    }
+
     bool open() override
     {
         if (firstOpen) {
             firstOpen = false;
             return false;
         }
+        if (QThread *thread = startIoThread()) {
+            ioContext = new QObject;
+            ioContext->moveToThread(thread);
+        }
         setState(QCanBusDevice::ConnectedState);
         return true;
     }
 
     void close() override
     {
+        if (ioContext) {
+            ioContext->deleteLater();
+            ioContext = nullptr;
+            stopIoThread();
+        }
         setState(QCanBusDevice::UnconnectedState);
     }
 
+    QThread *ioThread() const { return ioContext ? ioContext->thread() : nullptr; }
+
+    void enableSoftwareFilter(bool enabled) { setSoftwareFilterEnabled(enabled); }
+
+    bool flag(ConfigurationKey key) const { return configurationFlag(key); }
+    qint64 integer(ConfigurationKey key, qint64 defaultValue) const
+    {
+        return configurationInteger(key, defaultValue);
+    }
+
+    void installWriteFramesFunction(const WriteFramesFunction &writer)
+    {
+        setWriteFramesFunction(writer);
+    }
+
+    QList<ConfigurationKey> changedKeys;
+
+    // receives a frame and reports an error from within the I/O thread
+    void triggerInIoThread(const QString &errorText)
+    {
+        QMetaObject::invokeMethod(ioContext, [this, errorText]() {
+            triggerNewFrame();
+            setError(errorText, QCanBusDevice::ReadError);
+        }, Qt::BlockingQueuedConnection);
+    }
+
     bool writeFrame(const QCanBusFrame &data) override
     {
         if (state() != QCanBusDevice::ConnectedState) {
@@ -96,6 +147,7 @@ public:
             enqueueOutgoingFrame(data);
             QTimer::singleShot(2000, this, [this](){ triggerDelayedWrites(); });
         } else {
+            recordWrittenFrames(1, data.payloadView().size());
             emit framesWritten(1);
         }
         return true;
@@ -138,7 +190,8 @@ public slots:
         if (framesToWrite() == 0)
             return;
 
-        dequeueOutgoingFrame();
+        const QCanBusFrame frame = dequeueOutgoingFrame();
+        recordWrittenFrames(1, frame.payloadView().size());
         emit framesWritten(1);
 
         if (framesToWrite() > 0)
@@ -149,6 +202,7 @@ private:
     QCanBusFrame referenceFrame;
     bool firstOpen = true;
     bool writeBufferUsed = true;
+    QObject *ioContext = nullptr;
 };
 
 class tst_QCanBusDevice : public QObject
@@ -160,10 +214,18 @@ public:
 private slots:
     void initTestCase();
     void conf();
+    void typedConfiguration();
     void write();
     void read();
     void readAll();
+    void readWriteFrames();
     void clearInputBuffer();
+    void receiveQueueOverflow();
+    void receiveQueueBlockTimeout();
+    void ioThread();
+    void frameHandler();
+    void softwareFilter();
+    void statistics();
     void clearOutputBuffer();
     void error();
     void cleanupTestCase();
@@ -237,6 +299,49 @@ void tst_QCanBusDevice::conf()
     QVERIFY(device->configurationKeys().isEmpty());
 }
 
+void tst_QCanBusDevice::typedConfiguration()
+{
+    tst_Backend backend;
+    QVERIFY(!backend.flag(QCanBusDevice::CanFdKey));
+    QCOMPARE(backend.integer(QCanBusDevice::BitRateKey, 125000), 125000);
+
+    backend.setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    backend.setConfigurationParameter(QCanBusDevice::BitRateKey, 500000);
+    backend.setConfigurationParameter(QCanBusDevice::ProtocolKey, u"raw"_qs);
+    QVERIFY(backend.flag(QCanBusDevice::CanFdKey));
+    QCOMPARE(backend.integer(QCanBusDevice::BitRateKey, 125000), 500000);
+    QCOMPARE(backend.integer(QCanBusDevice::ProtocolKey, -1), -1);
+    QCOMPARE(backend.configurationKeys(), (QList<QCanBusDevice::ConfigurationKey>{
+            QCanBusDevice::CanFdKey, QCanBusDevice::BitRateKey, QCanBusDevice::ProtocolKey }));
+    QCOMPARE(backend.changedKeys, (QList<QCanBusDevice::ConfigurationKey>{
+            QCanBusDevice::CanFdKey, QCanBusDevice::BitRateKey, QCanBusDevice::ProtocolKey }));
+
+    // setting the same value again does not notify
+    backend.changedKeys.clear();
+    backend.setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    QVERIFY(backend.changedKeys.isEmpty());
+
+    backend.setConfigurationParameter(QCanBusDevice::CanFdKey, false);
+    QVERIFY(!backend.flag(QCanBusDevice::CanFdKey));
+    backend.setConfigurationParameter(QCanBusDevice::BitRateKey, QVariant());
+    QCOMPARE(backend.integer(QCanBusDevice::BitRateKey, 125000), 125000);
+    QVERIFY(!backend.configurationParameter(QCanBusDevice::BitRateKey).isValid());
+    QCOMPARE(backend.changedKeys, (QList<QCanBusDevice::ConfigurationKey>{
+            QCanBusDevice::CanFdKey, QCanBusDevice::BitRateKey }));
+    QCOMPARE(backend.configurationKeys(), (QList<QCanBusDevice::ConfigurationKey>{
+            QCanBusDevice::CanFdKey, QCanBusDevice::ProtocolKey }));
+
+    // keys above UserKey are stored as well
+    const auto userKey = QCanBusDevice::ConfigurationKey(QCanBusDevice::UserKey + 1);
+    backend.setConfigurationParameter(userKey, 42);
+    QCOMPARE(backend.integer(userKey, 0), 42);
+    QVERIFY(backend.flag(userKey));
+    QCOMPARE(backend.configurationParameter(userKey), QVariant(42));
+    QCOMPARE(backend.configurationKeys().last(), userKey);
+    backend.setConfigurationParameter(userKey, QVariant());
+    QVERIFY(!backend.configurationKeys().contains(userKey));
+}
+
 void tst_QCanBusDevice::write()
 {
     // we assume unbuffered writing in this function
@@ -326,6 +431,53 @@ void tst_QCanBusDevice::readAll()
     QVERIFY(!device->framesAvailable());
 }
 
+void tst_QCanBusDevice::readWriteFrames()
+{
+    QCanBusFrame buffer[4];
+    QCOMPARE(device->readFrames(buffer, 4), 0);
+    QCOMPARE(device->error(), QCanBusDevice::NoError);
+
+    for (int i = 0; i < 6; ++i)
+        device->triggerNewFrame();
+
+    QCOMPARE(device->readFrames(buffer, 4), 4);
+    QCOMPARE(buffer[3].frameId(), 5u);
+    QCOMPARE(device->framesAvailable(), 2);
+    QCOMPARE(device->readFrames(buffer, 4), 2);
+    QVERIFY(!device->framesAvailable());
+
+    const bool wasWriteBuffered = device->isWriteBuffered();
+    device->setWriteBuffered(false);
+    QSignalSpy spy(device.get(), &QCanBusDevice::framesWritten);
+    const QCanBusFrame frames[3] = {
+        QCanBusFrame(0x10, "a"), QCanBusFrame(0x11, "b"), QCanBusFrame(0x12, "c")
+    };
+    QCOMPARE(device->writeFrames(frames, 3), 3);
+    QCOMPARE(spy.count(), 3);
+    device->setWriteBuffered(wasWriteBuffered);
+
+    // a plugin can pass all frames to the driver at once
+    QList<qsizetype> batches;
+    device->installWriteFramesFunction([&batches](const QCanBusFrame *, qsizetype count) {
+        batches.append(count);
+        return count - 1;
+    });
+    QCOMPARE(device->writeFrames(frames, 3), 2);
+    QCOMPARE(batches, QList<qsizetype>({ 3 }));
+    QCOMPARE(spy.count(), 3);
+    device->installWriteFramesFunction(nullptr);
+
+    device->disconnectDevice();
+    QTRY_VERIFY_WITH_TIMEOUT(device->state() == QCanBusDevice::UnconnectedState, 5000);
+
+    QCOMPARE(device->readFrames(buffer, 4), 0);
+    QCOMPARE(device->error(), QCanBusDevice::OperationError);
+    QCOMPARE(device->writeFrames(frames, 3), 0);
+
+    QVERIFY(device->connectDevice());
+    QTRY_VERIFY_WITH_TIMEOUT(device->state() == QCanBusDevice::ConnectedState, 5000);
+}
+
 void tst_QCanBusDevice::clearInputBuffer()
 {
     device->disconnectDevice();
@@ -349,6 +501,340 @@ void tst_QCanBusDevice::clearInputBuffer()
     QVERIFY(!device->framesAvailable());
 }
 
+void tst_QCanBusDevice::receiveQueueOverflow()
+{
+    tst_Backend backend;
+    QCOMPARE(backend.receiveQueueCapacity(), 4096);
+    QCOMPARE(backend.receiveQueueOverflowPolicy(),
+             QCanBusDevice::ReceiveQueueOverflowPolicy::DropNewest);
+
+    backend.setReceiveQueueCapacity(3); // rounded up to the next power of two
+    QCOMPARE(backend.receiveQueueCapacity(), 4);
+
+    QVERIFY(!backend.connectDevice()); // first connect triggered to fail
+    QVERIFY(backend.connectDevice());
+    QCOMPARE(backend.state(), QCanBusDevice::ConnectedState);
+
+    backend.setReceiveQueueCapacity(8);
+    QCOMPARE(backend.error(), QCanBusDevice::OperationError);
+    QCOMPARE(backend.receiveQueueCapacity(), 4);
+
+    QList<QCanBusFrame> frames;
+    for (int i = 0; i < 6; ++i)
+        frames.append(QCanBusFrame(QCanBusFrame::FrameId(i), QByteArray(1, char(i))));
+
+    // only the first overflow after connecting is reported
+    QSignalSpy errorSpy(&backend, &QCanBusDevice::errorOccurred);
+    backend.triggerNewFrames(frames);
+    QCOMPARE(backend.framesAvailable(), 4);
+    QCOMPARE(backend.droppedFramesCount(), 2u);
+    QCOMPARE(errorSpy.count(), 1);
+    QCOMPARE(backend.error(), QCanBusDevice::ReadError);
+    QCOMPARE(backend.readFrame().frameId(), 0u);
+    backend.clear(QCanBusDevice::Input);
+
+    backend.setReceiveQueueOverflowPolicy(QCanBusDevice::ReceiveQueueOverflowPolicy::DropOldest);
+    backend.triggerNewFrames(frames);
+    QCOMPARE(backend.droppedFramesCount(), 4u);
+    const QList<QCanBusFrame> received = backend.readAllFrames();
+    QCOMPARE(received.size(), 4);
+    QCOMPARE(received.first().frameId(), 2u);
+    QCOMPARE(received.last().frameId(), 5u);
+
+    // no other thread reads the frames, so blocking falls back to dropping the new frames
+    backend.setReceiveQueueOverflowPolicy(QCanBusDevice::ReceiveQueueOverflowPolicy::Block);
+    backend.triggerNewFrames(frames);
+    QCOMPARE(backend.framesAvailable(), 4);
+    QCOMPARE(backend.droppedFramesCount(), 6u);
+    QCOMPARE(backend.readFrame().frameId(), 0u);
+    QCOMPARE(errorSpy.count(), 1);
+
+    backend.disconnectDevice();
+    QVERIFY(backend.connectDevice());
+    backend.triggerNewFrames(frames);
+    QCOMPARE(errorSpy.count(), 2);
+}
+
+void tst_QCanBusDevice::receiveQueueBlockTimeout()
+{
+    tst_Backend backend;
+    backend.setReceiveQueueCapacity(4);
+    backend.setReceiveQueueOverflowPolicy(QCanBusDevice::ReceiveQueueOverflowPolicy::Block);
+    QVERIFY(!backend.connectDevice()); // first connect triggered to fail
+    QVERIFY(backend.connectDevice());
+
+    // let another thread become the reader, so that the full queue blocks
+    QVERIFY(backend.triggerNewFrame());
+    std::unique_ptr<QThread> reader(QThread::create([&backend]() { backend.readFrame(); }));
+    reader->start();
+    QVERIFY(reader->wait());
+    QCOMPARE(backend.framesAvailable(), 0);
+
+    QList<QCanBusFrame> frames;
+    for (int i = 0; i < 6; ++i)
+        frames.append(QCanBusFrame(QCanBusFrame::FrameId(i), QByteArray(1, char(i))));
+
+    // the reader never comes back: the first overflowing frame waits for the
+    // timeout, the next one is dropped right away
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(backend.triggerNewFrames(frames));
+    QVERIFY(timer.elapsed() >= 90);
+    QVERIFY(timer.elapsed() < 5000);
+    QCOMPARE(backend.framesAvailable(), 4);
+    QCOMPARE(backend.droppedFramesCount(), 2u);
+}
+
+void tst_QCanBusDevice::ioThread()
+{
+    tst_Backend backend;
+    QVERIFY(!backend.isIoThreadEnabled());
+    QCOMPARE(backend.ioThreadPriority(), QThread::InheritPriority);
+    QVERIFY(backend.ioThreadAffinity().isEmpty());
+
+    backend.setIoThreadEnabled(true);
+    backend.setIoThreadPriority(QThread::HighPriority);
+    backend.setIoThreadAffinity({ 0 });
+    QVERIFY(backend.isIoThreadEnabled());
+    QCOMPARE(backend.ioThreadPriority(), QThread::HighPriority);
+    QCOMPARE(backend.ioThreadAffinity(), QList<int>({ 0 }));
+
+    QVERIFY(!backend.connectDevice()); // first connect triggered to fail
+    QVERIFY(backend.connectDevice());
+    QThread *thread = backend.ioThread();
+    QVERIFY(thread);
+    QVERIFY(thread != QThread::currentThread());
+    QVERIFY(thread->isRunning());
+
+    // cannot be changed while connected
+    backend.setIoThreadEnabled(false);
+    QCOMPARE(backend.error(), QCanBusDevice::OperationError);
+    QVERIFY(backend.isIoThreadEnabled());
+
+    QSignalSpy receivedSpy(&backend, &QCanBusDevice::framesReceived);
+    QSignalSpy errorSpy(&backend, &QCanBusDevice::errorOccurred);
+    backend.triggerInIoThread(u"I/O thread error"_qs);
+    QTRY_COMPARE(receivedSpy.count(), 1);
+    QCOMPARE(backend.framesAvailable(), 1);
+    QTRY_COMPARE(errorSpy.count(), 1);
+    QCOMPARE(backend.error(), QCanBusDevice::ReadError);
+    QCOMPARE(backend.errorString(), u"I/O thread error"_qs);
+
+    backend.disconnectDevice();
+    QCOMPARE(backend.state(), QCanBusDevice::UnconnectedState);
+    QVERIFY(!thread->isRunning());
+}
+
+void tst_QCanBusDevice::frameHandler()
+{
+    tst_Backend backend;
+    QVERIFY(!backend.frameHandler());
+
+    QList<QCanBusFrame> handled;
+    backend.setFrameHandler([&handled](const QCanBusFrame *frames, qsizetype count) {
+        for (qsizetype i = 0; i < count; ++i)
+            handled.append(frames[i]);
+    });
+    QVERIFY(backend.frameHandler());
+
+    QVERIFY(!backend.connectDevice()); // first connect triggered to fail
+    QVERIFY(backend.connectDevice());
+
+    // cannot be changed while connected
+    backend.setFrameHandler({});
+    QCOMPARE(backend.error(), QCanBusDevice::OperationError);
+    QVERIFY(backend.frameHandler());
+
+    QSignalSpy receivedSpy(&backend, &QCanBusDevice::framesReceived);
+    const QList<QCanBusFrame> frames = { QCanBusFrame(1, "a"), QCanBusFrame(2, "b") };
+    QVERIFY(backend.triggerNewFrames(frames));
+
+    // the frames bypass the receive queue and the signal
+    QCOMPARE(handled.size(), 2);
+    QCOMPARE(handled.at(0).frameId(), 1u);
+    QCOMPARE(handled.at(1).payload(), QByteArray("b"));
+    QCOMPARE(receivedSpy.count(), 0);
+    QCOMPARE(backend.framesAvailable(), 0);
+
+    backend.disconnectDevice();
+    backend.setFrameHandler({});
+    QVERIFY(!backend.frameHandler());
+}
+
+void tst_QCanBusDevice::softwareFilter()
+{
+    using Filter = QCanBusDevice::Filter;
+
+    tst_Backend backend;
+    backend.enableSoftwareFilter(true);
+    QVERIFY(!backend.connectDevice()); // first connect triggered to fail
+    QVERIFY(backend.connectDevice());
+
+    auto frame = [](QCanBusFrame::FrameId id, bool extended,
+                    QCanBusFrame::FrameType type = QCanBusFrame::DataFrame) {
+        QCanBusFrame frame(type);
+        frame.setFrameId(id);
+        frame.setExtendedFrameFormat(extended);
+        return frame;
+    };
+    const QList<QCanBusFrame> frames = {
+        frame(0x18daf110, true),                                    // exact ID
+        frame(0x18daf111, true),
+        frame(0x18daf110, true, QCanBusFrame::RemoteRequestFrame),  // wrong type
+        frame(0x123, false),                                        // base range
+        frame(0x1ff, false, QCanBusFrame::RemoteRequestFrame),
+        frame(0x123, true),                                         // wrong format
+        frame(0x200, false),
+        frame(0x12345678, true),                                    // extended mask
+        frame(0x12345778, true),
+        frame(0x7, false, QCanBusFrame::RemoteRequestFrame),        // single base ID
+        frame(0x7, false),
+    };
+    auto receivedIds = [&backend, &frames]() {
+        backend.triggerNewFrames(frames);
+        QList<QCanBusFrame::FrameId> ids;
+        for (const QCanBusFrame &frame : backend.readAllFrames())
+            ids.append(frame.frameId());
+        return ids;
+    };
+
+    // without RawFilterKey everything is received
+    QCOMPARE(receivedIds().size(), frames.size());
+
+    Filter exact;
+    exact.frameId = 0x18daf110;
+    exact.frameIdMask = 0x1fffffff;
+    exact.type = QCanBusFrame::DataFrame;
+    exact.format = Filter::MatchExtendedFormat;
+    Filter baseRange;
+    baseRange.frameId = 0x100;
+    baseRange.frameIdMask = 0x700;
+    baseRange.format = Filter::MatchBaseFormat;
+    Filter extendedMask;
+    extendedMask.frameId = 0x12345600;
+    extendedMask.frameIdMask = 0x1fffff00;
+    extendedMask.type = QCanBusFrame::DataFrame;
+    Filter remoteRequest;
+    remoteRequest.frameId = 0x7;
+    remoteRequest.frameIdMask = 0x7ff;
+    remoteRequest.type = QCanBusFrame::RemoteRequestFrame;
+    remoteRequest.format = Filter::MatchBaseFormat;
+
+    backend.setConfigurationParameter(QCanBusDevice::RawFilterKey, QVariant::fromValue(
+            QList<Filter>{ exact, baseRange, extendedMask, remoteRequest }));
+    QCOMPARE(receivedIds(), (QList<QCanBusFrame::FrameId>{
+            0x18daf110, 0x123, 0x1ff, 0x12345678, 0x7 }));
+
+    // error frames are not matched against the filters
+    backend.triggerNewFrames({ frame(0x200, false), frame(0, false, QCanBusFrame::ErrorFrame) });
+    const QList<QCanBusFrame> errorFrames = backend.readAllFrames();
+    QCOMPARE(errorFrames.size(), 1);
+    QCOMPARE(errorFrames.first().frameType(), QCanBusFrame::ErrorFrame);
+
+    // frames that are filtered out do not notify
+    QSignalSpy receivedSpy(&backend, &QCanBusDevice::framesReceived);
+    backend.triggerNewFrames({ frame(0x200, false), frame(0x18daf111, true) });
+    QCOMPARE(receivedSpy.count(), 0);
+    QCOMPARE(backend.framesAvailable(), 0);
+
+    // an empty list clears the filters
+    backend.setConfigurationParameter(QCanBusDevice::RawFilterKey,
+                                      QVariant::fromValue(QList<Filter>()));
+    QCOMPARE(receivedIds().size(), frames.size());
+
+    // and so does unsetting the key
+    backend.setConfigurationParameter(QCanBusDevice::RawFilterKey, QVariant::fromValue(
+            QList<Filter>{ exact }));
+    QCOMPARE(receivedIds().size(), 1);
+    backend.setConfigurationParameter(QCanBusDevice::RawFilterKey, QVariant());
+    QCOMPARE(receivedIds().size(), frames.size());
+
+    backend.disconnectDevice();
+}
+
+void tst_QCanBusDevice::statistics()
+{
+    auto sum = [](const QList<quint64> &histogram) {
+        return std::accumulate(histogram.cbegin(), histogram.cend(), quint64(0));
+    };
+
+    tst_Backend backend;
+    QCanBusDevice::Statistics statistics = backend.statistics();
+    QCOMPARE(statistics.receivedFrames, 0u);
+    QCOMPARE(statistics.transmittedFrames, 0u);
+    QCOMPARE(statistics.receiveLatencyHistogram.size(),
+             qsizetype(QCanBusDevice::Statistics::HistogramBucketCount));
+    QCOMPARE(sum(statistics.enqueueDurationHistogram), 0u);
+
+    backend.setReceiveQueueCapacity(4);
+    backend.enableSoftwareFilter(true);
+    QVERIFY(!backend.connectDevice()); // first connect triggered to fail
+    QVERIFY(backend.connectDevice());
+
+    QCanBusDevice::Filter filter;
+    filter.frameId = 0;
+    filter.frameIdMask = 0x7fc;
+    filter.format = QCanBusDevice::Filter::MatchBaseFormat;
+    backend.setConfigurationParameter(QCanBusDevice::RawFilterKey,
+                                      QVariant::fromValue(QList<QCanBusDevice::Filter>{ filter }));
+
+    // frames 0 to 3 pass the filter, the second time they overflow the queue
+    const auto now = QCanBusFrame::TimeStamp::fromMicroSeconds(
+            QDateTime::currentMSecsSinceEpoch() * 1000);
+    QList<QCanBusFrame> frames;
+    for (int i = 0; i < 6; ++i) {
+        QCanBusFrame frame(QCanBusFrame::FrameId(i), QByteArray(2, char(i)));
+        frame.setTimeStamp(now);
+        frames.append(frame);
+    }
+    backend.triggerNewFrames(frames);
+    backend.triggerNewFrames(frames);
+    QCOMPARE(backend.readAllFrames().size(), 4);
+
+    backend.emulateError(u"Read error"_qs, QCanBusDevice::ReadError);
+
+    backend.setWriteBuffered(false);
+    QVERIFY(backend.writeFrame(QCanBusFrame(1, "abc")));
+    backend.setWriteBuffered(true);
+    QVERIFY(backend.writeFrame(QCanBusFrame(2, "a")));
+    QVERIFY(backend.writeFrame(QCanBusFrame(3, "b")));
+
+    statistics = backend.statistics();
+    QCOMPARE(statistics.receivedFrames, 12u);
+    QCOMPARE(statistics.receivedBytes, 24u);
+    QCOMPARE(statistics.filteredFrames, 4u);
+    QCOMPARE(statistics.droppedFrames, 4u);
+    QCOMPARE(statistics.peakFramesAvailable, 4);
+    QCOMPARE(statistics.errors, 2u); // the queue overflow and the read error
+    QCOMPARE(statistics.transmittedFrames, 1u);
+    QCOMPARE(statistics.transmittedBytes, 3u);
+    QCOMPARE(statistics.peakFramesToWrite, 2);
+    QCOMPARE(sum(statistics.receiveLatencyHistogram), 4u);
+    QCOMPARE(sum(statistics.enqueueDurationHistogram), 2u);
+
+    // frames without a system clock timestamp are not counted for the latency
+    backend.triggerNewFrames({ QCanBusFrame(1, "x") });
+    QCOMPARE(backend.readAllFrames().size(), 1);
+    QCOMPARE(sum(backend.statistics().receiveLatencyHistogram), 4u);
+
+    backend.clear(QCanBusDevice::Output);
+    backend.resetStatistics();
+    statistics = backend.statistics();
+    QCOMPARE(statistics.receivedFrames, 0u);
+    QCOMPARE(statistics.receivedBytes, 0u);
+    QCOMPARE(statistics.filteredFrames, 0u);
+    QCOMPARE(statistics.droppedFrames, 0u);
+    QCOMPARE(backend.droppedFramesCount(), 4u);
+    QCOMPARE(statistics.peakFramesAvailable, 0);
+    QCOMPARE(statistics.errors, 0u);
+    QCOMPARE(statistics.transmittedFrames, 0u);
+    QCOMPARE(statistics.peakFramesToWrite, 0);
+    QCOMPARE(sum(statistics.receiveLatencyHistogram), 0u);
+    QCOMPARE(sum(statistics.enqueueDurationHistogram), 0u);
+
+    backend.disconnectDevice();
+}
+
 void tst_QCanBusDevice::clearOutputBuffer()
 {
     // this test requires buffered writing
@@ -162,6 +162,37 @@ void tst_QCanBusFrame::payload()
     frame.setPayload("test");
     QCOMPARE(frame.payload().data(), "test");
     QVERIFY(frame.hasFlexibleDataRateFormat());
+
+    // raw data and view access
+    QCanBusFrame rawFrame;
+    const char data[] = "rawdata";
+    rawFrame.setPayload(data, 3);
+    QCOMPARE(rawFrame.payloadView(), QByteArrayView("raw"));
+    QCOMPARE(rawFrame.payload(), QByteArray("raw"));
+    QVERIFY(!rawFrame.hasFlexibleDataRateFormat());
+
+    // payloads exceeding the maximum CAN FD size are kept, but the frame is invalid
+    const QByteArray oversized(65, 'x');
+    rawFrame.setPayload(oversized);
+    QCOMPARE(rawFrame.payloadView(), QByteArrayView(oversized));
+    QCOMPARE(rawFrame.payload(), oversized);
+    QVERIFY(!rawFrame.isValid());
+
+    rawFrame.setPayload(nullptr, 0);
+    QVERIFY(rawFrame.payloadView().isEmpty());
+    QVERIFY(rawFrame.payload().isNull());
+
+    // payloads set from raw data share memory, but are detached when modified
+    QCanBusFrame first;
+    QCanBusFrame second;
+    first.setPayload("first", 5);
+    second.setPayload("second", 6);
+    QByteArray payload = first.payload();
+    QCOMPARE(payload.constData()[payload.size()], '\0');
+    payload.append("payload");
+    QCOMPARE(payload, QByteArray("firstpayload"));
+    QCOMPARE(first.payload(), QByteArray("first"));
+    QCOMPARE(second.payload(), QByteArray("second"));
 }
 
 void tst_QCanBusFrame::timeStamp()
@@ -185,6 +216,22 @@ void tst_QCanBusFrame::timeStamp()
     timeStamp = QCanBusFrame::TimeStamp::fromMicroSeconds(2000001);
     QCOMPARE(timeStamp.seconds(), 2);
     QCOMPARE(timeStamp.microSeconds(), 1);
+
+    // nanoseconds are kept by the frame
+    QCOMPARE(frame.timeStampNanoSeconds(), 0);
+    frame.setTimeStampNanoSeconds(999999999);
+    QCOMPARE(frame.timeStamp().seconds(), 0);
+    QCOMPARE(frame.timeStamp().microSeconds(), 999999);
+    QCOMPARE(frame.timeStampNanoSeconds(), 999999999);
+
+    frame.setTimeStampNanoSeconds(Q_INT64_C(3000001001));
+    QCOMPARE(frame.timeStamp().seconds(), 3);
+    QCOMPARE(frame.timeStamp().microSeconds(), 1);
+    QCOMPARE(frame.timeStampNanoSeconds(), Q_INT64_C(3000001001));
+
+    // setTimeStamp() drops the sub-microsecond part
+    frame.setTimeStamp(QCanBusFrame::TimeStamp(3, 1));
+    QCOMPARE(frame.timeStampNanoSeconds(), Q_INT64_C(3000001000));
 }
 
 void tst_QCanBusFrame::bitRateSwitch()
@@ -557,7 +604,7 @@ void tst_QCanBusFrame::streaming()
 
     QCanBusFrame originalFrame(frameId, payload);
     const QCanBusFrame::TimeStamp originalStamp(seconds, microSeconds);
-    originalFrame.setTimeStamp(originalStamp);
+    originalFrame.setTimeStampNanoSeconds(seconds * 1000000000 + microSeconds * 1000 + 999);
 
     originalFrame.setExtendedFrameFormat(isExtended);
     originalFrame.setFlexibleDataRateFormat(isFlexibleDataRate);
@@ -580,6 +627,7 @@ void tst_QCanBusFrame::streaming()
 
     QCOMPARE(restoredStamp.seconds(), originalStamp.seconds());
     QCOMPARE(restoredStamp.microSeconds(), originalStamp.microSeconds());
+    QCOMPARE(restoredFrame.timeStampNanoSeconds(), originalFrame.timeStampNanoSeconds());
 
     QCOMPARE(restoredFrame.frameType(), originalFrame.frameType());
     QCOMPARE(restoredFrame.hasExtendedFrameFormat(),
@@ -0,0 +1,217 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <private/qmodbusbitpacking_p.h>
+#include <private/qmodbusregisterbank_p.h>
+
+#include <QtTest/QtTest>
+
+#include <vector>
+
+// The packing of the specification, one bit at a time.
+static std::vector<uchar> referencePack(const quint16 *values, qsizetype count)
+{
+    std::vector<uchar> bytes(size_t((count + 7) / 8), 0);
+    for (qsizetype i = 0; i < count; ++i) {
+        if (values[i])
+            bytes[size_t(i / 8)] |= uchar(1U << (i % 8));
+    }
+    return bytes;
+}
+
+static std::vector<quint16> referenceUnpack(const uchar *bytes, qsizetype count)
+{
+    std::vector<quint16> values(size_t(count), 0);
+    for (qsizetype i = 0; i < count; ++i)
+        values[size_t(i)] = (bytes[i / 8] >> (i % 8)) & 1;
+    return values;
+}
+
+// Values that are non-zero only in the high byte, or in a single bit, must
+// pack to a set bit as well.
+static quint16 testValue(qsizetype index, quint32 seed)
+{
+    static const quint16 patterns[] = { 0x0000, 0x0001, 0x0080, 0x0100, 0x8000, 0xffff,
+                                        0x00ff, 0xff00, 0x0000, 0x0000 };
+    const quint32 x = (quint32(index) + seed) * 2654435761U;
+    return patterns[(x >> 16) % (sizeof(patterns) / sizeof(patterns[0]))];
+}
+
+class tst_QModbusBitPacking : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void packByte();
+    void unpackByte();
+    void pack_data();
+    void pack();
+    void unpack_data();
+    void unpack();
+    void registerBankOffsets();
+
+private:
+    void addCounts();
+};
+
+void tst_QModbusBitPacking::packByte()
+{
+    static const quint16 setValues[] = { 0x0001, 0x0080, 0x0100, 0x8000, 0xffff };
+    for (uint byte = 0; byte < 256; ++byte) {
+        for (quint16 setValue : setValues) {
+            quint16 values[8];
+            for (int bit = 0; bit < 8; ++bit)
+                values[bit] = (byte & (1U << bit)) ? setValue : 0;
+            QCOMPARE(uint(QModbusBitPacking::packByte(values)), byte);
+        }
+    }
+}
+
+void tst_QModbusBitPacking::unpackByte()
+{
+    for (uint byte = 0; byte < 256; ++byte) {
+        quint16 values[8];
+        QModbusBitPacking::unpackByte(uchar(byte), values);
+        for (int bit = 0; bit < 8; ++bit)
+            QCOMPARE(values[bit], quint16((byte >> bit) & 1));
+    }
+}
+
+void tst_QModbusBitPacking::addCounts()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("offset");
+
+    // Around the 8-wide and the 16-wide kernel, and the sizes of the largest
+    // requests, each from an aligned and from an odd start.
+    static const int counts[] = { 1, 7, 8, 9, 15, 16, 17, 1968, 2000 };
+    for (int offset : { 0, 1, 3 }) {
+        for (int count : counts) {
+            QTest::addRow("count %d, offset %d", count, offset) << count << offset;
+        }
+    }
+}
+
+void tst_QModbusBitPacking::pack_data()
+{
+    addCounts();
+}
+
+void tst_QModbusBitPacking::pack()
+{
+    QFETCH(int, count);
+    QFETCH(int, offset);
+
+    for (quint32 seed = 0; seed < 4; ++seed) {
+        std::vector<quint16> buffer(size_t(offset + count));
+        for (int i = 0; i < count; ++i)
+            buffer[size_t(offset + i)] = testValue(i, seed);
+        const quint16 *values = buffer.data() + offset;
+
+        // The guard bytes catch writes past the last byte.
+        const qsizetype byteCount = (count + 7) / 8;
+        std::vector<uchar> bytes(size_t(byteCount + 2), 0xa5);
+        QModbusBitPacking::pack(values, count, bytes.data());
+
+        const std::vector<uchar> expected = referencePack(values, count);
+        for (qsizetype i = 0; i < byteCount; ++i)
+            QCOMPARE(bytes[size_t(i)], expected[size_t(i)]);
+        QCOMPARE(bytes[size_t(byteCount)], uchar(0xa5));
+        QCOMPARE(bytes[size_t(byteCount + 1)], uchar(0xa5));
+    }
+}
+
+void tst_QModbusBitPacking::unpack_data()
+{
+    addCounts();
+}
+
+void tst_QModbusBitPacking::unpack()
+{
+    QFETCH(int, count);
+    QFETCH(int, offset);
+
+    const qsizetype byteCount = (count + 7) / 8;
+    for (quint32 seed = 0; seed < 4; ++seed) {
+        // The unused bits of the last byte are set and must be ignored.
+        std::vector<uchar> buffer(size_t(offset + byteCount), 0xff);
+        for (qsizetype i = 0; i < byteCount; ++i)
+            buffer[size_t(offset + i)] = uchar((quint32(i) + seed) * 2654435761U >> 24);
+        const uchar *bytes = buffer.data() + offset;
+
+        std::vector<quint16> values(size_t(count + 2), 0xa5a5);
+        QModbusBitPacking::unpack(bytes, count, values.data());
+
+        const std::vector<quint16> expected = referenceUnpack(bytes, count);
+        for (int i = 0; i < count; ++i)
+            QCOMPARE(values[size_t(i)], expected[size_t(i)]);
+        QCOMPARE(values[size_t(count)], quint16(0xa5a5));
+        QCOMPARE(values[size_t(count + 1)], quint16(0xa5a5));
+    }
+}
+
+void tst_QModbusBitPacking::registerBankOffsets()
+{
+    // The server packs straight out of the register bank, so the values of a
+    // read may start at any offset into the table.
+    QList<quint16> coils(2000 + 3);
+    for (qsizetype i = 0; i < coils.size(); ++i)
+        coils[i] = testValue(i, 7);
+
+    QModbusRegisterBank bank;
+    QVERIFY(bank.setRanges({ QModbusDataUnit(QModbusDataUnit::Coils, 100, coils) }));
+
+    for (int start : { 0, 1, 2, 3 }) {
+        for (int count : { 1, 7, 8, 9, 15, 16, 17, 1968, 2000 }) {
+            const quint16 *values = bank.find(QModbusDataUnit::Coils, 100 + start, count);
+            QVERIFY(values);
+
+            std::vector<uchar> bytes(size_t((count + 7) / 8));
+            QModbusBitPacking::pack(values, count, bytes.data());
+            QCOMPARE(bytes, referencePack(coils.constData() + start, count));
+
+            std::vector<quint16> unpacked(size_t(count));
+            QModbusBitPacking::unpack(bytes.data(), count, unpacked.data());
+            for (int i = 0; i < count; ++i)
+                QCOMPARE(unpacked[size_t(i)], quint16(coils.at(start + i) != 0));
+        }
+    }
+}
+
+QTEST_MAIN(tst_QModbusBitPacking)
+
+#include "tst_qmodbusbitpacking.moc"
@@ -0,0 +1,222 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbusreadplanner.h>
+#include <QtSerialBus/qmodbusreply.h>
+#include <private/qmodbusclient_p.h>
+
+#include <QtTest/QtTest>
+
+class TestClient : public QModbusClient
+{
+    Q_OBJECT
+    class TestClientPrivate : public QModbusClientPrivate
+    {
+        Q_DECLARE_PUBLIC(TestClient)
+
+    public:
+        bool isOpen() const override { return true; }
+        QModbusReply *enqueueRequest(const QModbusRequest &, int serverAddress,
+                                     const QModbusDataUnit &unit,
+                                     QModbusReply::ReplyType type) override
+        {
+            auto reply = new QModbusReply(type, serverAddress, q_func());
+            m_replies.append(reply);
+            m_units.append(unit);
+            return reply;
+        }
+
+        QList<QModbusReply *> m_replies;
+        QList<QModbusDataUnit> m_units;
+    };
+
+public:
+    TestClient()
+        : QModbusClient(*new TestClientPrivate)
+    {}
+    bool open() override {
+        setState(QModbusDevice::ConnectedState);
+        return true;
+    }
+    void close() override {
+        setState(QModbusDevice::UnconnectedState);
+    }
+
+    QList<QModbusReply *> replies() const { return d_func()->m_replies; }
+    QList<QModbusDataUnit> units() const { return d_func()->m_units; }
+
+    Q_DECLARE_PRIVATE(TestClient)
+};
+
+class tst_QModbusReadPlanner : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void addTag()
+    {
+        QModbusReadPlanner planner;
+        QCOMPARE(planner.addTag({ QModbusDataUnit::Invalid, 0, 1 }, 1), -1);
+        QCOMPARE(planner.addTag({ QModbusDataUnit::HoldingRegisters, 0, 0 }, 1), -1);
+        QCOMPARE(planner.addTag({ QModbusDataUnit::HoldingRegisters, 0, 126 }, 1), -1);
+        QCOMPARE(planner.addTag({ QModbusDataUnit::Coils, 0, 2001 }, 1), -1);
+        QCOMPARE(planner.addTag({ QModbusDataUnit::HoldingRegisters, 0xffff, 2 }, 1), -1);
+        QCOMPARE(planner.addTag({ QModbusDataUnit::HoldingRegisters, 0, 1 }, 256), -1);
+        QCOMPARE(planner.tagCount(), 0);
+
+        QCOMPARE(planner.addTag({ QModbusDataUnit::HoldingRegisters, 0, 125 }, 1), 0);
+        QCOMPARE(planner.addTag({ QModbusDataUnit::Coils, 0xffff, 1 }, 2), 1);
+        QCOMPARE(planner.tagCount(), 2);
+        QCOMPARE(planner.tag(1).registerType(), QModbusDataUnit::Coils);
+        QCOMPARE(planner.tag(1).startAddress(), 0xffff);
+        QCOMPARE(planner.tagServerAddress(1), 2);
+        QVERIFY(!planner.tag(2).isValid());
+        QCOMPARE(planner.tagServerAddress(2), -1);
+
+        planner.clear();
+        QCOMPARE(planner.tagCount(), 0);
+        QVERIFY(planner.requests().isEmpty());
+    }
+
+    void requests()
+    {
+        QModbusReadPlanner planner;
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 10, 2 }, 1);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 12, 1 }, 1); // adjacent
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 15, 1 }, 1); // gap of 2
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 11, 3 }, 1); // overlapping
+        planner.addTag({ QModbusDataUnit::InputRegisters, 0, 1 }, 1);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 10, 1 }, 2);
+
+        QList<QModbusReadPlanner::Request> requests = planner.requests();
+        QCOMPARE(requests.size(), 4);
+        QCOMPARE(requests.at(0).serverAddress, 1);
+        QCOMPARE(requests.at(0).unit.registerType(), QModbusDataUnit::InputRegisters);
+        QCOMPARE(requests.at(0).tags, QList<int>({ 4 }));
+        QCOMPARE(requests.at(1).unit.registerType(), QModbusDataUnit::HoldingRegisters);
+        QCOMPARE(requests.at(1).unit.startAddress(), 10);
+        QCOMPARE(requests.at(1).unit.valueCount(), 4);
+        QCOMPARE(requests.at(1).tags, QList<int>({ 0, 3, 1 }));
+        QCOMPARE(requests.at(2).unit.startAddress(), 15);
+        QCOMPARE(requests.at(2).unit.valueCount(), 1);
+        QCOMPARE(requests.at(3).serverAddress, 2);
+        QCOMPARE(requests.at(3).tags, QList<int>({ 5 }));
+
+        planner.setMaximumGap(2);
+        requests = planner.requests();
+        QCOMPARE(requests.size(), 3);
+        QCOMPARE(requests.at(1).unit.startAddress(), 10);
+        QCOMPARE(requests.at(1).unit.valueCount(), 6);
+        QCOMPARE(requests.at(1).tags, QList<int>({ 0, 3, 1, 2 }));
+    }
+
+    void requestLimits()
+    {
+        QModbusReadPlanner planner;
+        planner.setMaximumGap(10);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 0, 100 }, 1);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 100, 25 }, 1);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 125, 1 }, 1);
+        planner.addTag({ QModbusDataUnit::Coils, 0, 1999 }, 1);
+        planner.addTag({ QModbusDataUnit::Coils, 1999, 2 }, 1);
+
+        const QList<QModbusReadPlanner::Request> requests = planner.requests();
+        QCOMPARE(requests.size(), 4);
+        QCOMPARE(requests.at(0).unit.registerType(), QModbusDataUnit::Coils);
+        QCOMPARE(requests.at(0).unit.valueCount(), 1999);
+        QCOMPARE(requests.at(1).unit.startAddress(), 1999);
+        QCOMPARE(requests.at(2).unit.registerType(), QModbusDataUnit::HoldingRegisters);
+        QCOMPARE(requests.at(2).unit.valueCount(), 125);
+        QCOMPARE(requests.at(2).tags, QList<int>({ 0, 1 }));
+        QCOMPARE(requests.at(3).unit.startAddress(), 125);
+    }
+
+    void read()
+    {
+        TestClient client;
+        client.connectDevice();
+
+        QModbusReadPlanner planner;
+        planner.setMaximumGap(1);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 100, 2 }, 1);
+        planner.addTag({ QModbusDataUnit::HoldingRegisters, 103, 1 }, 1);
+        planner.addTag({ QModbusDataUnit::Coils, 0, 4 }, 1);
+
+        QSignalSpy readSpy(&planner, &QModbusReadPlanner::tagRead);
+        QSignalSpy errorSpy(&planner, &QModbusReadPlanner::tagErrorOccurred);
+        QSignalSpy finishedSpy(&planner, &QModbusReadPlanner::finished);
+
+        QVERIFY(planner.read(&client));
+        QVERIFY(!planner.isFinished());
+        const QList<QModbusReply *> replies = client.replies();
+        QCOMPARE(replies.size(), 2);
+        QCOMPARE(client.units().at(1).startAddress(), 100);
+        QCOMPARE(client.units().at(1).valueCount(), 4);
+
+        QModbusReply *reply = replies.at(1);
+        reply->setResult({ QModbusDataUnit::HoldingRegisters, 100, { 0x1, 0x2, 0x3, 0x4 } });
+        reply->setFinished(true);
+        QCOMPARE(readSpy.count(), 2);
+        QCOMPARE(readSpy.at(0).at(0).toInt(), 0);
+        QModbusDataUnit data = readSpy.at(0).at(1).value<QModbusDataUnit>();
+        QCOMPARE(data.startAddress(), 100);
+        QCOMPARE(data.values(), QList<quint16>({ 0x1, 0x2 }));
+        QCOMPARE(readSpy.at(1).at(0).toInt(), 1);
+        data = readSpy.at(1).at(1).value<QModbusDataUnit>();
+        QCOMPARE(data.startAddress(), 103);
+        QCOMPARE(data.values(), QList<quint16>({ 0x4 }));
+        QCOMPARE(finishedSpy.count(), 0);
+
+        replies.at(0)->setError(QModbusDevice::TimeoutError, QStringLiteral("Timeout"));
+        QCOMPARE(errorSpy.count(), 1);
+        QCOMPARE(errorSpy.at(0).at(0).toInt(), 2);
+        QCOMPARE(errorSpy.at(0).at(1).value<QModbusDevice::Error>(), QModbusDevice::TimeoutError);
+        QCOMPARE(finishedSpy.count(), 1);
+        QVERIFY(planner.isFinished());
+
+        // tags of requests that cannot be sent fail right away
+        client.disconnectDevice();
+        QVERIFY(!planner.read(&client));
+        QCOMPARE(errorSpy.count(), 4);
+        QCOMPARE(errorSpy.at(1).at(1).value<QModbusDevice::Error>(),
+                 QModbusDevice::ConnectionError);
+        QCOMPARE(finishedSpy.count(), 2);
+    }
+};
+
+QTEST_MAIN(tst_QModbusReadPlanner)
+
+#include "tst_qmodbusreadplanner.moc"
@@ -1189,6 +1189,73 @@ private slots:
         QCOMPARE(s_msg, QString("QModbusServer::setData() call did end in the expected OVERRIDE."));
     }
 
+    void tst_mapRanges()
+    {
+        TestServer local;
+        QVERIFY(local.setMapRanges({
+            { QModbusDataUnit::HoldingRegisters, 100, QList<quint16>({ 0x1, 0x2, 0x3, 0x4 }) },
+            { QModbusDataUnit::HoldingRegisters, 0, 4 },
+            { QModbusDataUnit::HoldingRegisters, 4, QList<quint16>({ 0x5, 0x6 }) },
+            { QModbusDataUnit::Coils, 8, 8 } }));
+
+        // adjacent ranges are merged
+        QModbusDataUnit results(QModbusDataUnit::HoldingRegisters, 2, 4);
+        QVERIFY(local.data(&results));
+        QCOMPARE(results.values(), QList<quint16>({ 0x0, 0x0, 0x5, 0x6 }));
+
+        results = QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 101, 3);
+        QVERIFY(local.data(&results));
+        QCOMPARE(results.values(), QList<quint16>({ 0x2, 0x3, 0x4 }));
+
+        // no access across the gap between two ranges, or past their end
+        results = QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 4, 97);
+        QVERIFY(!local.data(&results));
+        results = QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 6, 1);
+        QVERIFY(!local.data(&results));
+        results = QModbusDataUnit(QModbusDataUnit::HoldingRegisters, 102, 4);
+        QVERIFY(!local.data(&results));
+        QVERIFY(!local.setData(QModbusDataUnit::HoldingRegisters, 99, 0xabcd));
+        QVERIFY(!local.setData(QModbusDataUnit::Coils, 7, 1));
+        QVERIFY(!local.setData(QModbusDataUnit::InputRegisters, 0, 1));
+
+        QSignalSpy writtenSpy(&local, &TestServer::dataWritten);
+        QVERIFY(local.setData({ QModbusDataUnit::HoldingRegisters, 102, { 0x3, 0xaaaa } }));
+        QCOMPARE(writtenSpy.count(), 1);
+        QCOMPARE(writtenSpy.at(0).at(1).toInt(), 102);
+        QCOMPARE(writtenSpy.at(0).at(2).toInt(), 2);
+        QVERIFY(local.setData({ QModbusDataUnit::HoldingRegisters, 102, { 0x3, 0xaaaa } }));
+        QCOMPARE(writtenSpy.count(), 1); // unchanged values
+        QVERIFY(local.setData(QModbusDataUnit::Coils, 15, 1));
+        QCOMPARE(writtenSpy.count(), 2);
+
+        // the entire table reads the gaps as zero
+        results = QModbusDataUnit(QModbusDataUnit::HoldingRegisters, -1, 0);
+        QVERIFY(local.data(&results));
+        QCOMPARE(results.startAddress(), 0);
+        QCOMPARE(results.valueCount(), 104);
+        QCOMPARE(results.value(5), 0x6);
+        QCOMPARE(results.value(50), 0x0);
+        QCOMPARE(results.value(103), 0xaaaa);
+
+        // requests are served from all ranges
+        QModbusResponse response = local.processRequest(
+            QModbusRequest(QModbusRequest::ReadHoldingRegisters, QByteArray::fromHex("00650003")));
+        QCOMPARE(response.isException(), false);
+        QCOMPARE(response.data(), QByteArray::fromHex("0600020003aaaa"));
+        response = local.processRequest(
+            QModbusRequest(QModbusRequest::ReadHoldingRegisters, QByteArray::fromHex("00050002")));
+        QCOMPARE(response.isException(), true);
+        QCOMPARE(response.data(), QByteArray::fromHex("02"));
+
+        // overlapping ranges are rejected and keep the current map
+        QVERIFY(!local.setMapRanges({ { QModbusDataUnit::InputRegisters, 0, 10 },
+                                      { QModbusDataUnit::InputRegisters, 9, 2 } }));
+        quint16 data = 0;
+        QVERIFY(local.data(QModbusDataUnit::HoldingRegisters, 103, &data));
+        QCOMPARE(data, 0xaaaa);
+        QVERIFY(!local.data(QModbusDataUnit::InputRegisters, 0, &data));
+    }
+
     void testReadWriteDataMissingOrInvalidRegister()
     {
         TestServer local;
@@ -0,0 +1,311 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbustcpclient.h>
+
+#include <QtCore/qendian.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <QtTest/QtTest>
+
+struct ReceivedRequest
+{
+    quint16 transactionId;
+    quint8 serverAddress;
+};
+
+class tst_QModbusTcpClient : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Removes all complete ADUs from the front of buffer.
+    static QList<ReceivedRequest> takeRequests(QByteArray *buffer)
+    {
+        QList<ReceivedRequest> requests;
+        while (buffer->size() >= 7) {
+            const int aduSize = 6 + qFromBigEndian<quint16>(buffer->constData() + 4);
+            if (buffer->size() < aduSize)
+                break;
+            requests.append({ qFromBigEndian<quint16>(buffer->constData()),
+                              quint8(buffer->at(6)) });
+            buffer->remove(0, aduSize);
+        }
+        return requests;
+    }
+
+    // Answers a read holding registers request for one register.
+    static QByteArray response(const ReceivedRequest &request)
+    {
+        QByteArray adu(11, Qt::Uninitialized);
+        qToBigEndian<quint16>(request.transactionId, adu.data());
+        qToBigEndian<quint16>(0, adu.data() + 2);
+        qToBigEndian<quint16>(5, adu.data() + 4);
+        adu[6] = char(request.serverAddress);
+        adu[7] = char(QModbusPdu::ReadHoldingRegisters);
+        adu[8] = 2;
+        qToBigEndian<quint16>(request.serverAddress, adu.data() + 9);
+        return adu;
+    }
+
+private slots:
+    void testInFlightDefaults()
+    {
+        QModbusTcpClient client;
+        QCOMPARE(client.maxInFlightRequests(), 0);
+        QCOMPARE(client.maxInFlightRequestsPerServer(), 0);
+
+        client.setMaxInFlightRequests(8);
+        client.setMaxInFlightRequestsPerServer(2);
+        QCOMPARE(client.maxInFlightRequests(), 8);
+        QCOMPARE(client.maxInFlightRequestsPerServer(), 2);
+
+        client.setMaxInFlightRequests(-1);
+        client.setMaxInFlightRequestsPerServer(-1);
+        QCOMPARE(client.maxInFlightRequests(), 0);
+        QCOMPARE(client.maxInFlightRequestsPerServer(), 0);
+    }
+
+    void testInFlightWindow()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        QModbusTcpClient client;
+        client.setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                      server.serverAddress().toString());
+        client.setConnectionParameter(QModbusDevice::NetworkPortParameter, server.serverPort());
+        client.setTimeout(5000);
+        client.setMaxInFlightRequests(4);
+        client.setMaxInFlightRequestsPerServer(2);
+
+        QVERIFY(client.connectDevice());
+        QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+        QTRY_VERIFY(server.hasPendingConnections());
+        QTcpSocket *peer = server.nextPendingConnection();
+        QVERIFY(peer);
+
+        const QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, 0, 1);
+        QList<QModbusReply *> replies;
+        for (int serverAddress : { 1, 1, 1, 2, 2, 3 }) {
+            QModbusReply *reply = client.sendReadRequest(unit, serverAddress);
+            QVERIFY(reply);
+            replies.append(reply);
+        }
+
+        QByteArray buffer;
+        QList<ReceivedRequest> received;
+        const auto receive = [&]() {
+            buffer += peer->readAll();
+            received += takeRequests(&buffer);
+            return int(received.size());
+        };
+
+        // Two requests each for server 1 and 2 fill the window of four.
+        QTRY_VERIFY(receive() >= 4);
+        QTest::qWait(50);
+        QCOMPARE(receive(), 4);
+        QCOMPARE(received.at(0).serverAddress, quint8(1));
+        QCOMPARE(received.at(1).serverAddress, quint8(1));
+        QCOMPARE(received.at(2).serverAddress, quint8(2));
+        QCOMPARE(received.at(3).serverAddress, quint8(2));
+
+        for (const ReceivedRequest &request : qAsConst(received))
+            peer->write(response(request));
+        received.clear();
+
+        // The third request to server 1 and the request to server 3 follow.
+        QTRY_VERIFY(receive() >= 2);
+        QCOMPARE(received.size(), 2);
+        QCOMPARE(received.at(0).serverAddress, quint8(1));
+        QCOMPARE(received.at(1).serverAddress, quint8(3));
+
+        for (const ReceivedRequest &request : qAsConst(received))
+            peer->write(response(request));
+
+        for (QModbusReply *reply : qAsConst(replies)) {
+            QTRY_VERIFY(reply->isFinished());
+            QCOMPARE(reply->error(), QModbusDevice::NoError);
+            QCOMPARE(reply->result().value(0), quint16(reply->serverAddress()));
+        }
+        qDeleteAll(replies);
+    }
+
+    void testDeleteQueuedReply()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        QModbusTcpClient client;
+        client.setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                      server.serverAddress().toString());
+        client.setConnectionParameter(QModbusDevice::NetworkPortParameter, server.serverPort());
+        client.setTimeout(5000);
+        client.setMaxInFlightRequests(1);
+
+        QVERIFY(client.connectDevice());
+        QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+        QTRY_VERIFY(server.hasPendingConnections());
+        QTcpSocket *peer = server.nextPendingConnection();
+        QVERIFY(peer);
+
+        const QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, 0, 1);
+        QScopedPointer<QModbusReply> first(client.sendReadRequest(unit, 1));
+        QScopedPointer<QModbusReply> deleted(client.sendReadRequest(unit, 2));
+        QScopedPointer<QModbusReply> last(client.sendReadRequest(unit, 3));
+        QVERIFY(first);
+        QVERIFY(deleted);
+        QVERIFY(last);
+
+        QByteArray buffer;
+        QList<ReceivedRequest> received;
+        const auto receive = [&]() {
+            buffer += peer->readAll();
+            received += takeRequests(&buffer);
+            return int(received.size());
+        };
+
+        QTRY_COMPARE(receive(), 1);
+        QCOMPARE(received.at(0).serverAddress, quint8(1));
+
+        // The deleted request is never sent, the one queued after it takes its place.
+        deleted.reset();
+        peer->write(response(received.at(0)));
+        QTRY_VERIFY(first->isFinished());
+        QTRY_COMPARE(receive(), 2);
+        QCOMPARE(received.at(1).serverAddress, quint8(3));
+        // transaction ids are assigned when a request is sent, not when it is queued
+        QCOMPARE(received.at(1).transactionId, quint16(received.at(0).transactionId + 1));
+
+        peer->write(response(received.at(1)));
+        QTRY_VERIFY(last->isFinished());
+        QCOMPARE(last->error(), QModbusDevice::NoError);
+        QTest::qWait(50);
+        QCOMPARE(receive(), 2);
+    }
+
+    void testResponseTimeout()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        QModbusTcpClient client;
+        client.setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                      server.serverAddress().toString());
+        client.setConnectionParameter(QModbusDevice::NetworkPortParameter, server.serverPort());
+        client.setTimeout(50);
+        client.setNumberOfRetries(1);
+
+        QVERIFY(client.connectDevice());
+        QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+        QTRY_VERIFY(server.hasPendingConnections());
+        QTcpSocket *peer = server.nextPendingConnection();
+        QVERIFY(peer);
+
+        const QModbusDataUnit unit(QModbusDataUnit::HoldingRegisters, 0, 1);
+        QScopedPointer<QModbusReply> unanswered(client.sendReadRequest(unit, 1));
+        QScopedPointer<QModbusReply> answered(client.sendReadRequest(unit, 2));
+        QVERIFY(unanswered);
+        QVERIFY(answered);
+
+        QByteArray buffer;
+        QList<ReceivedRequest> received;
+        const auto receive = [&]() {
+            buffer += peer->readAll();
+            received += takeRequests(&buffer);
+            return int(received.size());
+        };
+
+        QTRY_VERIFY(receive() >= 2);
+        peer->write(response(received.at(1)));
+        QTRY_VERIFY(answered->isFinished());
+        QCOMPARE(answered->error(), QModbusDevice::NoError);
+
+        // The unanswered request is sent once more and then times out.
+        QTRY_VERIFY(unanswered->isFinished());
+        QCOMPARE(unanswered->error(), QModbusDevice::TimeoutError);
+        QTRY_COMPARE(receive(), 3);
+        QCOMPARE(received.at(2).transactionId, received.at(0).transactionId);
+    }
+
+    void testResponseTimeoutInThread()
+    {
+        QTcpServer server;
+        QVERIFY(server.listen(QHostAddress::LocalHost));
+
+        QThread thread;
+        thread.start();
+        const auto cleanup = qScopeGuard([&thread]() {
+            thread.quit();
+            thread.wait();
+        });
+
+        // The response timeouts must run in the thread the client was moved to.
+        QModbusTcpClient client;
+        client.setConnectionParameter(QModbusDevice::NetworkAddressParameter,
+                                      server.serverAddress().toString());
+        client.setConnectionParameter(QModbusDevice::NetworkPortParameter, server.serverPort());
+        client.setTimeout(50);
+        client.setNumberOfRetries(0);
+        client.moveToThread(&thread);
+
+        QModbusReply *reply = nullptr;
+        QMetaObject::invokeMethod(&client, [&client]() {
+            client.connectDevice();
+        }, Qt::BlockingQueuedConnection);
+        QTRY_COMPARE(client.state(), QModbusDevice::ConnectedState);
+
+        QMetaObject::invokeMethod(&client, [&client, &reply]() {
+            reply = client.sendReadRequest(QModbusDataUnit(QModbusDataUnit::HoldingRegisters,
+                                                           0, 1), 1);
+        }, Qt::BlockingQueuedConnection);
+        QVERIFY(reply);
+
+        QTRY_VERIFY(reply->isFinished());
+        QCOMPARE(reply->error(), QModbusDevice::TimeoutError);
+
+        QMetaObject::invokeMethod(&client, [&client, reply]() {
+            delete reply;
+            client.disconnectDevice();
+            client.moveToThread(QCoreApplication::instance()->thread());
+        }, Qt::BlockingQueuedConnection);
+    }
+};
+
+QTEST_MAIN(tst_QModbusTcpClient)
+
+#include "tst_qmodbustcpclient.moc"
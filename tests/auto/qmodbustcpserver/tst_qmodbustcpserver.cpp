@@ -0,0 +1,185 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbustcpserver.h>
+
+#include <QtCore/qendian.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <QtTest/QtTest>
+
+class tst_QModbusTcpServer : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Builds a read holding registers request for the register at address 0.
+    static QByteArray readRequest(quint16 transactionId, quint8 unitId)
+    {
+        QByteArray adu(12, Qt::Uninitialized);
+        qToBigEndian<quint16>(transactionId, adu.data());
+        qToBigEndian<quint16>(0, adu.data() + 2);
+        qToBigEndian<quint16>(6, adu.data() + 4);
+        adu[6] = char(unitId);
+        adu[7] = char(QModbusPdu::ReadHoldingRegisters);
+        qToBigEndian<quint16>(0, adu.data() + 8);
+        qToBigEndian<quint16>(1, adu.data() + 10);
+        return adu;
+    }
+
+private slots:
+    void serverUnits()
+    {
+        QModbusTcpServer server;
+        QCOMPARE(server.serverAddress(), 0xff);
+        QCOMPARE(server.currentServerUnit(), 0xff);
+
+        QVERIFY(!server.addServerUnit(0xff));
+        QVERIFY(!server.addServerUnit(-1));
+        QVERIFY(!server.addServerUnit(256));
+        QVERIFY(server.addServerUnit(2));
+        QVERIFY(server.addServerUnit(1));
+        QVERIFY(!server.addServerUnit(1));
+        QCOMPARE(server.serverUnits(), QList<int>({ 1, 2 }));
+
+        QVERIFY(server.setMap({ { QModbusDataUnit::HoldingRegisters,
+                                  { QModbusDataUnit::HoldingRegisters, 0, 4 } } }));
+        QVERIFY(server.setData(QModbusDataUnit::HoldingRegisters, 0, 0xff));
+
+        // every unit has its own registers and options
+        QVERIFY(!server.setCurrentServerUnit(3));
+        QCOMPARE(server.currentServerUnit(), 0xff);
+        QVERIFY(server.setCurrentServerUnit(1));
+        QCOMPARE(server.currentServerUnit(), 1);
+        quint16 data = 0;
+        QVERIFY(!server.data(QModbusDataUnit::HoldingRegisters, 0, &data));
+        QVERIFY(server.setMap({ { QModbusDataUnit::HoldingRegisters,
+                                  { QModbusDataUnit::HoldingRegisters, 0, 4 } } }));
+        QVERIFY(server.setData(QModbusDataUnit::HoldingRegisters, 0, 0x01));
+        QVERIFY(server.setValue(QModbusServer::DeviceBusy, 0xffff));
+
+        QVERIFY(server.setCurrentServerUnit(0xff));
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 0, &data));
+        QCOMPARE(data, 0xff);
+        QCOMPARE(server.value(QModbusServer::DeviceBusy).value<quint16>(), 0x0000);
+
+        QVERIFY(server.setCurrentServerUnit(1));
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 0, &data));
+        QCOMPARE(data, 0x01);
+        QCOMPARE(server.value(QModbusServer::DeviceBusy).value<quint16>(), 0xffff);
+
+        // removing the current unit falls back to the server address
+        QVERIFY(server.removeServerUnit(1));
+        QVERIFY(!server.removeServerUnit(1));
+        QCOMPARE(server.currentServerUnit(), 0xff);
+        QCOMPARE(server.serverUnits(), QList<int>({ 2 }));
+        QVERIFY(!server.setCurrentServerUnit(1));
+    }
+
+    void dispatchByUnitId()
+    {
+        QModbusTcpServer server;
+        server.setServerAddress(1);
+        QVERIFY(server.addServerUnit(2));
+        QVERIFY(server.addServerUnit(3));
+        for (int unitId : { 1, 2, 3 }) {
+            QVERIFY(server.setCurrentServerUnit(unitId));
+            QVERIFY(server.setMap({ { QModbusDataUnit::HoldingRegisters,
+                                      { QModbusDataUnit::HoldingRegisters, 0, 1 } } }));
+            QVERIFY(server.setData(QModbusDataUnit::HoldingRegisters, 0, quint16(unitId)));
+        }
+        QVERIFY(server.setValue(QModbusServer::DeviceBusy, 0xffff));
+        QVERIFY(server.setCurrentServerUnit(1));
+
+        int dataWrittenUnit = -1;
+        connect(&server, &QModbusServer::dataWritten, this, [&server, &dataWrittenUnit]() {
+            dataWrittenUnit = server.currentServerUnit();
+        });
+
+        // QModbusTcpServer does not report the port it listens on, so look for a free one first.
+        QTcpServer probe;
+        QVERIFY(probe.listen(QHostAddress::LocalHost));
+        const quint16 port = probe.serverPort();
+        probe.close();
+        server.setConnectionParameter(QModbusDevice::NetworkAddressParameter, "127.0.0.1");
+        server.setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+        QVERIFY(server.connectDevice());
+
+        QTcpSocket socket;
+        socket.connectToHost(QHostAddress::LocalHost, port);
+        QVERIFY(socket.waitForConnected());
+
+        // The request to unit 4 is dropped, unit 3 is busy.
+        socket.write(readRequest(1, 1) + readRequest(2, 4) + readRequest(3, 2)
+                     + readRequest(4, 3));
+        QByteArray expected = QByteArray::fromHex("000100000005010302" "0001")
+            + QByteArray::fromHex("000300000005020302" "0002")
+            + QByteArray::fromHex("000400000003038306");
+        QByteArray received;
+        QTRY_VERIFY((received += socket.readAll()).size() >= expected.size());
+        QCOMPARE(received, expected);
+
+        // writes end up in the addressed unit only
+        QByteArray write(12, Qt::Uninitialized);
+        qToBigEndian<quint16>(5, write.data());
+        qToBigEndian<quint16>(0, write.data() + 2);
+        qToBigEndian<quint16>(6, write.data() + 4);
+        write[6] = 2;
+        write[7] = char(QModbusPdu::WriteSingleRegister);
+        qToBigEndian<quint16>(0, write.data() + 8);
+        qToBigEndian<quint16>(0x1234, write.data() + 10);
+        socket.write(write);
+        received.clear();
+        QTRY_VERIFY((received += socket.readAll()).size() >= write.size());
+        QCOMPARE(received, write);
+        QCOMPARE(dataWrittenUnit, 2);
+        QCOMPARE(server.currentServerUnit(), 1);
+
+        quint16 data = 0;
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 0, &data));
+        QCOMPARE(data, 0x0001);
+        QVERIFY(server.setCurrentServerUnit(2));
+        QVERIFY(server.data(QModbusDataUnit::HoldingRegisters, 0, &data));
+        QCOMPARE(data, 0x1234);
+
+        server.disconnectDevice();
+    }
+};
+
+QTEST_MAIN(tst_QModbusTcpServer)
+
+#include "tst_qmodbustcpserver.moc"
@@ -0,0 +1,154 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qcanbus.h>
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtTest/qtest.h>
+
+#include <memory>
+
+// Runs against a SocketCAN interface, by default vcan0. Another interface can
+// be selected with the QT_CANBUS_TEST_INTERFACE environment variable:
+//
+//   ip link add dev vcan0 type vcan && ip link set up vcan0
+
+class tst_SocketCanBackend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void payloadFilter();
+
+private:
+    QString m_interface;
+};
+
+void tst_SocketCanBackend::initTestCase()
+{
+    m_interface = qEnvironmentVariable("QT_CANBUS_TEST_INTERFACE", QStringLiteral("vcan0"));
+
+    if (!QCanBus::instance()->plugins().contains(QStringLiteral("socketcan")))
+        QSKIP("The SocketCAN plugin is not available.");
+
+    std::unique_ptr<QCanBusDevice> probe(
+            QCanBus::instance()->createDevice(QStringLiteral("socketcan"), m_interface));
+    if (!probe || !probe->connectDevice())
+        QSKIP("The CAN interface is not available.");
+    probe->disconnectDevice();
+}
+
+void tst_SocketCanBackend::payloadFilter()
+{
+    using PayloadFilter = QCanBusDevice::PayloadFilter;
+
+    // J1939 TP.CM frames that announce the parameter group 0xFECA (DM1)
+    PayloadFilter dm1;
+    dm1.filter.frameId = 0x00ec0000;
+    dm1.filter.frameIdMask = 0x00ff0000;
+    dm1.filter.format = QCanBusDevice::Filter::MatchExtendedFormat;
+    dm1.payload = QByteArray::fromHex("0000000000cafe00");
+    dm1.payloadMask = QByteArray::fromHex("0000000000ffffff");
+
+    // base frame 0x123 with 0x5? in its second byte
+    PayloadFilter nibble;
+    nibble.filter.frameId = 0x123;
+    nibble.filter.frameIdMask = 0x7ff;
+    nibble.filter.type = QCanBusFrame::DataFrame;
+    nibble.filter.format = QCanBusDevice::Filter::MatchBaseFormat;
+    nibble.payload = QByteArray::fromHex("0050");
+    nibble.payloadMask = QByteArray::fromHex("00f0");
+
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> sender(
+            QCanBus::instance()->createDevice(QStringLiteral("socketcan"), m_interface,
+                                              &errorString));
+    QVERIFY2(sender, qPrintable(errorString));
+    std::unique_ptr<QCanBusDevice> receiver(
+            QCanBus::instance()->createDevice(QStringLiteral("socketcan"), m_interface,
+                                              &errorString));
+    QVERIFY2(receiver, qPrintable(errorString));
+    receiver->setConfigurationParameter(QCanBusDevice::PayloadFilterKey,
+                                        QVariant::fromValue(QList<PayloadFilter>{ dm1, nibble }));
+    QCOMPARE(receiver->error(), QCanBusDevice::NoError);
+    QVERIFY(sender->connectDevice());
+    QVERIFY(receiver->connectDevice());
+
+    auto frame = [](QCanBusFrame::FrameId id, bool extended, const char *hexPayload) {
+        QCanBusFrame frame(id, QByteArray::fromHex(hexPayload));
+        frame.setExtendedFrameFormat(extended);
+        return frame;
+    };
+    const QList<QCanBusFrame> frames = {
+        frame(0x18ecff00, true, "200e0002ffcafe00"),    // accepted
+        frame(0x18ecff00, true, "200e0002ffcbfe00"),    // other parameter group
+        frame(0x18ebff00, true, "200e0002ffcafe00"),    // other PDU format
+        frame(0x123, false, "005a"),                    // accepted
+        frame(0x123, false, "00"),                      // payload too short
+        frame(0x123, false, "0065"),
+        frame(0x123, true, "0055"),                     // extended format
+        frame(0x123, false, "005f"),                    // accepted, sent last
+    };
+    for (const QCanBusFrame &f : frames)
+        QVERIFY(sender->writeFrame(f));
+
+    QList<QCanBusFrame> received;
+    auto receive = [&received, &receiver]() {
+        received += receiver->readAllFrames();
+        return received.size();
+    };
+    QTRY_COMPARE(receive(), 3);
+    QCOMPARE(received.at(0).frameId(), 0x18ecff00u);
+    QCOMPARE(received.at(1).payload(), QByteArray::fromHex("005a"));
+    QCOMPARE(received.at(2).payload(), QByteArray::fromHex("005f"));
+
+    // unsetting the key detaches the program
+    received.clear();
+    receiver->setConfigurationParameter(QCanBusDevice::PayloadFilterKey, QVariant());
+    QCOMPARE(receiver->error(), QCanBusDevice::NoError);
+    QVERIFY(sender->writeFrame(frames.at(4)));
+    QTRY_COMPARE(receive(), 1);
+    QCOMPARE(received.at(0).payload(), QByteArray::fromHex("00"));
+
+    receiver->disconnectDevice();
+    sender->disconnectDevice();
+}
+
+QTEST_MAIN(tst_SocketCanBackend)
+
+#include "tst_socketcanbackend.moc"
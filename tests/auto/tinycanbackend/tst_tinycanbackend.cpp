@@ -0,0 +1,255 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qcanbus.h>
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qlibrary.h>
+#include <QtTest/qtest.h>
+
+#include <memory>
+#include <vector>
+
+// Layout of the driver's TCanMsg, see tests/auto/plugins/mhstcan
+#pragma pack(push, 1)
+struct StubCanMsg
+{
+    quint32 id;
+    quint32 flags;
+    quint8 data[8];
+    quint32 sec;
+    quint32 usec;
+};
+#pragma pack(pop)
+
+typedef void (*StubCanResetFunction)();
+typedef void (*StubCanInjectReceiveFunction)(quint32 index, const StubCanMsg *msg, qint32 count);
+typedef qint32 (*StubCanReceiveCallsFunction)();
+typedef void (*StubCanSetTransmitFifoSizeFunction)(qint32 size);
+typedef qint32 (*StubCanTransmitCallsFunction)();
+typedef qint32 (*StubCanTakeTransmittedFunction)(quint32 index, StubCanMsg *msg, qint32 count);
+
+class tst_TinyCanBackend : public QObject
+{
+    Q_OBJECT
+public:
+    tst_TinyCanBackend() = default;
+
+private slots:
+    void initTestCase();
+    void init();
+    void batchedReceive();
+    void batchedTransmit();
+    void partialTransmit();
+
+private:
+    QList<quint32> takeTransmittedIds(int maxCount);
+
+    QLibrary stub;
+    StubCanResetFunction reset = nullptr;
+    StubCanInjectReceiveFunction injectReceive = nullptr;
+    StubCanReceiveCallsFunction receiveCalls = nullptr;
+    StubCanSetTransmitFifoSizeFunction setTransmitFifoSize = nullptr;
+    StubCanTransmitCallsFunction transmitCalls = nullptr;
+    StubCanTakeTransmittedFunction takeTransmitted = nullptr;
+};
+
+void tst_TinyCanBackend::initTestCase()
+{
+    // Load the stub first, so that the plugin's lookup of "mhstcan" resolves to it
+    stub.setFileName(QStringLiteral(MHSTCAN_STUB_PATH));
+    QVERIFY2(stub.load(), qPrintable(stub.errorString()));
+
+    reset = reinterpret_cast<StubCanResetFunction>(stub.resolve("StubCanReset"));
+    injectReceive = reinterpret_cast<StubCanInjectReceiveFunction>(
+                stub.resolve("StubCanInjectReceive"));
+    receiveCalls = reinterpret_cast<StubCanReceiveCallsFunction>(
+                stub.resolve("StubCanReceiveCalls"));
+    setTransmitFifoSize = reinterpret_cast<StubCanSetTransmitFifoSizeFunction>(
+                stub.resolve("StubCanSetTransmitFifoSize"));
+    transmitCalls = reinterpret_cast<StubCanTransmitCallsFunction>(
+                stub.resolve("StubCanTransmitCalls"));
+    takeTransmitted = reinterpret_cast<StubCanTakeTransmittedFunction>(
+                stub.resolve("StubCanTakeTransmitted"));
+    QVERIFY(reset && injectReceive && receiveCalls);
+    QVERIFY(setTransmitFifoSize && transmitCalls && takeTransmitted);
+
+    if (!QCanBus::instance()->plugins().contains(QStringLiteral("tinycan")))
+        QSKIP("The tinycan plugin is not available.");
+}
+
+void tst_TinyCanBackend::init()
+{
+    reset();
+}
+
+QList<quint32> tst_TinyCanBackend::takeTransmittedIds(int maxCount)
+{
+    std::vector<StubCanMsg> messages(maxCount);
+    const qint32 count = takeTransmitted(0, messages.data(), maxCount);
+
+    QList<quint32> ids;
+    for (qint32 i = 0; i < count; ++i)
+        ids.append(messages[i].id);
+    return ids;
+}
+
+void tst_TinyCanBackend::batchedReceive()
+{
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(
+            QCanBus::instance()->createDevice(QStringLiteral("tinycan"), QStringLiteral("can0.0"),
+                                              &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(device->connectDevice());
+
+    const qint32 callsBefore = receiveCalls();
+
+    constexpr int messageCount = 100;
+    std::vector<StubCanMsg> messages(messageCount);
+    for (int i = 0; i < messageCount; ++i) {
+        StubCanMsg &msg = messages[i];
+        msg = {};
+        msg.id = quint32(0x100 + i);
+        msg.flags = 2; // Len = 2
+        msg.data[0] = quint8(i);
+        msg.data[1] = quint8(i >> 8);
+        msg.sec = 1;
+        msg.usec = quint32(i);
+    }
+    injectReceive(0, messages.data(), messageCount); // INDEX_CAN_KANAL_A
+
+    QTRY_COMPARE(device->framesAvailable(), qint64(messageCount));
+    // One call for a full batch and one for the rest, not one per frame
+    QVERIFY2(receiveCalls() - callsBefore <= 2,
+             qPrintable(QString::number(receiveCalls() - callsBefore)));
+
+    const QList<QCanBusFrame> frames = device->readAllFrames();
+    QCOMPARE(frames.size(), messageCount);
+    for (int i = 0; i < messageCount; ++i) {
+        const QCanBusFrame &frame = frames.at(i);
+        QCOMPARE(frame.frameId(), QCanBusFrame::FrameId(0x100 + i));
+        const char payload[] = { char(i), char(i >> 8) };
+        QCOMPARE(frame.payload(), QByteArray(payload, sizeof(payload)));
+        QCOMPARE(frame.timeStamp().microSeconds(), qint64(i));
+    }
+
+    device->disconnectDevice();
+}
+
+void tst_TinyCanBackend::batchedTransmit()
+{
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(
+            QCanBus::instance()->createDevice(QStringLiteral("tinycan"), QStringLiteral("can0.0"),
+                                              &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(device->connectDevice());
+
+    qint64 framesWritten = 0;
+    connect(device.get(), &QCanBusDevice::framesWritten,
+            [&framesWritten](qint64 count) { framesWritten += count; });
+
+    // More frames than fit into the driver's TX FIFO of 255 messages
+    constexpr int frameCount = 300;
+    QList<quint32> expectedIds;
+    for (int i = 0; i < frameCount; ++i) {
+        QVERIFY(device->writeFrame(QCanBusFrame(quint32(0x200 + i), QByteArray(1, char(i)))));
+        expectedIds.append(quint32(0x200 + i));
+    }
+    QCOMPARE(device->framesToWrite(), qint64(frameCount));
+    QCOMPARE(device->framesToWriteHighWaterMark(), qint64(frameCount));
+
+    // The FIFO is filled in batches of 64 within one event loop turn
+    QTRY_COMPARE(framesWritten, qint64(255));
+    QCOMPARE(device->framesToWrite(), qint64(frameCount - 255));
+    QCOMPARE(transmitCalls(), 4);
+
+    QList<quint32> ids = takeTransmittedIds(frameCount);
+    QCOMPARE(ids.size(), 255);
+
+    QTRY_COMPARE(framesWritten, qint64(frameCount));
+    QCOMPARE(device->framesToWrite(), qint64(0));
+    QCOMPARE(transmitCalls(), 5);
+
+    ids += takeTransmittedIds(frameCount);
+    QCOMPARE(ids, expectedIds);
+
+    QCOMPARE(device->framesToWriteHighWaterMark(), qint64(frameCount));
+    device->resetFramesToWriteHighWaterMark();
+    QCOMPARE(device->framesToWriteHighWaterMark(), qint64(0));
+
+    device->disconnectDevice();
+}
+
+void tst_TinyCanBackend::partialTransmit()
+{
+    // The driver accepts only part of a batch, the rest must stay queued in order
+    setTransmitFifoSize(100);
+
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(
+            QCanBus::instance()->createDevice(QStringLiteral("tinycan"), QStringLiteral("can0.0"),
+                                              &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(device->connectDevice());
+
+    qint64 framesWritten = 0;
+    connect(device.get(), &QCanBusDevice::framesWritten,
+            [&framesWritten](qint64 count) { framesWritten += count; });
+
+    constexpr int frameCount = 150;
+    QList<quint32> expectedIds;
+    for (int i = 0; i < frameCount; ++i) {
+        QVERIFY(device->writeFrame(QCanBusFrame(quint32(0x300 + i), QByteArray())));
+        expectedIds.append(quint32(0x300 + i));
+    }
+
+    QTRY_COMPARE(framesWritten, qint64(100));
+    QCOMPARE(device->framesToWrite(), qint64(frameCount - 100));
+
+    QList<quint32> ids = takeTransmittedIds(frameCount);
+    QTRY_COMPARE(framesWritten, qint64(frameCount));
+    ids += takeTransmittedIds(frameCount);
+    QCOMPARE(ids, expectedIds);
+
+    device->disconnectDevice();
+}
+
+QTEST_MAIN(tst_TinyCanBackend)
+
+#include "tst_tinycanbackend.moc"
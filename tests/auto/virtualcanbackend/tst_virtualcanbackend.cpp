@@ -0,0 +1,355 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtSerialBus/qcanbus.h>
+#include <QtSerialBus/qcanbusdevice.h>
+#include <QtSerialBus/qcanbusframe.h>
+
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qendian.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+#include <QtTest/qtest.h>
+
+#include <memory>
+
+// Talks to the virtual CAN plugin through a fake server that speaks the raw
+// protocol, and through the plugin's own server on a free local port.
+
+class tst_VirtualCanBackend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void textProtocolFallback();
+    void binaryProtocol();
+    void binaryRecordSplit();
+    void malformedBinaryRecord();
+    void mixedClients();
+
+private:
+    enum : quint8 {
+        ExtendedFormat = 0x02,
+        FlexibleDataRate = 0x04,
+        BitRateSwitch = 0x08,
+        ErrorState = 0x10
+    };
+
+    struct Peer
+    {
+        QTcpServer server;
+        QTcpSocket *socket = nullptr;
+    };
+
+    bool connectPeer(Peer *peer, QCanBusDevice *device);
+    static QByteArray readLine(QTcpSocket *socket);
+    static QByteArray read(QTcpSocket *socket, qsizetype size);
+    static QByteArray binaryRecord(quint8 flags, quint32 frameId, qint64 timeStamp,
+                                   const QByteArray &payload);
+};
+
+// Connects the device to the fake server of peer and reads its greeting.
+bool tst_VirtualCanBackend::connectPeer(Peer *peer, QCanBusDevice *device)
+{
+    if (!device->connectDevice())
+        return false;
+
+    QDeadlineTimer deadline(5000);
+    while (!peer->server.hasPendingConnections() && !deadline.hasExpired())
+        QTest::qWait(10);
+    peer->socket = peer->server.nextPendingConnection();
+    return peer->socket && readLine(peer->socket) == "connect:can0\n"
+            && readLine(peer->socket) == "protocol:binary\n";
+}
+
+QByteArray tst_VirtualCanBackend::readLine(QTcpSocket *socket)
+{
+    QDeadlineTimer deadline(5000);
+    while (!socket->canReadLine() && !deadline.hasExpired())
+        QTest::qWait(10);
+    return socket->readLine();
+}
+
+QByteArray tst_VirtualCanBackend::read(QTcpSocket *socket, qsizetype size)
+{
+    QDeadlineTimer deadline(5000);
+    while (socket->bytesAvailable() < size && !deadline.hasExpired())
+        QTest::qWait(10);
+    return socket->read(size);
+}
+
+QByteArray tst_VirtualCanBackend::binaryRecord(quint8 flags, quint32 frameId, qint64 timeStamp,
+                                               const QByteArray &payload)
+{
+    QByteArray record(16, Qt::Uninitialized);
+    qToLittleEndian<quint16>(quint16(14 + payload.size()), record.data());
+    record[2] = 0; // can0
+    record[3] = char(flags);
+    qToLittleEndian<quint32>(frameId, record.data() + 4);
+    qToLittleEndian<qint64>(timeStamp, record.data() + 8);
+    return record + payload;
+}
+
+void tst_VirtualCanBackend::initTestCase()
+{
+    if (!QCanBus::instance()->plugins().contains(QStringLiteral("virtualcan")))
+        QSKIP("The virtual CAN plugin is not available.");
+}
+
+void tst_VirtualCanBackend::textProtocolFallback()
+{
+    Peer peer;
+    QVERIFY(peer.server.listen(QHostAddress::LocalHost));
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(QCanBus::instance()->createDevice(
+            QStringLiteral("virtualcan"),
+            QStringLiteral("tcp://127.0.0.1:%1/can0").arg(peer.server.serverPort()),
+            &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(connectPeer(&peer, device.get()));
+    QTRY_COMPARE(device->state(), QCanBusDevice::ConnectedState);
+
+    // a server without the binary protocol ignores the request
+    peer.socket->write("291#X#0102\n");
+    QTRY_COMPARE(device->framesAvailable(), 1);
+    const QCanBusFrame received = device->readFrame();
+    QCOMPARE(received.frameId(), 291u);
+    QVERIFY(received.hasExtendedFrameFormat());
+    QCOMPARE(received.payload(), QByteArray::fromHex("0102"));
+
+    QCanBusFrame frame(0x123, QByteArray::fromHex("a1b2"));
+    QVERIFY(device->writeFrame(frame));
+    QCOMPARE(readLine(peer.socket), QByteArray("can0:291##a1b2\n"));
+
+    // malformed lines are skipped
+    peer.socket->write("12#X#0\nx#y\n7##ff\n");
+    QTRY_COMPARE(device->framesAvailable(), 1);
+    QCOMPARE(device->readFrame().frameId(), 7u);
+}
+
+void tst_VirtualCanBackend::binaryProtocol()
+{
+    Peer peer;
+    QVERIFY(peer.server.listen(QHostAddress::LocalHost));
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(QCanBus::instance()->createDevice(
+            QStringLiteral("virtualcan"),
+            QStringLiteral("tcp://127.0.0.1:%1/can0").arg(peer.server.serverPort()),
+            &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    device->setConfigurationParameter(QCanBusDevice::CanFdKey, true);
+    QVERIFY(connectPeer(&peer, device.get()));
+    QTRY_COMPARE(device->state(), QCanBusDevice::ConnectedState);
+
+    // the answer switches both directions to binary records
+    peer.socket->write("protocol:binary\n");
+    QCOMPARE(readLine(peer.socket), QByteArray("protocol:start\n"));
+
+    // classic frame from the device
+    QVERIFY(device->writeFrame(QCanBusFrame(0x123, QByteArray::fromHex("0102030405060708"))));
+    QByteArray record = read(peer.socket, 24);
+    QCOMPARE(record.size(), 24);
+    QCOMPARE(qFromLittleEndian<quint16>(record.constData()), quint16(22));
+    QCOMPARE(record.at(2), char(0));
+    QCOMPARE(record.at(3), char(0));
+    QCOMPARE(qFromLittleEndian<quint32>(record.constData() + 4), 0x123u);
+    QCOMPARE(record.mid(16), QByteArray::fromHex("0102030405060708"));
+
+    // CAN FD frame from the device
+    QByteArray fdPayload(64, Qt::Uninitialized);
+    for (int i = 0; i < fdPayload.size(); ++i)
+        fdPayload[i] = char(255 - i);
+    QCanBusFrame fd(0x18daf110, fdPayload);
+    fd.setExtendedFrameFormat(true);
+    fd.setBitrateSwitch(true);
+    fd.setErrorStateIndicator(true);
+    QVERIFY(device->writeFrame(fd));
+    record = read(peer.socket, 16 + 64);
+    QCOMPARE(record.size(), 16 + 64);
+    QCOMPARE(qFromLittleEndian<quint16>(record.constData()), quint16(14 + 64));
+    QCOMPARE(quint8(record.at(3)),
+             quint8(ExtendedFormat | FlexibleDataRate | BitRateSwitch | ErrorState));
+    QCOMPARE(qFromLittleEndian<quint32>(record.constData() + 4), 0x18daf110u);
+    QCOMPARE(record.mid(16), fdPayload);
+
+    // classic and CAN FD frames to the device, in one write
+    peer.socket->write(binaryRecord(0, 0x7ff, 1000000001, QByteArray::fromHex("ff00"))
+                       + binaryRecord(ExtendedFormat | FlexibleDataRate | BitRateSwitch,
+                                      0x1abcdef0, 2000000002, fdPayload));
+    QTRY_COMPARE(device->framesAvailable(), 2);
+
+    QCanBusFrame received = device->readFrame();
+    QCOMPARE(received.frameId(), 0x7ffu);
+    QVERIFY(!received.hasExtendedFrameFormat());
+    QVERIFY(!received.hasFlexibleDataRateFormat());
+    QCOMPARE(received.payload(), QByteArray::fromHex("ff00"));
+    QCOMPARE(received.timeStampNanoSeconds(), Q_INT64_C(1000000001));
+
+    received = device->readFrame();
+    QCOMPARE(received.frameId(), 0x1abcdef0u);
+    QVERIFY(received.hasExtendedFrameFormat());
+    QVERIFY(received.hasFlexibleDataRateFormat());
+    QVERIFY(received.hasBitrateSwitch());
+    QVERIFY(!received.hasErrorStateIndicator());
+    QCOMPARE(received.payload(), fdPayload);
+    QCOMPARE(received.timeStampNanoSeconds(), Q_INT64_C(2000000002));
+}
+
+void tst_VirtualCanBackend::binaryRecordSplit()
+{
+    Peer peer;
+    QVERIFY(peer.server.listen(QHostAddress::LocalHost));
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(QCanBus::instance()->createDevice(
+            QStringLiteral("virtualcan"),
+            QStringLiteral("tcp://127.0.0.1:%1/can0").arg(peer.server.serverPort()),
+            &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(connectPeer(&peer, device.get()));
+    QTRY_COMPARE(device->state(), QCanBusDevice::ConnectedState);
+
+    // the first record follows the answer in the same packet
+    const QByteArray record = binaryRecord(0, 0x42, 0, QByteArray::fromHex("0a0b0c"));
+    peer.socket->write("protocol:binary\n" + record.first(1));
+    QCOMPARE(readLine(peer.socket), QByteArray("protocol:start\n"));
+
+    // incomplete records are kept until the rest arrives
+    for (qsizetype i = 1; i < record.size() - 1; ++i) {
+        peer.socket->write(record.mid(i, 1));
+        QTest::qWait(5);
+        QCOMPARE(device->framesAvailable(), 0);
+    }
+    peer.socket->write(record.last(1));
+    QTRY_COMPARE(device->framesAvailable(), 1);
+    const QCanBusFrame received = device->readFrame();
+    QCOMPARE(received.frameId(), 0x42u);
+    QCOMPARE(received.payload(), QByteArray::fromHex("0a0b0c"));
+    QCOMPARE(device->error(), QCanBusDevice::NoError);
+}
+
+void tst_VirtualCanBackend::malformedBinaryRecord()
+{
+    Peer peer;
+    QVERIFY(peer.server.listen(QHostAddress::LocalHost));
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> device(QCanBus::instance()->createDevice(
+            QStringLiteral("virtualcan"),
+            QStringLiteral("tcp://127.0.0.1:%1/can0").arg(peer.server.serverPort()),
+            &errorString));
+    QVERIFY2(device, qPrintable(errorString));
+    QVERIFY(connectPeer(&peer, device.get()));
+    QTRY_COMPARE(device->state(), QCanBusDevice::ConnectedState);
+
+    peer.socket->write("protocol:binary\n");
+    QCOMPARE(readLine(peer.socket), QByteArray("protocol:start\n"));
+
+    // a record shorter than its header, followed by a valid one
+    QByteArray malformed(2, Qt::Uninitialized);
+    qToLittleEndian<quint16>(3, malformed.data());
+    peer.socket->write(malformed + QByteArray(3, '\0')
+                       + binaryRecord(0, 0x1, 0, QByteArray::fromHex("01")));
+
+    QTRY_COMPARE(device->error(), QCanBusDevice::ReadError);
+    QTRY_COMPARE(device->state(), QCanBusDevice::UnconnectedState);
+    QCOMPARE(device->framesAvailable(), 0);
+}
+
+void tst_VirtualCanBackend::mixedClients()
+{
+    // start the plugin's server on a free port
+    quint16 port = 0;
+    {
+        QTcpServer probe;
+        QVERIFY(probe.listen(QHostAddress::LocalHost));
+        port = probe.serverPort();
+    }
+
+    const QString interfaceName = QStringLiteral("tcp://127.0.0.1:%1/can0").arg(port);
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> binary(
+            QCanBus::instance()->createDevice(QStringLiteral("virtualcan"), interfaceName,
+                                              &errorString));
+    QVERIFY2(binary, qPrintable(errorString));
+    std::unique_ptr<QCanBusDevice> otherBinary(
+            QCanBus::instance()->createDevice(QStringLiteral("virtualcan"), interfaceName,
+                                              &errorString));
+    QVERIFY2(otherBinary, qPrintable(errorString));
+    QVERIFY(binary->connectDevice());
+    QTRY_COMPARE(binary->state(), QCanBusDevice::ConnectedState);
+    QVERIFY(otherBinary->connectDevice());
+    QTRY_COMPARE(otherBinary->state(), QCanBusDevice::ConnectedState);
+
+    // a round trip in both directions makes sure both clients are registered
+    QVERIFY(binary->writeFrame(QCanBusFrame(0x1, QByteArray::fromHex("01"))));
+    QTRY_COMPARE(otherBinary->framesAvailable(), 1);
+    QVERIFY(otherBinary->writeFrame(QCanBusFrame(0x2, QByteArray::fromHex("02"))));
+    QTRY_COMPARE(binary->framesAvailable(), 1);
+    QCOMPARE(otherBinary->readFrame().frameId(), 0x1u);
+    QCOMPARE(binary->readFrame().frameId(), 0x2u);
+
+    // a client of an older Qt version that only speaks the text protocol
+    QTcpSocket text;
+    text.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(text.waitForConnected(5000));
+    text.write("connect:can0\n");
+    text.write("can0:291#X#0102\n");
+
+    QTRY_COMPARE(binary->framesAvailable(), 1);
+    QTRY_COMPARE(otherBinary->framesAvailable(), 1);
+    for (QCanBusDevice *device : { binary.get(), otherBinary.get() }) {
+        const QCanBusFrame received = device->readFrame();
+        QCOMPARE(received.frameId(), 291u);
+        QVERIFY(received.hasExtendedFrameFormat());
+        QCOMPARE(received.payload(), QByteArray::fromHex("0102"));
+    }
+
+    // both protocols receive the frames of a binary client
+    QVERIFY(binary->writeFrame(QCanBusFrame(0x123, QByteArray::fromHex("c0ffee"))));
+    QCOMPARE(readLine(&text), QByteArray("291##c0ffee\n"));
+    QTRY_COMPARE(otherBinary->framesAvailable(), 1);
+    const QCanBusFrame received = otherBinary->readFrame();
+    QCOMPARE(received.frameId(), 0x123u);
+    QCOMPARE(received.payload(), QByteArray::fromHex("c0ffee"));
+
+    binary->disconnectDevice();
+    otherBinary->disconnectDevice();
+}
+
+QTEST_MAIN(tst_VirtualCanBackend)
+
+#include "tst_virtualcanbackend.moc"
@@ -0,0 +1,147 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qcanbus.h>
+#include <QtSerialBus/qcanbusdevice.h>
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qdeadlinetimer.h>
+
+#include <QtTest/QtTest>
+
+#include <atomic>
+#include <memory>
+
+// Measures the latency from writing a frame with one SocketCAN device until
+// it is delivered by a second device on the same interface. The interface
+// defaults to vcan0 and can be changed with the QT_CANBUS_BENCH_INTERFACE
+// environment variable:
+//
+//   ip link add dev vcan0 type vcan && ip link set up vcan0
+
+enum class Delivery {
+    Signal,
+    FrameHandler,
+    FrameHandlerIoThread
+};
+Q_DECLARE_METATYPE(Delivery)
+
+class tst_Bench_QCanBusDevice : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip_data();
+    void roundTrip();
+
+private:
+    QString m_interface;
+};
+
+void tst_Bench_QCanBusDevice::initTestCase()
+{
+    m_interface = qEnvironmentVariable("QT_CANBUS_BENCH_INTERFACE", QStringLiteral("vcan0"));
+
+    if (!QCanBus::instance()->plugins().contains(QStringLiteral("socketcan")))
+        QSKIP("The SocketCAN plugin is not available.");
+
+    std::unique_ptr<QCanBusDevice> probe(
+            QCanBus::instance()->createDevice(QStringLiteral("socketcan"), m_interface));
+    if (!probe || !probe->connectDevice())
+        QSKIP("The CAN interface is not available.");
+    probe->disconnectDevice();
+}
+
+void tst_Bench_QCanBusDevice::roundTrip_data()
+{
+    QTest::addColumn<Delivery>("delivery");
+
+    QTest::newRow("framesReceived() signal") << Delivery::Signal;
+    QTest::newRow("frame handler") << Delivery::FrameHandler;
+    QTest::newRow("frame handler, I/O thread") << Delivery::FrameHandlerIoThread;
+}
+
+void tst_Bench_QCanBusDevice::roundTrip()
+{
+    QFETCH(Delivery, delivery);
+
+    QString errorString;
+    std::unique_ptr<QCanBusDevice> writer(
+            QCanBus::instance()->createDevice(QStringLiteral("socketcan"), m_interface,
+                                              &errorString));
+    QVERIFY2(writer, qPrintable(errorString));
+    std::unique_ptr<QCanBusDevice> reader(
+            QCanBus::instance()->createDevice(QStringLiteral("socketcan"), m_interface,
+                                              &errorString));
+    QVERIFY2(reader, qPrintable(errorString));
+
+    std::atomic<int> received(0);
+    if (delivery == Delivery::Signal) {
+        connect(reader.get(), &QCanBusDevice::framesReceived, this, [&reader, &received]() {
+            received += int(reader->readAllFrames().size());
+        });
+    } else {
+        reader->setIoThreadEnabled(delivery == Delivery::FrameHandlerIoThread);
+        reader->setFrameHandler([&received](const QCanBusFrame *, qsizetype count) {
+            received += int(count);
+        });
+    }
+
+    QVERIFY(writer->connectDevice());
+    QVERIFY(reader->connectDevice());
+
+    const QCanBusFrame frame(0x123, QByteArray::fromHex("0011223344556677"));
+    int expected = 0;
+
+    QBENCHMARK {
+        QVERIFY(writer->writeFrame(frame));
+        ++expected;
+
+        const QDeadlineTimer deadline(5000);
+        while (received.load() < expected) {
+            QCoreApplication::processEvents();
+            QVERIFY2(!deadline.hasExpired(), "Timeout while waiting for the frame.");
+        }
+    }
+
+    reader->disconnectDevice();
+    writer->disconnectDevice();
+}
+
+QTEST_MAIN(tst_Bench_QCanBusDevice)
+
+#include "tst_bench_qcanbusdevice.moc"
@@ -0,0 +1,148 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <private/qmodbusadu_p.h>
+
+#include <QtTest/QtTest>
+
+// The bit-by-bit implementation used before the table driven CRC, as reference
+static quint16 crcReflect(quint16 data, qint32 len)
+{
+    quint16 ret = data & 0x01;
+    for (qint32 i = 1; i < len; i++) {
+        data >>= 1;
+        ret = (ret << 1) | (data & 0x01);
+    }
+    return ret;
+}
+
+static quint16 bitwiseCRC(const char *data, qint32 len)
+{
+    // Generated by pycrc v0.8.3, https://pycrc.org
+    // Width = 16, Poly = 0x8005, XorIn = 0xffff, ReflectIn = True,
+    // XorOut = 0x0000, ReflectOut = True, Algorithm = bit-by-bit-fast
+
+    quint16 crc = 0xFFFF;
+    while (len--) {
+        const quint8 c = *data++;
+        for (qint32 i = 0x01; i & 0xFF; i <<= 1) {
+            bool bit = crc & 0x8000;
+            if (c & i)
+                bit = !bit;
+            crc <<= 1;
+            if (bit)
+                crc ^= 0x8005;
+        }
+        crc &= 0xFFFF;
+    }
+    crc = crcReflect(crc & 0xFFFF, 16) ^ 0x0000;
+    return (crc >> 8) | (crc << 8); // swap bytes
+}
+
+static QByteArray testData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        data[i] = char(i * 31 + 7);
+    return data;
+}
+
+class tst_Bench_QModbusAdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void crcMatchesReference_data() { sizes(); }
+    void crcMatchesReference()
+    {
+        QFETCH(int, size);
+        const QByteArray data = testData(size);
+        QCOMPARE(QModbusSerialAdu::calculateCRC(data.constData(), data.size()),
+                 bitwiseCRC(data.constData(), data.size()));
+    }
+
+    void bitwiseCrc_data() { sizes(); }
+    void bitwiseCrc()
+    {
+        QFETCH(int, size);
+        const QByteArray data = testData(size);
+        quint16 crc = 0;
+        QBENCHMARK {
+            crc ^= bitwiseCRC(data.constData(), data.size());
+        }
+        Q_UNUSED(crc);
+    }
+
+    void tableCrc_data() { sizes(); }
+    void tableCrc()
+    {
+        QFETCH(int, size);
+        const QByteArray data = testData(size);
+        quint16 crc = 0;
+        QBENCHMARK {
+            crc ^= QModbusSerialAdu::calculateCRC(data.constData(), data.size());
+        }
+        Q_UNUSED(crc);
+    }
+
+    void lrc_data() { sizes(); }
+    void lrc()
+    {
+        QFETCH(int, size);
+        const QByteArray data = testData(size);
+        quint8 lrc = 0;
+        QBENCHMARK {
+            lrc ^= QModbusSerialAdu::calculateLRC(data.constData(), data.size());
+        }
+        Q_UNUSED(lrc);
+    }
+
+private:
+    void sizes()
+    {
+        QTest::addColumn<int>("size");
+
+        // request, typical response and maximum RTU frame without checksum
+        QTest::newRow("8") << 8;
+        QTest::newRow("64") << 64;
+        QTest::newRow("254") << 254;
+    }
+};
+
+QTEST_MAIN(tst_Bench_QModbusAdu)
+
+#include "tst_bench_qmodbusadu.moc"
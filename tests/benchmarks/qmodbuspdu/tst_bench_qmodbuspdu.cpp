@@ -0,0 +1,295 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+
+#include <QtSerialBus/qmodbusclient.h>
+#include <QtSerialBus/qmodbusserver.h>
+
+#include <QtCore/qdatastream.h>
+
+#include <QtTest/QtTest>
+
+Q_DECLARE_METATYPE(QModbusRequest)
+Q_DECLARE_METATYPE(QModbusResponse)
+
+// The QDataStream based encoding used before the compile-time codec, as reference
+template <typename T>
+static void streamValue(QDataStream *stream, const T &t) { (*stream) << t; }
+
+template <typename T>
+static void streamValue(QDataStream *stream, const QList<T> &list)
+{
+    for (const T &t : list)
+        (*stream) << t;
+}
+
+template <typename ... Args>
+static QByteArray dataStreamEncode(Args ... values)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    (streamValue(&stream, values), ...);
+    return data;
+}
+
+template <typename ... Args>
+static void dataStreamDecode(const QByteArray &data, Args ... values)
+{
+    QDataStream stream(data);
+    ((stream >> *values), ...);
+}
+
+class TestServer : public QModbusServer
+{
+public:
+    bool open() override
+    {
+        setState(QModbusDevice::ConnectedState);
+        return true;
+    }
+    void close() override
+    {
+        setState(QModbusDevice::UnconnectedState);
+    }
+    QModbusResponse processRequest(const QModbusPdu &request) override
+    {
+        return QModbusServer::processRequest(request);
+    }
+};
+
+class TestClient : public QModbusClient
+{
+public:
+    bool open() override
+    {
+        setState(QModbusDevice::ConnectedState);
+        return true;
+    }
+    void close() override
+    {
+        setState(QModbusDevice::UnconnectedState);
+    }
+    bool processResponse(const QModbusResponse &response, QModbusDataUnit *data) override
+    {
+        return QModbusClient::processResponse(response, data);
+    }
+};
+
+// Every third value is set, so that the packed bytes are neither all zero nor all one.
+static QList<quint16> testValues(int count, quint16 set)
+{
+    QList<quint16> values(count);
+    for (int i = 0; i < count; ++i)
+        values[i] = (i % 3 == 0) ? set : 0;
+    return values;
+}
+
+static QByteArray packedCoils(const QList<quint16> &values)
+{
+    QByteArray bytes((values.size() + 7) / 8, '\0');
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        if (values.at(i))
+            bytes[i / 8] = char(bytes.at(i / 8) | (1 << (i % 8)));
+    }
+    return bytes;
+}
+
+class tst_Bench_QModbusPdu : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesDataStream();
+
+    void dataStreamEncode();
+    void encodeData();
+    void dataStreamDecode();
+    void decodeData();
+
+    void processRequest_data();
+    void processRequest();
+
+    void processResponse_data();
+    void processResponse();
+
+private:
+    const QList<quint16> m_registers = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+};
+
+void tst_Bench_QModbusPdu::matchesDataStream()
+{
+    const QModbusRequest request(QModbusRequest::WriteMultipleRegisters, quint16(0x1234),
+                                 quint16(10), quint8(20), m_registers);
+    QCOMPARE(request.data(), ::dataStreamEncode(quint16(0x1234), quint16(10), quint8(20),
+                                                m_registers));
+
+    quint16 address = 0;
+    quint16 count = 0;
+    quint8 byteCount = 0;
+    request.decodeData(&address, &count, &byteCount);
+    QCOMPARE(address, 0x1234);
+    QCOMPARE(count, 10);
+    QCOMPARE(byteCount, 20);
+
+    // like QDataStream, reading behind the end yields 0
+    const QModbusRequest shortRequest(QModbusRequest::ReadCoils, quint8(1));
+    address = count = 0xffff;
+    shortRequest.decodeData(&address, &count);
+    quint16 streamAddress = 0xffff;
+    quint16 streamCount = 0xffff;
+    ::dataStreamDecode(shortRequest.data(), &streamAddress, &streamCount);
+    QCOMPARE(address, streamAddress);
+    QCOMPARE(count, streamCount);
+}
+
+void tst_Bench_QModbusPdu::dataStreamEncode()
+{
+    QModbusRequest request(QModbusRequest::ReadHoldingRegisters);
+    QBENCHMARK {
+        request.setData(::dataStreamEncode(quint16(0x1234), quint16(10)));
+    }
+}
+
+void tst_Bench_QModbusPdu::encodeData()
+{
+    QModbusRequest request(QModbusRequest::ReadHoldingRegisters);
+    QBENCHMARK {
+        request.encodeData(quint16(0x1234), quint16(10));
+    }
+}
+
+void tst_Bench_QModbusPdu::dataStreamDecode()
+{
+    const QModbusRequest request(QModbusRequest::ReadHoldingRegisters, quint16(0x1234),
+                                 quint16(10));
+    quint16 address = 0;
+    quint16 count = 0;
+    QBENCHMARK {
+        ::dataStreamDecode(request.data(), &address, &count);
+    }
+    QCOMPARE(count, 10);
+}
+
+void tst_Bench_QModbusPdu::decodeData()
+{
+    const QModbusRequest request(QModbusRequest::ReadHoldingRegisters, quint16(0x1234),
+                                 quint16(10));
+    quint16 address = 0;
+    quint16 count = 0;
+    QBENCHMARK {
+        request.decodeData(&address, &count);
+    }
+    QCOMPARE(count, 10);
+}
+
+void tst_Bench_QModbusPdu::processRequest_data()
+{
+    QTest::addColumn<QModbusRequest>("request");
+
+    QTest::newRow("read coils") << QModbusRequest(QModbusRequest::ReadCoils,
+                                                  quint16(0), quint16(64));
+    QTest::newRow("read holding registers") << QModbusRequest(
+            QModbusRequest::ReadHoldingRegisters, quint16(0), quint16(10));
+    QTest::newRow("write single register") << QModbusRequest(
+            QModbusRequest::WriteSingleRegister, quint16(5), quint16(0xbeef));
+    QTest::newRow("write multiple registers") << QModbusRequest(
+            QModbusRequest::WriteMultipleRegisters, quint16(0), quint16(10), quint8(20),
+            m_registers);
+
+    // the largest payloads the protocol allows
+    QTest::newRow("read 2000 coils") << QModbusRequest(QModbusRequest::ReadCoils,
+                                                       quint16(0), quint16(2000));
+    const QByteArray coils = packedCoils(testValues(1968, 1));
+    QTest::newRow("write 1968 coils") << QModbusRequest(QModbusRequest::WriteMultipleCoils,
+            quint16(0), quint16(1968), quint8(coils.size()),
+            QList<quint8>(coils.cbegin(), coils.cend()));
+    QTest::newRow("read 125 holding registers") << QModbusRequest(
+            QModbusRequest::ReadHoldingRegisters, quint16(0), quint16(125));
+    QTest::newRow("write 123 registers") << QModbusRequest(
+            QModbusRequest::WriteMultipleRegisters, quint16(0), quint16(123), quint8(246),
+            testValues(123, 0xa55a));
+}
+
+void tst_Bench_QModbusPdu::processRequest()
+{
+    QFETCH(QModbusRequest, request);
+
+    TestServer server;
+    QModbusDataUnitMap map;
+    map.insert(QModbusDataUnit::Coils, { QModbusDataUnit::Coils, 0, 2000 });
+    map.insert(QModbusDataUnit::HoldingRegisters, { QModbusDataUnit::HoldingRegisters, 0, 125 });
+    server.setMap(map);
+    server.setData({ QModbusDataUnit::Coils, 0, testValues(2000, 1) });
+    server.setData({ QModbusDataUnit::HoldingRegisters, 0, testValues(125, 0xa55a) });
+
+    QModbusResponse response;
+    QBENCHMARK {
+        response = server.processRequest(request);
+    }
+    QVERIFY(!response.isException());
+}
+
+void tst_Bench_QModbusPdu::processResponse_data()
+{
+    QTest::addColumn<QModbusResponse>("response");
+    QTest::addColumn<QList<quint16>>("values");
+
+    const QList<quint16> coils = testValues(2000, 1);
+    const QByteArray packed = packedCoils(coils);
+    QTest::newRow("2000 coils") << QModbusResponse(QModbusResponse::ReadCoils,
+            quint8(packed.size()), QList<quint8>(packed.cbegin(), packed.cend())) << coils;
+
+    const QList<quint16> registers = testValues(125, 0xa55a);
+    QTest::newRow("125 holding registers") << QModbusResponse(
+            QModbusResponse::ReadHoldingRegisters, quint8(250), registers) << registers;
+}
+
+void tst_Bench_QModbusPdu::processResponse()
+{
+    QFETCH(QModbusResponse, response);
+    QFETCH(QList<quint16>, values);
+
+    TestClient client;
+    QModbusDataUnit unit;
+    QBENCHMARK {
+        QVERIFY(client.processResponse(response, &unit));
+    }
+    QCOMPARE(unit.values(), values);
+}
+
+QTEST_MAIN(tst_Bench_QModbusPdu)
+
+#include "tst_bench_qmodbuspdu.moc"
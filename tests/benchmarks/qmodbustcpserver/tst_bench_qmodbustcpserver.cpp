@@ -0,0 +1,199 @@
+/****************************************************************************
+**
+** Copyright (C) 2021 The Qt Company Ltd.
+** Contact: http://www.qt.io/licensing/
+**
+** This file is part of the QtSerialBus module of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:LGPL3$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see http://www.qt.io/terms-conditions. For further
+** information use the contact form at http://www.qt.io/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 3 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPLv3 included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU Lesser General Public License version 3 requirements
+** will be met: https://www.gnu.org/licenses/lgpl.html.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 2.0 or later as published by the Free
+** Software Foundation and appearing in the file LICENSE.GPL included in
+** the packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 2.0 requirements will be
+** met: http://www.gnu.org/licenses/gpl-2.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtSerialBus/qmodbustcpserver.h>
+
+#include <QtCore/qendian.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qtimer.h>
+#include <QtNetwork/qtcpserver.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include <QtTest/QtTest>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+// Size of a response to a read request for one holding register:
+// MBAP header (7), function code (1), byte count (1) and register value (2).
+static constexpr qsizetype ResponseSize = 11;
+
+static QByteArray readRequestAdu(quint16 transactionId)
+{
+    QByteArray adu(12, Qt::Uninitialized);
+    qToBigEndian<quint16>(transactionId, adu.data());
+    qToBigEndian<quint16>(0, adu.data() + 2);
+    qToBigEndian<quint16>(6, adu.data() + 4);
+    adu[6] = 1; // unit id
+    adu[7] = char(QModbusPdu::ReadHoldingRegisters);
+    qToBigEndian<quint16>(0, adu.data() + 8); // start address
+    qToBigEndian<quint16>(1, adu.data() + 10); // register count
+    return adu;
+}
+
+class tst_Bench_QModbusTcpServer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void requestResponse_data();
+    void requestResponse();
+
+private:
+    QModbusTcpServer m_server;
+    qint64 m_maxOpenFiles = -1;
+};
+
+void tst_Bench_QModbusTcpServer::initTestCase()
+{
+    QModbusDataUnitMap map;
+    map.insert(QModbusDataUnit::HoldingRegisters, { QModbusDataUnit::HoldingRegisters, 0, 10 });
+    m_server.setMap(map);
+
+#ifdef Q_OS_UNIX
+    // Every client needs two descriptors, one for its socket and one for the server side
+    // connection, which exceeds the common default soft limit of 1024. Raise it as far as
+    // the hard limit allows.
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        if (limit.rlim_cur != limit.rlim_max) {
+            rlimit raised = limit;
+            raised.rlim_cur = limit.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &raised) == 0)
+                limit = raised;
+        }
+        if (limit.rlim_cur != RLIM_INFINITY)
+            m_maxOpenFiles = qint64(limit.rlim_cur);
+    }
+#endif
+    m_server.setServerAddress(1);
+    m_server.setConnectionParameter(QModbusDevice::NetworkAddressParameter, "127.0.0.1");
+
+    // QModbusTcpServer does not report the port it listens on, so look for a free one first.
+    QTcpServer probe;
+    QVERIFY(probe.listen(QHostAddress::LocalHost));
+    const quint16 port = probe.serverPort();
+    probe.close();
+    m_server.setConnectionParameter(QModbusDevice::NetworkPortParameter, port);
+    QVERIFY(m_server.connectDevice());
+    QCOMPARE(m_server.state(), QModbusDevice::ConnectedState);
+}
+
+void tst_Bench_QModbusTcpServer::requestResponse_data()
+{
+    QTest::addColumn<int>("clients");
+    QTest::addColumn<int>("pipelined");
+
+    QTest::newRow("1 client, 1 request") << 1 << 1;
+    QTest::newRow("1 client, 16 requests") << 1 << 16;
+    QTest::newRow("100 clients, 1 request") << 100 << 1;
+    QTest::newRow("100 clients, 16 requests") << 100 << 16;
+    QTest::newRow("1000 clients, 1 request") << 1000 << 1;
+    QTest::newRow("1000 clients, 16 requests") << 1000 << 16;
+}
+
+void tst_Bench_QModbusTcpServer::requestResponse()
+{
+    QFETCH(int, clients);
+    QFETCH(int, pipelined);
+
+    // Leave some headroom for the descriptors the test process already holds.
+    if (m_maxOpenFiles >= 0 && m_maxOpenFiles < 2 * qint64(clients) + 64) {
+        QSKIP(qPrintable(QStringLiteral("The open file limit (%1) is too low for %2 clients.")
+                         .arg(m_maxOpenFiles).arg(clients)));
+    }
+
+    const quint16 port = m_server.connectionParameter(QModbusDevice::NetworkPortParameter)
+        .value<quint16>();
+
+    QByteArray requests;
+    for (int i = 0; i < pipelined; ++i)
+        requests += readRequestAdu(quint16(i));
+
+    qsizetype receivedBytes = 0;
+    qsizetype expectedBytes = 0;
+    QEventLoop loop;
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    std::vector<std::unique_ptr<QTcpSocket>> sockets;
+    sockets.reserve(clients);
+    for (int i = 0; i < clients; ++i) {
+        auto socket = std::make_unique<QTcpSocket>();
+        QTcpSocket *s = socket.get();
+        connect(s, &QAbstractSocket::errorOccurred, this, [](QAbstractSocket::SocketError error) {
+            qWarning() << "Client socket error:" << error;
+        });
+        connect(s, &QTcpSocket::readyRead, &loop, [s, &receivedBytes, &expectedBytes, &loop]() {
+            receivedBytes += s->skip(s->bytesAvailable());
+            if (receivedBytes >= expectedBytes)
+                loop.quit();
+        });
+        s->connectToHost(QHostAddress::LocalHost, port);
+        sockets.push_back(std::move(socket));
+    }
+
+    // Let the event loop run, so that the server accepts the connections as they come in.
+    const auto connected = [&sockets]() {
+        return std::all_of(sockets.cbegin(), sockets.cend(), [](const auto &socket) {
+            return socket->state() == QAbstractSocket::ConnectedState;
+        });
+    };
+    QTRY_VERIFY_WITH_TIMEOUT(connected(), 30000);
+
+    QBENCHMARK {
+        receivedBytes = 0;
+        expectedBytes = qsizetype(clients) * pipelined * ResponseSize;
+        for (const auto &socket : sockets)
+            socket->write(requests);
+
+        timeout.start(30000);
+        loop.exec();
+        timeout.stop();
+        QCOMPARE(receivedBytes, expectedBytes);
+    }
+}
+
+QTEST_MAIN(tst_Bench_QModbusTcpServer)
+
+#include "tst_bench_qmodbustcpserver.moc"